@@ -34,6 +34,14 @@
 #define PHY_PAGE_NUM 20
 #define PHY_ADDR 32 // = PHY_PAGE_NUM + PAGE_OFFSET
 
+#define ASID_BITS 7 // address-space identifiers tagging the TLB entries, as many as fit in their spare bits
+#define NB_ASIDS (1 << ASID_BITS)
+
+/**
+ * @brief type representing an address-space identifier (ASID), below NB_ASIDS
+ */
+typedef uint8_t asid_t;
+
 /**
  * @brief type representing a word in memory
  */
@@ -49,6 +57,18 @@ typedef uint8_t byte_t;
  */
 typedef uint32_t pte_t;
 
+/*
+ * The entries point to pages, whose addresses are aligned: their low
+ * PAGE_OFFSET bits hold flags. Memories described before the flags existed
+ * have none, their non-zero entries being present (see pte_is_present()).
+ */
+#define PTE_PRESENT ((pte_t)0x1)   // the entry maps a page (table)
+#define PTE_ACCESSED ((pte_t)0x20) // a walk went through the entry
+#define PTE_DIRTY ((pte_t)0x40)    // the page was written (PTEs only)
+#define PTE_FLAGS ((pte_t)(PAGE_SIZE - 1))
+#define pte_address(PTE) ((PTE) & ~PTE_FLAGS)
+#define pte_is_present(PTE) (((PTE) & PTE_PRESENT) || pte_address(PTE) != 0)
+
 /**
  * @brief type representing a virtual address in memory organized in 4 chunks of 
  * 9 bits a page offset  of 12 bits (shared by the the physical address) 
@@ -81,3 +81,22 @@ int print_virtual_address(FILE* where, const virt_addr_t* vaddr);
  */
 int print_physical_address(FILE* where, const phy_addr_t* paddr);
 
+//=========================================================================
+/**
+ * @brief Inline accessors on raw addresses, for the hot paths that carry
+ *        them along the structures so as not to pack or unpack them again.
+ */
+static inline uint64_t vaddr64_page_number(uint64_t vaddr64)
+{
+    return vaddr64 >> PAGE_OFFSET;
+}
+
+static inline uint16_t vaddr64_page_offset(uint64_t vaddr64)
+{
+    return (uint16_t)(vaddr64 & (PAGE_SIZE - 1));
+}
+
+static inline uint32_t phy_addr_to_uint32(const phy_addr_t *paddr)
+{
+    return ((uint32_t)paddr->phy_page_num << PAGE_OFFSET) | paddr->page_offset;
+}
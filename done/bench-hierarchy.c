@@ -0,0 +1,135 @@
+/**
+ * @file bench-hierarchy.c
+ * @brief micro-benchmarks of the TLB hierarchy, of the caches and of program_read()
+ *
+ * @date 2019
+ */
+#define _POSIX_C_SOURCE 200809L // for mkstemp() and fdopen()
+
+#include "bench_util.h"
+#include "error.h"
+#include "addr_mng.h"
+#include "commands.h"
+#include "page_walk.h"
+#include "tlb_hrchy.h"
+#include "tlb_hrchy_mng.h"
+#include "cache.h"
+#include "cache_mng.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <unistd.h> // for unlink()
+
+static virt_addr_t vaddrs[BENCH_TRACE_LEN];
+static phy_addr_t paddrs[BENCH_TRACE_LEN];
+
+static l1_itlb_entry_t l1_itlb[L1_ITLB_LINES];
+static l1_dtlb_entry_t l1_dtlb[L1_DTLB_LINES];
+static l2_tlb_entry_t l2_tlb[L2_TLB_LINES];
+static l1_dcache_entry_t l1_dcache[L1_DCACHE_LINES * L1_DCACHE_WAYS];
+static l2_cache_entry_t l2_cache[L2_CACHE_LINES * L2_CACHE_WAYS];
+
+// ======================================================================
+/**
+ * @brief Tool function to time program_read() on a text program of the trace
+ *        (reads and writes of words, one line per address).
+ */
+static int bench_program_read(const char *trace)
+{
+    char filename[] = "/tmp/bench-program-XXXXXX";
+    const int fd = mkstemp(filename);
+    M_REQUIRE(fd >= 0, ERR_IO, "cannot create %s", filename);
+    FILE *file = fdopen(fd, "w");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(file, ERR_IO);
+    for (size_t i = 0; i < BENCH_TRACE_LEN; ++i) {
+        const uint64_t vaddr = virt_addr_t_to_uint64_t(&vaddrs[i]);
+        if (i % 4 == 3)
+            fprintf(file, "W DW 0x%08zX @0x%016" PRIX64 "\n", i, vaddr);
+        else
+            fprintf(file, "R DW @0x%016" PRIX64 "\n", vaddr);
+    }
+    fclose(file);
+
+    int err = ERR_NONE;
+    uint64_t ops = 0;
+    const uint64_t start = bench_now_ns();
+    uint64_t elapsed = 0;
+    do {
+        program_t pgm;
+        err = program_read(filename, &pgm);
+        if (err != ERR_NONE)
+            break;
+        ops += pgm.nb_lines;
+        (void)program_free(&pgm);
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+    unlink(filename);
+    if (err == ERR_NONE)
+        bench_report("program_read", NULL, trace, ops, elapsed);
+    return err;
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    bench_region_t region;
+    if (bench_region_init(argc, argv, &region) != ERR_NONE) {
+        fprintf(stderr, "usage: %s [mem_description base_vaddr nb_pages]\n", argv[0]);
+        return 1;
+    }
+
+    volatile uint32_t sink = 0; // keeps the results alive
+    for (int kind = 0; kind < NB_TRACES; ++kind) {
+        const char *trace = BENCH_TRACE_NAMES[kind];
+        if (bench_trace_fill(&region, kind, vaddrs) != ERR_NONE) {
+            fprintf(stderr, "cannot build the %s trace\n", trace);
+            return 2;
+        }
+        for (size_t i = 0; i < BENCH_TRACE_LEN; ++i) {
+            if (page_walk(&region.walker, &vaddrs[i], &paddrs[i]) != ERR_NONE) {
+                fprintf(stderr, "address %zu of the %s trace is not mapped\n", i, trace);
+                return 2;
+            }
+        }
+        phy_addr_t paddr;
+
+        int hit = 0;
+        tlb_flush(l1_itlb, L1_ITLB);
+        tlb_flush(l1_dtlb, L1_DTLB);
+        tlb_flush(l2_tlb, L2_TLB);
+        BENCH_RUN("tlb_search", "hrchy", trace, i,
+                  tlb_search(&region.walker, &vaddrs[i], 0, &paddr, DATA, l1_itlb, l1_dtlb, l2_tlb, &hit);
+                  sink += (uint32_t)hit);
+
+        BENCH_RUN("tlb_hit", "hrchy", trace, i,
+                  sink += (uint32_t)tlb_hit(&vaddrs[i], 0, &paddr, l2_tlb, L2_TLB));
+
+        word_t word = 0;
+        cache_flush(l1_dcache, L1_DCACHE);
+        cache_flush(l2_cache, L2_CACHE);
+        BENCH_RUN("cache_read", "hrchy", trace, i,
+                  cache_read(region.mem_space, &paddrs[i], DATA, l1_dcache, l2_cache, &word, LRU);
+                  sink += word);
+
+        const uint32_t *p_line = NULL;
+        uint8_t hit_way = 0;
+        uint16_t hit_index = 0;
+        BENCH_RUN("cache_hit", "hrchy", trace, i,
+                  cache_hit(region.mem_space, l1_dcache, &paddrs[i], &p_line, &hit_way, &hit_index, L1_DCACHE);
+                  sink += hit_way);
+
+        BENCH_RUN("cache_write", "hrchy", trace, i,
+                  word = (word_t)i;
+                  cache_write(region.mem_space, &paddrs[i], l1_dcache, l2_cache, &word, LRU));
+
+        if (bench_program_read(trace) != ERR_NONE) {
+            fprintf(stderr, "cannot read the %s program\n", trace);
+            return 2;
+        }
+    }
+
+    (void)sink;
+    free(region.mem_space);
+    return 0;
+}
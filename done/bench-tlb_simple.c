@@ -0,0 +1,117 @@
+/**
+ * @file bench-tlb_simple.c
+ * @brief micro-benchmarks of the page walk and of the fully-associative TLB
+ *
+ * Kept apart from bench-hierarchy.c since both TLB implementations
+ * define the same function names.
+ *
+ * Besides the original LRU list ("simple", TLB_POLICY_LIST on a list of
+ * our own), each other replacement policy of tlb_policy.h is timed, and its hit rate reported on a line of its own:
+ *   bench=tlb_hit_rate impl=clock trace=zipf ops=65536 hits=60211
+ * The policies only differ on a region of more pages than TLB_LINES, as the
+ * default one (see BENCH_DEFAULT_PAGES).
+ *
+ * @date 2019
+ */
+
+#include "bench_util.h"
+#include "error.h"
+#include "list.h"
+#include "page_walk.h"
+#include "tlb.h"
+#include "tlb_mng.h"
+#include "tlb_policy.h"
+
+#include <inttypes.h> // for PRIu64
+#include <stdio.h>
+#include <stdlib.h>
+
+static virt_addr_t vaddrs[BENCH_TRACE_LEN];
+static tlb_entry_t tlb[TLB_LINES];
+
+static const tlb_policy_ops_t *const policies[] = {&TLB_POLICY_LRU, &TLB_POLICY_CLOCK, &TLB_POLICY_RANDOM, &TLB_POLICY_FIFO};
+#define NB_POLICIES (sizeof(policies) / sizeof(policies[0]))
+
+//=========================================================================
+/**
+ * @brief Tool function to count the hits of one pass over a trace, from an empty TLB.
+ */
+static uint64_t count_hits(const bench_region_t *region, replacement_policy_t *policy)
+{
+    uint64_t hits = 0;
+    phy_addr_t paddr;
+    tlb_flush(tlb);
+    for (size_t i = 0; i < BENCH_TRACE_LEN; ++i)
+    {
+        int hit = 0;
+        (void)tlb_search(&region->walker, &vaddrs[i], 0, &paddr, tlb, policy, &hit);
+        hits += (uint64_t)hit;
+    }
+    return hits;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_region_t region;
+    if (bench_region_init(argc, argv, &region) != ERR_NONE) {
+        fprintf(stderr, "usage: %s [mem_description base_vaddr nb_pages]\n", argv[0]);
+        return 1;
+    }
+
+    list_t ll;
+    init_list(&ll);
+    for (list_content_t i = 0; i < TLB_LINES; ++i)
+        (void)push_back(&ll, &i);
+    replacement_policy_t replacement_policy = {
+        .ll = &ll,
+        .move_back = move_back,
+        .push_back = push_back
+    };
+    if (tlb_policy_init(&replacement_policy, &TLB_POLICY_LIST) != ERR_NONE) {
+        fprintf(stderr, "cannot initialise the %s policy\n", TLB_POLICY_LIST.name);
+        return 3;
+    }
+
+    volatile uint32_t sink = 0; // keeps the results alive
+    for (int kind = 0; kind < NB_TRACES; ++kind) {
+        const char *trace = BENCH_TRACE_NAMES[kind];
+        if (bench_trace_fill(&region, kind, vaddrs) != ERR_NONE) {
+            fprintf(stderr, "cannot build the %s trace\n", trace);
+            return 2;
+        }
+        phy_addr_t paddr;
+
+        BENCH_RUN("page_walk", NULL, trace, i,
+                  page_walk(&region.walker, &vaddrs[i], &paddr); sink += paddr.phy_page_num);
+
+        int hit = 0;
+        tlb_flush(tlb);
+        BENCH_RUN("tlb_search", "simple", trace, i,
+                  tlb_search(&region.walker, &vaddrs[i], 0, &paddr, tlb, &replacement_policy, &hit); sink += (uint32_t)hit);
+
+        // the TLB is now warm with the last addresses of the trace
+        BENCH_RUN("tlb_hit", "simple", trace, i,
+                  sink += (uint32_t)tlb_hit(&vaddrs[i], 0, &paddr, tlb, &replacement_policy));
+
+        for (size_t p = 0; p < NB_POLICIES; ++p) {
+            replacement_policy_t policy = {NULL};
+            if (tlb_policy_init(&policy, policies[p]) != ERR_NONE) {
+                fprintf(stderr, "cannot initialise the %s policy\n", policies[p]->name);
+                return 3;
+            }
+            const uint64_t hits = count_hits(&region, &policy); // from the initial state of the policy
+            tlb_flush(tlb);
+            BENCH_RUN("tlb_search", policies[p]->name, trace, i,
+                      tlb_search(&region.walker, &vaddrs[i], 0, &paddr, tlb, &policy, &hit); sink += (uint32_t)hit);
+            printf("bench=tlb_hit_rate impl=%s trace=%s ops=%d hits=%" PRIu64 "\n",
+                   policies[p]->name, trace, BENCH_TRACE_LEN, hits);
+            tlb_policy_free(&policy);
+        }
+    }
+
+    (void)sink;
+    tlb_policy_free(&replacement_policy);
+    clear_list(&ll);
+    free(region.mem_space);
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file bench_util.c
+ * @brief tool functions shared by the micro-benchmarks
+ *
+ * @date 2019
+ */
+#define _POSIX_C_SOURCE 199309L // for clock_gettime()
+
+#include "bench_util.h"
+#include "addr_mng.h"
+#include "memory.h"
+#include "error.h"
+#include "trace_gen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+
+const char *const BENCH_TRACE_NAMES[NB_TRACES] = {"sequential", "strided", "random", "zipf"};
+
+int bench_region_init(int argc, char *argv[], bench_region_t *region)
+{
+    M_REQUIRE_NON_NULL(region);
+    M_REQUIRE(argc == 1 || argc == 4, ERR_BAD_PARAMETER, "%d arguments", argc - 1);
+    region->base = argc > 1 ? strtoull(argv[2], NULL, 0) : BENCH_DEFAULT_BASE;
+    region->nb_pages = argc > 1 ? strtoul(argv[3], NULL, 0) : BENCH_DEFAULT_PAGES;
+    M_REQUIRE(region->base % PAGE_SIZE == 0, ERR_ADDR, "region base 0x%" PRIx64 " is not page aligned", region->base);
+    M_REQUIRE(region->nb_pages > 0, ERR_SIZE, "empty region %s", "");
+    if (argc > 1)
+    {
+        M_EXIT_IF_ERR(mem_init_from_description(argv[1], &region->mem_space, &region->mem_size), "loading the memory");
+    }
+    else
+    {
+        gen_config_t config;
+        M_EXIT_IF_ERR(gen_config_init(&config, GEN_SEQUENTIAL), "configuring the generator");
+        config.base = region->base;
+        config.nb_pages = region->nb_pages;
+        M_EXIT_IF_ERR(gen_build_memory(&config, &region->mem_space, &region->mem_size), "building the memory");
+    }
+    return page_walker_init(&region->walker, region->mem_space, region->mem_size, 0);
+}
+
+int bench_trace_fill(const bench_region_t *region, enum bench_trace kind, virt_addr_t *vaddrs)
+{
+    M_REQUIRE_NON_NULL(region);
+    M_REQUIRE_NON_NULL(vaddrs);
+    static const gen_pattern_t patterns[NB_TRACES] = {GEN_SEQUENTIAL, GEN_STRIDE, GEN_RANDOM, GEN_ZIPF};
+    M_REQUIRE(kind < NB_TRACES, ERR_BAD_PARAMETER, "unknown trace kind %d", kind);
+
+    gen_config_t config;
+    M_EXIT_IF_ERR(gen_config_init(&config, patterns[kind]), "configuring the generator");
+    config.base = region->base;
+    config.nb_pages = region->nb_pages;
+    config.nb_commands = BENCH_TRACE_LEN;
+    config.zipf_s = BENCH_ZIPF_S;
+    config.write_percent = 0;
+    config.seed = BENCH_SEED + (uint64_t)kind;
+    gen_t gen;
+    M_EXIT_IF_ERR(gen_init(&gen, &config), "initialising the generator");
+    command_t command;
+    int err = ERR_NONE;
+    for (size_t i = 0; err == ERR_NONE && i < BENCH_TRACE_LEN; ++i)
+    {
+        err = gen_next(&gen, &command);
+        vaddrs[i] = command.vaddr;
+    }
+    gen_free(&gen);
+    return err;
+}
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+void bench_report(const char *bench, const char *impl, const char *trace, uint64_t ops, uint64_t ns)
+{
+    const double ns_per_op = ns == 0 ? 0.0 : (double)ns / (double)ops;
+    printf("bench=%s impl=%s trace=%s ops=%" PRIu64 " ns_per_op=%.2f ops_per_s=%.0f\n",
+           bench, impl == NULL ? "-" : impl, trace, ops, ns_per_op, ns_per_op == 0.0 ? 0.0 : 1e9 / ns_per_op);
+    fflush(stdout);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+/**
+ * @file bench_util.h
+ * @brief tool functions shared by the micro-benchmarks: synthetic address
+ *        traces with fixed seeds, timing and machine-readable reports
+ *
+ * Every report is one line of space-separated key=value pairs, e.g.
+ *   bench=cache_read impl=hrchy trace=zipf ops=1048576 ns_per_op=41.27 ops_per_s=24231000
+ *
+ * @date 2019
+ */
+
+#include "addr.h"
+#include "page_walk.h" // for page_walker_t
+
+#include <stdint.h>
+#include <stddef.h> // for size_t
+
+#define BENCH_TRACE_LEN  (1 << 16) // number of addresses of a trace
+#define BENCH_SEED       0x5eed2019ULL
+#define BENCH_MIN_NS     50000000ULL // each benchmark repeats its trace for at least 50 ms
+#define BENCH_ZIPF_S     0.99        // exponent of the Zipf distribution
+
+// default region: consecutive virtual pages at 0x8000000000, mapped in a memory
+// built by the trace generator; more pages than the TLBs have entries (128 for
+// the fully-associative one), so that the traces also time the replacements
+#define BENCH_DEFAULT_BASE  0x8000000000ULL
+#define BENCH_DEFAULT_PAGES 512
+
+/**
+ * @brief the kinds of synthetic traces
+ */
+enum bench_trace
+{
+    TRACE_SEQUENTIAL, // consecutive words
+    TRACE_STRIDED,    // one word per page and cache set, page after page
+    TRACE_RANDOM,     // uniformly distributed words
+    TRACE_ZIPF,       // Zipf-distributed cache lines, the hot ones scattered over the region
+    NB_TRACES
+};
+
+extern const char *const BENCH_TRACE_NAMES[NB_TRACES];
+
+/**
+ * @brief a virtual region with its pages mapped in a memory
+ */
+typedef struct
+{
+    void *mem_space;
+    size_t mem_size;
+    page_walker_t walker; // the page tables of the memory, from 0
+    uint64_t base;    // first virtual address of the region, page aligned
+    size_t nb_pages;
+} bench_region_t;
+
+//=========================================================================
+/**
+ * @brief Load the memory of the benchmarks and describe the region the traces cover.
+ *
+ * Command line: [mem_description base_vaddr nb_pages]. Without arguments, the
+ * region is the BENCH_DEFAULT_PAGES pages from BENCH_DEFAULT_BASE, in a memory
+ * of its own (see gen_build_memory()).
+ *
+ * @param argc number of command-line arguments
+ * @param argv command-line arguments
+ * @param region (modified) the region to initialize
+ * @return error code
+ */
+int bench_region_init(int argc, char *argv[], bench_region_t *region);
+
+//=========================================================================
+/**
+ * @brief Fill an array with BENCH_TRACE_LEN word-aligned virtual addresses of a region,
+ *        drawn by the trace generator (see trace_gen.h).
+ *
+ * The same kind of trace on the same region always gives the same addresses.
+ *
+ * @param region the region to cover
+ * @param kind the kind of trace
+ * @param vaddrs (modified) the BENCH_TRACE_LEN addresses
+ * @return error code
+ */
+int bench_trace_fill(const bench_region_t *region, enum bench_trace kind, virt_addr_t *vaddrs);
+
+//=========================================================================
+/**
+ * @brief Current time, from a monotonic clock, in nanoseconds.
+ */
+uint64_t bench_now_ns(void);
+
+//=========================================================================
+/**
+ * @brief Print one benchmark result to stdout.
+ * @param bench name of the benchmarked function
+ * @param impl which implementation (e.g. "simple" or "hrchy"), may be NULL
+ * @param trace name of the trace
+ * @param ops number of operations performed
+ * @param ns total time taken, in nanoseconds
+ */
+void bench_report(const char *bench, const char *impl, const char *trace, uint64_t ops, uint64_t ns);
+
+/**
+ * @brief Time BODY, executed once per element of a trace of BENCH_TRACE_LEN
+ *        elements (index I), repeating the trace for at least BENCH_MIN_NS,
+ *        then report the result.
+ */
+#define BENCH_RUN(NAME, IMPL, TRACE, I, BODY)                                   \
+    do                                                                          \
+    {                                                                           \
+        uint64_t ops_ = 0;                                                      \
+        const uint64_t start_ = bench_now_ns();                                 \
+        uint64_t elapsed_ = 0;                                                  \
+        do                                                                      \
+        {                                                                       \
+            for (size_t I = 0; I < BENCH_TRACE_LEN; ++I)                        \
+            {                                                                   \
+                BODY;                                                           \
+            }                                                                   \
+            ops_ += BENCH_TRACE_LEN;                                            \
+            elapsed_ = bench_now_ns() - start_;                                 \
+        } while (elapsed_ < BENCH_MIN_NS);                                      \
+        bench_report(NAME, IMPL, TRACE, ops_, elapsed_);                        \
+    } while (0)
@@ -12,6 +12,7 @@
 
 #include "addr.h" // for word_t
 #include <stdint.h>
+#include <stddef.h> // for offsetof()
 
 #define L1_ICACHE_WORDS_PER_LINE 4
 #define L1_ICACHE_LINE   16u // 16 bytes (4 words) per line
@@ -96,11 +97,22 @@
         cache_entry(TYPE, WAYS, LINE_INDEX, WAY)->line
 
 
+/*
+ * The valid bit, the age and the tag of an entry share its first 32-bit word,
+ * head, so that a hit check is one masked compare of head (see cache_entry_hit()).
+ */
 typedef struct
 {
-    uint8_t v : 1;
-    uint8_t age : L1_ICACHE_WAYS_BITS;
-    uint32_t tag : L1_ICACHE_TAG_BITS;
+    union
+    {
+        struct
+        {
+            uint8_t v : 1;
+            uint8_t age : L1_ICACHE_WAYS_BITS;
+            uint32_t tag : L1_ICACHE_TAG_BITS;
+        };
+        uint32_t head;
+    };
     word_t line [L1_ICACHE_WORDS_PER_LINE];
 }l1_icache_entry_t;
 
@@ -108,10 +120,45 @@ typedef l1_icache_entry_t l1_dcache_entry_t;
 
 typedef struct
 {
-    uint8_t v : 1;
-    uint8_t age : L2_CACHE_WAYS_BITS;
-    uint32_t tag : L2_CACHE_TAG_BITS;
+    union
+    {
+        struct
+        {
+            uint8_t v : 1;
+            uint8_t age : L2_CACHE_WAYS_BITS;
+            uint32_t tag : L2_CACHE_TAG_BITS;
+        };
+        uint32_t head;
+    };
     word_t line [L2_CACHE_WORDS_PER_LINE];
 }l2_cache_entry_t;
 
+_Static_assert(offsetof(l1_icache_entry_t, line) == sizeof(uint32_t), "v, age and tag must fit in head");
+_Static_assert(offsetof(l2_cache_entry_t, line) == sizeof(uint32_t), "v, age and tag must fit in head");
+
+// the head of a valid entry of the given tag, all other bits (age included) at 0
+#define define_cache_key(NAME, TYPE) \
+    static inline uint32_t NAME(uint32_t tag) \
+    {                                         \
+        TYPE entry;                           \
+        entry.head = 0;                       \
+        entry.tag = tag;                      \
+        entry.v = 1;                          \
+        return entry.head;                    \
+    }
+define_cache_key(l1_cache_key, l1_icache_entry_t)
+define_cache_key(l2_cache_key, l2_cache_entry_t)
+#undef define_cache_key
+
+/**
+ * @brief hit check of an entry of the given tag; KEY is l1_cache_key or l2_cache_key
+ * and TAG_BITS the number of bits of the tag
+ */
+#ifndef BITFIELD_ENTRIES
+#define cache_entry_hit(ENTRY, TAG, KEY, TAG_BITS) \
+    (((ENTRY)->head & KEY((uint32_t)((UINT64_C(1) << (TAG_BITS)) - 1))) == KEY(TAG))
+#else // field by field, as before the entries were packed (make BITFIELD_ENTRIES=1 to benchmark it)
+#define cache_entry_hit(ENTRY, TAG, KEY, TAG_BITS) ((ENTRY)->v == 1 && (ENTRY)->tag == (TAG))
+#endif
+
 typedef enum  {L1_ICACHE, L1_DCACHE, L2_CACHE}cache_t;
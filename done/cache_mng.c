@@ -14,106 +14,183 @@
 #include "cache_mng.h"
 #include "lru.h"
 #include "page_walk.h"
+#include "heatmap.h"
+#include "dump_buf.h"
 #include <inttypes.h> // for PRIx macros
+#include <string.h>   // for memcpy()
 
 //=========================================================================
-#define PRINT_CACHE_LINE(OUTFILE, TYPE, WAYS, LINE_INDEX, WAY, WORDS_PER_LINE)                 \
+// the lines are rendered in a buffer (see dump_buf.h), written as it fills up
+#define PRINT_CACHE_LINE(BUF, TYPE, WAYS, LINE_INDEX, WAY, WORDS_PER_LINE)                     \
     do                                                                                         \
     {                                                                                          \
-        fprintf(OUTFILE, "V: %1" PRIx8 ", AGE: %1" PRIx8 ", TAG: 0x%03" PRIx16 ", values: ( ", \
-                cache_valid(TYPE, WAYS, LINE_INDEX, WAY),                                      \
-                cache_age(TYPE, WAYS, LINE_INDEX, WAY),                                        \
-                cache_tag(TYPE, WAYS, LINE_INDEX, WAY));                                       \
+        dump_buf_puts(BUF, "V: ");                                                             \
+        dump_buf_hex(BUF, cache_valid(TYPE, WAYS, LINE_INDEX, WAY), 1, dump_hex_lower);        \
+        dump_buf_puts(BUF, ", AGE: ");                                                         \
+        dump_buf_hex(BUF, cache_age(TYPE, WAYS, LINE_INDEX, WAY), 1, dump_hex_lower);          \
+        dump_buf_puts(BUF, ", TAG: 0x");                                                       \
+        dump_buf_hex(BUF, cache_tag(TYPE, WAYS, LINE_INDEX, WAY), 3, dump_hex_lower);          \
+        dump_buf_puts(BUF, ", values: ( ");                                                    \
         for (int i_ = 0; i_ < WORDS_PER_LINE; i_++)                                            \
-            fprintf(OUTFILE, "0x%08" PRIx32 " ",                                               \
-                    cache_line(TYPE, WAYS, LINE_INDEX, WAY)[i_]);                              \
-        fputs(")\n", OUTFILE);                                                                 \
+        {                                                                                      \
+            dump_buf_puts(BUF, "0x");                                                          \
+            dump_buf_hex(BUF, cache_line(TYPE, WAYS, LINE_INDEX, WAY)[i_], 8, dump_hex_lower); \
+            dump_buf_putc(BUF, ' ');                                                           \
+        }                                                                                      \
+        dump_buf_puts(BUF, ")\n");                                                             \
     } while (0)
 
-#define PRINT_INVALID_CACHE_LINE(OUTFILE, TYPE, WAYS, LINE_INDEX, WAY, WORDS_PER_LINE)                                    \
-    do                                                                                                                    \
-    {                                                                                                                     \
-        fprintf(OUTFILE, "V: %1" PRIx8 ", AGE: -, TAG: -----, values: ( ---------- ---------- ---------- ---------- )\n", \
-                cache_valid(TYPE, WAYS, LINE_INDEX, WAY));                                                                \
+#define PRINT_INVALID_CACHE_LINE(BUF, TYPE, WAYS, LINE_INDEX, WAY, WORDS_PER_LINE)                             \
+    do                                                                                                         \
+    {                                                                                                          \
+        dump_buf_puts(BUF, "V: ");                                                                             \
+        dump_buf_hex(BUF, cache_valid(TYPE, WAYS, LINE_INDEX, WAY), 1, dump_hex_lower);                        \
+        dump_buf_puts(BUF, ", AGE: -, TAG: -----, values: ( ---------- ---------- ---------- ---------- )\n"); \
     } while (0)
 
-#define DUMP_CACHE_TYPE(OUTFILE, TYPE, WAYS, LINES, WORDS_PER_LINE)                                  \
+// the "WAY/LINE: " prefix of an entry
+#define PRINT_CACHE_POSITION(BUF, WAY, LINE_INDEX)        \
+    do                                                    \
+    {                                                     \
+        dump_buf_hex(BUF, WAY, 2, dump_hex_lower);        \
+        dump_buf_putc(BUF, '/');                          \
+        dump_buf_hex(BUF, LINE_INDEX, 4, dump_hex_lower); \
+        dump_buf_puts(BUF, ": ");                         \
+    } while (0)
+
+#define DUMP_CACHE_TYPE(BUF, TYPE, WAYS, LINES, WORDS_PER_LINE)                                  \
+    do                                                                                           \
+    {                                                                                            \
+        for (uint16_t index = 0; index < LINES; index++)                                         \
+        {                                                                                        \
+            foreach_way(way, WAYS)                                                               \
+            {                                                                                    \
+                PRINT_CACHE_POSITION(BUF, way, index);                                           \
+                if (cache_valid(TYPE, WAYS, index, way))                                         \
+                    PRINT_CACHE_LINE(BUF, const TYPE, WAYS, index, way, WORDS_PER_LINE);         \
+                else                                                                             \
+                    PRINT_INVALID_CACHE_LINE(BUF, const TYPE, WAYS, index, way, WORDS_PER_LINE); \
+            }                                                                                    \
+        }                                                                                        \
+    } while (0)
+
+//=========================================================================
+// see cache_mng.h
+int cache_dump(FILE *output, const void *cache, cache_t cache_type)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(cache);
+
+    dump_buf_t buf;
+    dump_buf_init(&buf, output);
+    dump_buf_puts(&buf, "WAY/LINE: V: AGE: TAG: WORDS\n");
+    switch (cache_type)
+    {
+    case L1_ICACHE:
+        DUMP_CACHE_TYPE(&buf, l1_icache_entry_t, L1_ICACHE_WAYS,
+                        L1_ICACHE_LINES, L1_ICACHE_WORDS_PER_LINE);
+        break;
+    case L1_DCACHE:
+        DUMP_CACHE_TYPE(&buf, l1_dcache_entry_t, L1_DCACHE_WAYS,
+                        L1_DCACHE_LINES, L1_DCACHE_WORDS_PER_LINE);
+        break;
+    case L2_CACHE:
+        DUMP_CACHE_TYPE(&buf, l2_cache_entry_t, L2_CACHE_WAYS,
+                        L2_CACHE_LINES, L2_CACHE_WORDS_PER_LINE);
+        break;
+    default:
+        dump_buf_flush(&buf);
+        debug_print("%d: unknown cache type", cache_type);
+        return ERR_BAD_PARAMETER;
+    }
+    dump_buf_putc(&buf, '\n');
+    dump_buf_flush(&buf);
+
+    return ERR_NONE;
+}
+
+// an entry is printed again only if it differs from its copy at the previous dump,
+// all invalid entries being the same as they are printed the same way
+#define DUMP_CHANGED_CACHE_TYPE(BUF, TYPE, WAYS, LINES, WORDS_PER_LINE)                              \
     do                                                                                               \
     {                                                                                                \
+        TYPE *prev_ = previous;                                                                      \
         for (uint16_t index = 0; index < LINES; index++)                                             \
         {                                                                                            \
             foreach_way(way, WAYS)                                                                   \
             {                                                                                        \
-                fprintf(output, "%02" PRIx8 "/%04" PRIx16 ": ", way, index);                         \
-                if (cache_valid(TYPE, WAYS, index, way))                                             \
-                    PRINT_CACHE_LINE(OUTFILE, const TYPE, WAYS, index, way, WORDS_PER_LINE);         \
-                else                                                                                 \
-                    PRINT_INVALID_CACHE_LINE(OUTFILE, const TYPE, WAYS, index, way, WORDS_PER_LINE); \
+                const TYPE *entry_ = cache_entry(const TYPE, WAYS, index, way);                      \
+                TYPE *old_ = prev_ + index * (WAYS) + way;                                           \
+                if ((entry_->v || old_->v) && memcmp(entry_, old_, sizeof(TYPE)))                    \
+                {                                                                                    \
+                    PRINT_CACHE_POSITION(BUF, way, index);                                           \
+                    if (entry_->v)                                                                   \
+                        PRINT_CACHE_LINE(BUF, const TYPE, WAYS, index, way, WORDS_PER_LINE);         \
+                    else                                                                             \
+                        PRINT_INVALID_CACHE_LINE(BUF, const TYPE, WAYS, index, way, WORDS_PER_LINE); \
+                    *old_ = *entry_;                                                                 \
+                }                                                                                    \
             }                                                                                        \
         }                                                                                            \
     } while (0)
 
 //=========================================================================
 // see cache_mng.h
-int cache_dump(FILE *output, const void *cache, cache_t cache_type)
+int cache_dump_delta(FILE *output, const void *cache, void *previous, cache_t cache_type)
 {
     M_REQUIRE_NON_NULL(output);
     M_REQUIRE_NON_NULL(cache);
+    M_REQUIRE_NON_NULL(previous);
 
-    fputs("WAY/LINE: V: AGE: TAG: WORDS\n", output);
+    dump_buf_t buf;
+    dump_buf_init(&buf, output);
+    dump_buf_puts(&buf, "WAY/LINE: V: AGE: TAG: WORDS\n");
     switch (cache_type)
     {
     case L1_ICACHE:
-        DUMP_CACHE_TYPE(output, l1_icache_entry_t, L1_ICACHE_WAYS,
-                        L1_ICACHE_LINES, L1_ICACHE_WORDS_PER_LINE);
+        DUMP_CHANGED_CACHE_TYPE(&buf, l1_icache_entry_t, L1_ICACHE_WAYS,
+                                L1_ICACHE_LINES, L1_ICACHE_WORDS_PER_LINE);
         break;
     case L1_DCACHE:
-        DUMP_CACHE_TYPE(output, l1_dcache_entry_t, L1_DCACHE_WAYS,
-                        L1_DCACHE_LINES, L1_DCACHE_WORDS_PER_LINE);
+        DUMP_CHANGED_CACHE_TYPE(&buf, l1_dcache_entry_t, L1_DCACHE_WAYS,
+                                L1_DCACHE_LINES, L1_DCACHE_WORDS_PER_LINE);
         break;
     case L2_CACHE:
-        DUMP_CACHE_TYPE(output, l2_cache_entry_t, L2_CACHE_WAYS,
-                        L2_CACHE_LINES, L2_CACHE_WORDS_PER_LINE);
+        DUMP_CHANGED_CACHE_TYPE(&buf, l2_cache_entry_t, L2_CACHE_WAYS,
+                                L2_CACHE_LINES, L2_CACHE_WORDS_PER_LINE);
         break;
     default:
+        dump_buf_flush(&buf);
         debug_print("%d: unknown cache type", cache_type);
         return ERR_BAD_PARAMETER;
     }
-    putc('\n', output);
+    dump_buf_putc(&buf, '\n');
+    dump_buf_flush(&buf);
 
     return ERR_NONE;
 }
 
 #define SEL_BYTE 2
-#define MASK_TWO_BITS 0b11
 #define MASK_THREE_BITS 0b111
 #define WORDS_PER_LINE L1_DCACHE_WORDS_PER_LINE
-#define BYTE_MASK 0b11111111
-#define BITS_IN_BYTE 8
-#define MASK_LINE_INDEX_L1 0b111111
 #define LINE_INDEX_L1_BITS 6
 static inline uint32_t getPhaddr(const phy_addr_t *paddr) //helper method to get Physical address as 32 uint
 {
     return ((paddr->phy_page_num << PAGE_OFFSET) | paddr->page_offset);
 }
-int cache_entry_init(const void *mem_space,
-                     const phy_addr_t *paddr,
-                     void *cache_entry,
-                     cache_t cache_type)
+// cache_entry_init() on a raw physical address
+static int entry_init_at(const void *mem_space, uint32_t phaddr, void *cache_entry, cache_t cache_type)
 {
 
 #define init(type, nbBits, LINES, WORDS_PER_LINE)  \
+    ((type *)cache_entry)->head = 0;               \
     ((type *)cache_entry)->v = 1;                  \
-    uint32_t phaddr = getPhaddr(paddr);            \
     ((type *)cache_entry)->tag = phaddr >> nbBits; \
     ((type *)cache_entry)->age = 0;                \
     uint32_t off = phaddr - (phaddr % LINES);      \
     uint32_t index = off / WORDS_PER_LINE;         \
     for (size_t i = 0; i < WORDS_PER_LINE; ++i)    \
         ((type *)cache_entry)->line[i] = *((word_t *)mem_space + index + i);
-    M_REQUIRE_NON_NULL(mem_space);
-    M_REQUIRE_NON_NULL(paddr);
-    M_REQUIRE_NON_NULL(cache_entry);
     switch (cache_type)
     {
     case L1_ICACHE:
@@ -137,6 +214,17 @@ int cache_entry_init(const void *mem_space,
     return ERR_NONE;
 }
 
+int cache_entry_init(const void *mem_space,
+                     const phy_addr_t *paddr,
+                     void *cache_entry,
+                     cache_t cache_type)
+{
+    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE_NON_NULL(paddr);
+    M_REQUIRE_NON_NULL(cache_entry);
+    return entry_init_at(mem_space, getPhaddr(paddr), cache_entry, cache_type);
+}
+
 int cache_flush(void *cache, cache_t cache_type)
 {
 #define flush(type, nbLines)                                          \
@@ -207,28 +295,16 @@ int cache_insert(uint16_t cache_line_index,
     return ERR_NONE;
 }
 
-int cache_hit(const void *mem_space,
-              void *cache,
-              phy_addr_t *paddr,
-              const uint32_t **p_line,
-              uint8_t *hit_way,
-              uint16_t *hit_index,
-              cache_t cache_type)
+// cache_hit() on a raw physical address
+static int hit_at(void *cache, uint32_t phaddr, const uint32_t **p_line,
+                  uint8_t *hit_way, uint16_t *hit_index, cache_t cache_type)
 {
-    M_REQUIRE_NON_NULL(mem_space);
-    M_REQUIRE_NON_NULL(cache);
-    M_REQUIRE_NON_NULL(p_line);
-    M_REQUIRE_NON_NULL(paddr);
-    M_REQUIRE_NON_NULL(hit_index);
-    M_REQUIRE_NON_NULL(hit_way);
-
-    uint32_t phaddr = getPhaddr(paddr);
-#define hit(TYPE, WORDS_PER_LINE, LINES, REMAINING_BITS, WAYS)                                        \
+#define hit(TYPE, WORDS_PER_LINE, LINES, REMAINING_BITS, WAYS, KEY)                                   \
     uint32_t index = (phaddr / (WORDS_PER_LINE * sizeof(word_t))) % LINES;                            \
     uint32_t tag = phaddr >> REMAINING_BITS;                                                          \
     foreach_way(way, WAYS)                                                                            \
     {                                                                                                 \
-        if ((cache_valid(TYPE, WAYS, index, way) == 1) && (cache_tag(TYPE, WAYS, index, way) == tag)) \
+        if (cache_entry_hit(cache_entry(TYPE, WAYS, index, way), tag, KEY, 32 - REMAINING_BITS))      \
         {                                                                                             \
             *hit_way = way;                                                                           \
             *hit_index = index;                                                                       \
@@ -245,17 +321,17 @@ int cache_hit(const void *mem_space,
     {
     case L1_ICACHE:
     {
-        hit(l1_icache_entry_t, L1_ICACHE_WORDS_PER_LINE, L1_ICACHE_LINES, L1_ICACHE_TAG_REMAINING_BITS, L1_ICACHE_WAYS);
+        hit(l1_icache_entry_t, L1_ICACHE_WORDS_PER_LINE, L1_ICACHE_LINES, L1_ICACHE_TAG_REMAINING_BITS, L1_ICACHE_WAYS, l1_cache_key);
     }
     break;
     case L1_DCACHE:
     {
-        hit(l1_dcache_entry_t, L1_DCACHE_WORDS_PER_LINE, L1_DCACHE_LINES, L1_DCACHE_TAG_REMAINING_BITS, L1_DCACHE_WAYS);
+        hit(l1_dcache_entry_t, L1_DCACHE_WORDS_PER_LINE, L1_DCACHE_LINES, L1_DCACHE_TAG_REMAINING_BITS, L1_DCACHE_WAYS, l1_cache_key);
     }
     break;
     case L2_CACHE:
     {
-        hit(l2_cache_entry_t, L2_CACHE_WORDS_PER_LINE, L2_CACHE_LINES, L2_CACHE_TAG_REMAINING_BITS, L2_CACHE_WAYS);
+        hit(l2_cache_entry_t, L2_CACHE_WORDS_PER_LINE, L2_CACHE_LINES, L2_CACHE_TAG_REMAINING_BITS, L2_CACHE_WAYS, l2_cache_key);
     }
     break;
     default:
@@ -264,94 +340,286 @@ int cache_hit(const void *mem_space,
     return ERR_NONE;
 }
 
+int cache_hit(const void *mem_space,
+              void *cache,
+              phy_addr_t *paddr,
+              const uint32_t **p_line,
+              uint8_t *hit_way,
+              uint16_t *hit_index,
+              cache_t cache_type)
+{
+    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE_NON_NULL(cache);
+    M_REQUIRE_NON_NULL(p_line);
+    M_REQUIRE_NON_NULL(paddr);
+    M_REQUIRE_NON_NULL(hit_index);
+    M_REQUIRE_NON_NULL(hit_way);
+    return hit_at(cache, getPhaddr(paddr), p_line, hit_way, hit_index, cache_type);
+}
+
 #define initLine(lineTo, lineFrom)              \
     for (size_t i = 0; i < WORDS_PER_LINE; ++i) \
         lineTo[i] = lineFrom[i];
 
 #define initEntry(type, ENTRY, lineFrom, TAG, oldage) \
+    ((type *)ENTRY)->head = 0;                        \
     ((type *)ENTRY)->v = 1;                           \
     ((type *)ENTRY)->age = oldage;                    \
     ((type *)ENTRY)->tag = TAG;                       \
     initLine(((type *)ENTRY)->line, lineFrom);
 
-#define l1_search(TYPE)                                                                                                               \
-    M_EXIT_IF_ERR(cache_hit(mem_space, l1_cache, paddr, &p_line, &hit_way, &hit_index, TYPE), "calling cache hit on l1 instruction"); \
-    if (hit_way != HIT_WAY_MISS)                                                                                                      \
-        *word = p_line[word_index];                                                                                                   \
-    return ERR_NONE;
+// counts an event of a set in the per-set counters HEAT, if any
+#define heat(HEAT, SETS, INDEX, COUNTER)             \
+    do                                               \
+    {                                                \
+        if ((HEAT) != NULL)                          \
+            ++(HEAT)->SETS[INDEX].COUNTER;           \
+    } while (0)
 
-#define findPlace(CACHE_TYPE, TYPE, WAYS)                                                                     \
-    foreach_way(way, WAYS)                                                                                    \
-    {                                                                                                         \
-        if (cache_valid(TYPE, WAYS, hit_index, way) == 0)                                                     \
-        {                                                                                                     \
-            M_EXIT_IF_ERR(cache_insert(hit_index, way, entry_toinsert, cache, CACHE_TYPE), "calling insert"); \
-            LRU_age_increase(TYPE, WAYS, way, hit_index);                                                     \
-            return ERR_NONE;                                                                                  \
-        }                                                                                                     \
+#define heat_l1(HEAT, L1_TYPE, INDEX, COUNTER)       \
+    do                                               \
+    {                                                \
+        if ((L1_TYPE) == L1_ICACHE)                  \
+            heat(HEAT, l1_icache, INDEX, COUNTER);   \
+        else                                         \
+            heat(HEAT, l1_dcache, INDEX, COUNTER);   \
+    } while (0)
+
+// inserts the entry in a free way of the line if there is one, otherwise evicts the least recently used way;
+// the evicted entry (if any) is copied to EVICTED, and *P_WAY is set to the way where the entry was inserted
+#define place(CACHE_TYPE, TYPE, WAYS, LINE_INDEX, ENTRY, EVICTED, P_EVICTED, P_WAY)                               \
+    {                                                                                                             \
+        uint8_t way_to = HIT_WAY_MISS;                                                                            \
+        foreach_way(way, WAYS)                                                                                    \
+        {                                                                                                         \
+            if (way_to == HIT_WAY_MISS && cache_valid(TYPE, WAYS, LINE_INDEX, way) == 0)                          \
+                way_to = way;                                                                                     \
+        }                                                                                                         \
+        *(P_EVICTED) = (way_to == HIT_WAY_MISS);                                                                  \
+        if (*(P_EVICTED))                                                                                         \
+        {                                                                                                         \
+            uint8_t max_age = 0;                                                                                  \
+            foreach_way(way, WAYS)                                                                                \
+            {                                                                                                     \
+                if (cache_age(TYPE, WAYS, LINE_INDEX, way) >= max_age)                                            \
+                {                                                                                                 \
+                    way_to = way;                                                                                 \
+                    max_age = cache_age(TYPE, WAYS, LINE_INDEX, way);                                             \
+                }                                                                                                 \
+            }                                                                                                     \
+            *(EVICTED) = *cache_entry(TYPE, WAYS, LINE_INDEX, way_to);                                            \
+        }                                                                                                         \
+        M_EXIT_IF_ERR(cache_insert(LINE_INDEX, way_to, ENTRY, cache, CACHE_TYPE), "while inserting cache entry"); \
+        LRU_age_increase(TYPE, WAYS, way_to, LINE_INDEX);                                                         \
+        *(P_WAY) = way_to;                                                                                        \
     }
 
-#define evict(TYPE, WAYS, CACHE_TYPE)                                                                    \
-    max_age = 0;                                                                                         \
-    foreach_way(way, WAYS)                                                                               \
-    {                                                                                                    \
-        if (cache_age(TYPE, WAYS, hit_index, way) >= max_age)                                            \
-        {                                                                                                \
-            way_to = way;                                                                                \
-            max_age = cache_age(TYPE, WAYS, hit_index, way);                                             \
-        }                                                                                                \
-    }                                                                                                    \
-    evicted = cache_line(TYPE, WAYS, hit_index, way_to);                                                 \
-    l1tag = cache_tag(TYPE, CACHE_TYPE, hit_index, way_to);                                              \
-    M_EXIT_IF_ERR(cache_insert(hit_index, way_to, entry_toinsert, cache, CACHE_TYPE), "CALLING insert"); \
-    LRU_age_update(TYPE, WAYS, way_to, hit_index);
-// END OF EVICT
-
-#define moveL1_to_L2(L1TYPE, WAYS, type, LINES)                                                                 \
-    uint8_t max_age = 0;                                                                                        \
-    uint8_t way_to = 0;                                                                                         \
-    uint32_t l1tag = 0;                                                                                         \
-    const word_t *evicted = NULL;                                                                               \
-    cache = l1_cache;                                                                                           \
-    hit_index = saved_index & MASK_LINE_INDEX_L1;                                                               \
-    evict(type, WAYS, L1TYPE);                                                                                  \
-    cache = l2_cache;                                                                                           \
-    initEntry(l2_cache_entry_t, entry_toinsert, evicted, l1tag >> (L1_ICACHE_TAG_BITS - L2_CACHE_TAG_BITS), 0); \
-    hit_index = ((l1tag & MASK_THREE_BITS) << LINE_INDEX_L1_BITS) | hit_index;                                  \
-    findPlace(L2_CACHE, l2_cache_entry_t, L2_CACHE_WAYS);                                                       \
-    evict(l2_cache_entry_t, L2_CACHE_WAYS, L2_CACHE);                                                           \
+//=========================================================================
+/**
+ * @brief Tool function to place a new entry in L1; if an entry is evicted from L1,
+ * it is moved to L2 (exclusive policy), where the least recently used entry may be dropped.
+ *
+ * @param l1_cache pointer to the beginning of L1 CACHE
+ * @param l2_cache pointer to the beginning of L2 CACHE
+ * @param entry the entry to be inserted in L1
+ * @param l1_index the line index of the entry in L1
+ * @param l1_type L1_ICACHE or L1_DCACHE
+ * @param p_line (modified) the line of the inserted entry in L1
+ * @param heat the per-set counters to update, NULL for none
+ * @return error code
+ */
+static int cache_fill_l1(void *l1_cache, void *l2_cache, const l1_icache_entry_t *entry,
+                         uint16_t l1_index, cache_t l1_type, word_t **p_line, cache_heatmap_t *heat)
+{
+    // L1 instruction and data entries share the same type and geometry
+    void *cache = l1_cache;
+    l1_icache_entry_t l1_evicted;
+    memset(&l1_evicted, 0, sizeof(l1_evicted)); // only read if evicted, which -O2 cannot tell
+    int evicted = 0;
+    uint8_t way = 0;
+    place(l1_type, l1_icache_entry_t, L1_ICACHE_WAYS, l1_index, entry, &l1_evicted, &evicted, &way);
+    *p_line = cache_line(l1_icache_entry_t, L1_ICACHE_WAYS, l1_index, way);
+    if (!evicted)
+        return ERR_NONE;
+    heat_l1(heat, l1_type, l1_index, evictions);
+
+    // L2 tag = 19 msb of L1 tag, L2 index = 3 lsb of L1 tag followed by the 6 bits of L1 index
+    l2_cache_entry_t l2_entry;
+    initEntry(l2_cache_entry_t, &l2_entry, l1_evicted.line, l1_evicted.tag >> (L1_ICACHE_TAG_BITS - L2_CACHE_TAG_BITS), 0);
+    const uint16_t l2_index = ((l1_evicted.tag & MASK_THREE_BITS) << LINE_INDEX_L1_BITS) | l1_index;
+    l2_cache_entry_t l2_evicted; // dropped: write-through, so memory is up to date
+    cache = l2_cache;
+    place(L2_CACHE, l2_cache_entry_t, L2_CACHE_WAYS, l2_index, &l2_entry, &l2_evicted, &evicted, &way);
+    if (evicted)
+        heat(heat, l2_cache, l2_index, evictions);
     return ERR_NONE;
+}
+
+// cache_get_line() on a raw physical address, the arguments being already checked,
+// counting the hits, misses and evictions in heat if not NULL
+static int get_line_at(const void *mem_space, uint32_t phaddr, mem_access_t access,
+                       void *l1_cache, void *l2_cache, word_t **p_line, hit_lvl_t *level,
+                       cache_heatmap_t *heat)
+{
 
-#define moveL2_to_L1(L1TYPE, WAYS, REMAINING_BITS, type, LINES)                                                                                                         \
-    cache_valid(l2_cache_entry_t, L2_CACHE_WAYS, hit_index, hit_way) = 0;                                                                                               \
-    uint32_t newtag = (cache_tag(l2_cache_entry_t, L2_CACHE_WAYS, hit_index, hit_way) << (L1_ICACHE_TAG_BITS - L2_CACHE_TAG_BITS)) | (hit_index >> LINE_INDEX_L1_BITS); \
-    initEntry(type, entry_toinsert, cache_line(l2_cache_entry_t, L2_CACHE_WAYS, hit_index, hit_way), newtag, 0);                                                        \
-    hit_index = saved_index & MASK_LINE_INDEX_L1;                                                                                                                       \
-    cache = l1_cache;                                                                                                                                                   \
-    findPlace(L1TYPE, type, WAYS);                                                                                                                                      \
-    moveL1_to_L2(L1TYPE, WAYS, type, LINES)
-
-#define afterl2Hit                                                                                                 \
-    saved_index = hit_index;                                                                                       \
-    cache = l2_cache;                                                                                              \
-    *word = p_line[word_index];                                                                                    \
-    if (access == INSTRUCTION)                                                                                     \
-    {                                                                                                              \
-        moveL2_to_L1(L1_ICACHE, L1_ICACHE_WAYS, L1_ICACHE_TAG_REMAINING_BITS, l1_icache_entry_t, L1_ICACHE_LINES); \
-    }                                                                                                              \
-    else                                                                                                           \
-    {                                                                                                              \
-        moveL2_to_L1(L1_DCACHE, L1_DCACHE_WAYS, L1_DCACHE_TAG_REMAINING_BITS, l1_dcache_entry_t, L1_DCACHE_LINES); \
+    const cache_t l1_type = (access == INSTRUCTION) ? L1_ICACHE : L1_DCACHE;
+    const word_t *hit_line = NULL;
+    uint8_t hit_way = HIT_WAY_MISS;
+    uint16_t hit_index = HIT_INDEX_MISS;
+
+    const uint16_t l1_index = (phaddr / L1_ICACHE_LINE) % L1_ICACHE_LINES;
+    M_EXIT_IF_ERR(hit_at(l1_cache, phaddr, &hit_line, &hit_way, &hit_index, l1_type), "calling cache hit on l1");
+    if (hit_way != HIT_WAY_MISS)
+    {
+        heat_l1(heat, l1_type, l1_index, hits);
+        *level = HIT_L1;
+        *p_line = (word_t *)hit_line;
+        return ERR_NONE;
+    }
+
+    heat_l1(heat, l1_type, l1_index, misses);
+
+    l1_icache_entry_t entry;
+    M_EXIT_IF_ERR(hit_at(l2_cache, phaddr, &hit_line, &hit_way, &hit_index, L2_CACHE), "calling cache hit on l2");
+    if (hit_way != HIT_WAY_MISS)
+    { // moving the entry from l2 to l1, l1 tag = l2 tag followed by the 3 msb of l2 index
+        heat(heat, l2_cache, hit_index, hits);
+        void *cache = l2_cache;
+        cache_valid(l2_cache_entry_t, L2_CACHE_WAYS, hit_index, hit_way) = 0;
+        const uint32_t tag = (cache_tag(l2_cache_entry_t, L2_CACHE_WAYS, hit_index, hit_way) << (L1_ICACHE_TAG_BITS - L2_CACHE_TAG_BITS)) | (hit_index >> LINE_INDEX_L1_BITS);
+        initEntry(l1_icache_entry_t, &entry, hit_line, tag, 0);
+        *level = HIT_L2;
+    }
+    else
+    {
+        heat(heat, l2_cache, (phaddr / L2_CACHE_LINE) % L2_CACHE_LINES, misses);
+        M_EXIT_IF_ERR(entry_init_at(mem_space, phaddr, &entry, l1_type), "while initialising cache entry");
+        *level = HIT_NONE;
     }
+    return cache_fill_l1(l1_cache, l2_cache, &entry, l1_index, l1_type, p_line, heat);
+}
+
+// see cache_mng.h
+int cache_get_line(const void *mem_space,
+                   phy_addr_t *paddr,
+                   mem_access_t access,
+                   void *l1_cache,
+                   void *l2_cache,
+                   word_t **p_line,
+                   hit_lvl_t *level,
+                   cache_replace_t replace)
+{
+    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE_NON_NULL(l1_cache);
+    M_REQUIRE_NON_NULL(l2_cache);
+    M_REQUIRE_NON_NULL(paddr);
+    M_REQUIRE_NON_NULL(p_line);
+    M_REQUIRE_NON_NULL(level);
+    M_REQUIRE(replace == LRU, ERR_POLICY, "unknown replacement policy %d", replace);
+    M_REQUIRE(access == INSTRUCTION || access == DATA, ERR_BAD_PARAMETER, "unknown access type %d", access);
+    return get_line_at(mem_space, getPhaddr(paddr), access, l1_cache, l2_cache, p_line, level, NULL);
+}
+
+// cache_write_through() on a raw physical address
+static void write_through_at(void *mem_space, uint32_t phaddr, const word_t *line)
+{
+    word_t *const mem_line = (word_t *)mem_space + (phaddr - phaddr % L1_DCACHE_LINE) / sizeof(word_t);
+    for (size_t i = 0; i < WORDS_PER_LINE; ++i)
+        mem_line[i] = line[i];
+}
+
+// see cache_mng.h
+int cache_write_through(void *mem_space, const phy_addr_t *paddr, const word_t *line)
+{
+    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE_NON_NULL(paddr);
+    M_REQUIRE_NON_NULL(line);
+    write_through_at(mem_space, getPhaddr(paddr), line);
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to split an access of size bytes at a physical address
+ * into its parts lying in consecutive cache lines, calling the access function on each part.
+ * The level reported is the deepest level any of the parts was found at.
+ */
+#define foreach_line_part(PHADDR, SIZE, LEVEL, ACCESS)                                                                \
+    do                                                                                                                \
+    {                                                                                                                 \
+        const uint32_t phaddr_ = (PHADDR);                                                                            \
+        M_REQUIRE((phaddr_ % PAGE_SIZE) + (SIZE) <= PAGE_SIZE, ERR_ADDR, "access of %zu bytes crosses a page", SIZE); \
+        *(LEVEL) = HIT_L1;                                                                                            \
+        size_t done_ = 0;                                                                                             \
+        while (done_ < (SIZE))                                                                                        \
+        {                                                                                                             \
+            const uint32_t part_addr = phaddr_ + (uint32_t)done_;                                                     \
+            const size_t in_line = part_addr % L1_ICACHE_LINE;                                                        \
+            const size_t part_size = (SIZE) - done_ < L1_ICACHE_LINE - in_line ? (SIZE) - done_ : L1_ICACHE_LINE - in_line; \
+            word_t *p_line = NULL;                                                                                    \
+            hit_lvl_t part_level = HIT_L1;                                                                            \
+            ACCESS;                                                                                                   \
+            if (part_level > *(LEVEL))                                                                                \
+                *(LEVEL) = part_level;                                                                                \
+            done_ += part_size;                                                                                       \
+        }                                                                                                             \
+    } while (0)
+
+// see cache_mng.h
+int cache_read_sized(const void *mem_space,
+                     uint32_t phaddr,
+                     mem_access_t access,
+                     void *l1_cache,
+                     void *l2_cache,
+                     void *data,
+                     size_t size,
+                     hit_lvl_t *level,
+                     cache_replace_t replace,
+                     cache_heatmap_t *heat)
+{
+    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE_NON_NULL(l1_cache);
+    M_REQUIRE_NON_NULL(l2_cache);
+    M_REQUIRE_NON_NULL(data);
+    M_REQUIRE_NON_NULL(level);
+    M_REQUIRE(replace == LRU, ERR_POLICY, "unknown replacement policy %d", replace);
+    M_REQUIRE(access == INSTRUCTION || access == DATA, ERR_BAD_PARAMETER, "unknown access type %d", access);
+    M_REQUIRE(size > 0 && size <= L1_ICACHE_LINE, ERR_SIZE, "cannot read %zu bytes at once", size);
+    foreach_line_part(phaddr, size, level, {
+        M_EXIT_IF_ERR(get_line_at(mem_space, part_addr, access, l1_cache, l2_cache, &p_line, &part_level, heat),
+                      "getting the cache line");
+        memcpy((byte_t *)data + done_, (const byte_t *)p_line + in_line, part_size);
+    });
+    return ERR_NONE;
+}
 
-#define miss_in_both(CACHE_TYPE, LINE, LINES, type, WAYS)                                                            \
-    M_EXIT_IF_ERR(cache_entry_init(mem_space, paddr, entry_toinsert, CACHE_TYPE), "while initialising cache entry"); \
-    *word = entry_toinsert->line[word_index];                                                                        \
-    hit_index = (phaddr / (LINE)) % LINES;                                                                           \
-    saved_index = hit_index;                                                                                         \
-    cache = l1_cache;                                                                                                \
-    findPlace(CACHE_TYPE, type, WAYS);                                                                               \
-    moveL1_to_L2(CACHE_TYPE, WAYS, type, LINES);
+// see cache_mng.h
+int cache_write_sized(void *mem_space,
+                      uint32_t phaddr,
+                      void *l1_cache,
+                      void *l2_cache,
+                      const void *data,
+                      size_t size,
+                      hit_lvl_t *level,
+                      cache_replace_t replace,
+                      cache_heatmap_t *heat)
+{
+    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE_NON_NULL(l1_cache);
+    M_REQUIRE_NON_NULL(l2_cache);
+    M_REQUIRE_NON_NULL(data);
+    M_REQUIRE_NON_NULL(level);
+    M_REQUIRE(replace == LRU, ERR_POLICY, "unknown replacement policy %d", replace);
+    M_REQUIRE(size > 0 && size <= L1_ICACHE_LINE, ERR_SIZE, "cannot write %zu bytes at once", size);
+    // write-allocate: each line is brought to l1 data cache, modified there and written through to memory
+    foreach_line_part(phaddr, size, level, {
+        M_EXIT_IF_ERR(get_line_at(mem_space, part_addr, DATA, l1_cache, l2_cache, &p_line, &part_level, heat),
+                      "getting the cache line");
+        memcpy((byte_t *)p_line + in_line, (const byte_t *)data + done_, part_size);
+        write_through_at(mem_space, part_addr, p_line);
+    });
+    return ERR_NONE;
+}
 
 int cache_read(const void *mem_space,
                phy_addr_t *paddr,
@@ -362,53 +630,14 @@ int cache_read(const void *mem_space,
                cache_replace_t replace)
 {
 
-    M_REQUIRE_NON_NULL(mem_space);
-    M_REQUIRE_NON_NULL(l1_cache);
-    M_REQUIRE_NON_NULL(l2_cache);
     M_REQUIRE_NON_NULL(paddr);
     M_REQUIRE_NON_NULL(word);
     if (replace != LRU)
         return ERR_BAD_PARAMETER;
-    uint32_t phaddr = getPhaddr(paddr);                                                                           //get the physical address
-    M_REQUIRE((phaddr % WORDS_PER_LINE) == 0, ERR_BAD_PARAMETER, "physical address %d not word aligned", phaddr); // CHECK IF LAST 2 BITS == 0
-    const word_t *p_line = NULL;
-    uint8_t hit_way = 0;
-    uint16_t saved_index, hit_index = 0;
-    uint8_t word_index = (phaddr >> SEL_BYTE) % WORDS_PER_LINE; //getting the index of the word
-    void *cache = l1_cache;
-    switch (access)
-    {
-    case INSTRUCTION:
-    {
-        l1_icache_entry_t l1i;
-        l1_icache_entry_t *entry_toinsert = &l1i;
-        l1_search(L1_ICACHE); // search in l1 i cache, eighter returns ERR_NONE OR is was a miss
-        M_EXIT_IF_ERR(cache_hit(mem_space, l2_cache, paddr, &p_line, &hit_way, &hit_index, L2_CACHE), "calling cache hit on l2");
-        if (hit_way != HIT_WAY_MISS) //if it was a hit in l2
-        {
-            afterl2Hit;
-        }
-        miss_in_both(L1_ICACHE, L1_ICACHE_LINE, L1_ICACHE_LINES, l1_icache_entry_t, L1_ICACHE_WAYS);
-    }
-    break;
-    case DATA:
-    {
-        l1_dcache_entry_t l1d;
-        l1_dcache_entry_t *entry_toinsert = &l1d;
-        l1_search(L1_DCACHE);
-        M_EXIT_IF_ERR(cache_hit(mem_space, l2_cache, paddr, &p_line, &hit_way, &hit_index, L2_CACHE), "calling cache hit on l1 instruction");
-        if (hit_way != HIT_WAY_MISS)
-        {
-            afterl2Hit;
-        }
-
-        miss_in_both(L1_DCACHE, L1_DCACHE_LINE, L1_DCACHE_LINES, l1_dcache_entry_t, L1_DCACHE_WAYS);
-    }
-    break;
-    default:
-        return ERR_BAD_PARAMETER;
-    }
-    return ERR_NONE;
+    uint32_t phaddr = getPhaddr(paddr);                                                                            //get the physical address
+    M_REQUIRE((phaddr % sizeof(word_t)) == 0, ERR_BAD_PARAMETER, "physical address %d not word aligned", phaddr); // CHECK IF LAST 2 BITS == 0
+    hit_lvl_t level = HIT_NONE;
+    return cache_read_sized(mem_space, phaddr, access, l1_cache, l2_cache, word, sizeof(word_t), &level, replace, NULL);
 }
 
 int cache_read_byte(const void *mem_space,
@@ -419,44 +648,13 @@ int cache_read_byte(const void *mem_space,
                     uint8_t *p_byte,
                     cache_replace_t replace)
 {
-    M_REQUIRE_NON_NULL(mem_space);
-    M_REQUIRE_NON_NULL(l1_cache);
-    M_REQUIRE_NON_NULL(l2_cache);
     M_REQUIRE_NON_NULL(p_paddr);
-    M_REQUIRE_NON_NULL(p_byte);
     if (replace != LRU)
         return ERR_BAD_PARAMETER;
-    uint32_t phaddr = getPhaddr(p_paddr);
-    uint8_t byteIndex = phaddr % sizeof(word_t); // gives the last 2 bits
-    word_t word = 0;
-    p_paddr->page_offset -= (p_paddr->page_offset % WORDS_PER_LINE); //making the physica address word aligned
-    M_EXIT_IF_ERR(cache_read(mem_space, p_paddr, access, l1_cache, l2_cache, &word, replace), "calling cache read");
-    *p_byte = (word >> (byteIndex)*BITS_IN_BYTE) & BYTE_MASK; //little endian, lsb byte in word is index 0
-    return ERR_NONE;
+    hit_lvl_t level = HIT_NONE;
+    return cache_read_sized(mem_space, getPhaddr(p_paddr), access, l1_cache, l2_cache, p_byte, 1, &level, replace, NULL);
 }
 
-#define read_mod_ins(cachet, CACHE_TYPE, WAYS, type, WORDS_PER_LINE, REMAINING_BITS, LINES)                                            \
-    M_EXIT_IF_ERR(cache_hit(mem_space, cachet, paddr, &p_line, &hit_way, &hit_index, CACHE_TYPE), "while calling hit");                \
-    if (hit_way != HIT_WAY_MISS)                                                                                                       \
-    {                                                                                                                                  \
-        saved_index = hit_index;                                                                                                       \
-        void *cache = cachet;                                                                                                          \
-        p_line[word_index] = *word;                                                                                                    \
-        initEntry(type, entry_toinsert, p_line, cache_tag(type, WAYS, hit_index, hit_way), cache_age(type, WAYS, hit_index, hit_way)); \
-        cache_insert(hit_index, hit_way, entry_toinsert, cachet, CACHE_TYPE);                                                          \
-        LRU_age_update(type, WAYS, hit_way, hit_index);                                                                                \
-        off = phaddr - (phaddr % LINES);                                                                                               \
-        index = off / WORDS_PER_LINE;                                                                                                  \
-        for (size_t i = 0; i < WORDS_PER_LINE; ++i)                                                                                    \
-            *((word_t *)mem_space + index + i) = p_line[i];                                                                            \
-        if (CACHE_TYPE == L2_CACHE)                                                                                                    \
-        {                                                                                                                              \
-            entry_toinsert = &l1d;                                                                                                     \
-            moveL2_to_L1(L1_DCACHE, L1_DCACHE_WAYS, L1_DCACHE_TAG_REMAINING_BITS, l1_dcache_entry_t, L1_DCACHE_LINES);                 \
-        }                                                                                                                              \
-        return ERR_NONE;                                                                                                               \
-    }
-
 int cache_write(void *mem_space,
                 phy_addr_t *paddr,
                 void *l1_cache,
@@ -464,42 +662,13 @@ int cache_write(void *mem_space,
                 const uint32_t *word,
                 cache_replace_t replace)
 {
-    M_REQUIRE_NON_NULL(mem_space);
-    M_REQUIRE_NON_NULL(l1_cache);
-    M_REQUIRE_NON_NULL(l2_cache);
     M_REQUIRE_NON_NULL(paddr);
-    M_REQUIRE_NON_NULL(word);
     if (replace != LRU)
         return ERR_BAD_PARAMETER;
     uint32_t phaddr = getPhaddr(paddr);
-    M_REQUIRE((phaddr % WORDS_PER_LINE) == 0, ERR_BAD_PARAMETER, "physical address %d not word aligned", phaddr);
-    uint32_t *p_line = NULL;
-    uint8_t hit_way = 0;
-    uint16_t saved_index, hit_index = 0;
-    uint8_t word_index = (phaddr >> SEL_BYTE) & MASK_TWO_BITS;
-
-    uint32_t off, index;
-    void *entry_toinsert;
-    l1_dcache_entry_t l1d;
-    entry_toinsert = &l1d;
-    read_mod_ins(l1_cache, L1_DCACHE, L1_DCACHE_WAYS, l1_dcache_entry_t, L1_DCACHE_WORDS_PER_LINE, L1_DCACHE_TAG_REMAINING_BITS, L1_DCACHE_LINES);
-    l2_cache_entry_t l2;
-    entry_toinsert = &l2;
-    read_mod_ins(l2_cache, L2_CACHE, L2_CACHE_WAYS, l2_cache_entry_t, L2_CACHE_WORDS_PER_LINE, L2_CACHE_TAG_REMAINING_BITS, L2_CACHE_LINES);
-    entry_toinsert = &l1d; //alrady done in red_mod_ins but just to make it clear that it points to the right type entry
-    M_EXIT_IF_ERR(cache_entry_init(mem_space, paddr, entry_toinsert, L1_DCACHE), "while calling cache entry init");
-    off = phaddr - (phaddr % L1_DCACHE_LINES);
-    index = off / L1_DCACHE_WORDS_PER_LINE; //recalculate the index in main memory
-
-    ((l1_dcache_entry_t *)entry_toinsert)->line[word_index] = *word;
-    for (size_t i = 0; i < L1_DCACHE_WORDS_PER_LINE; ++i)
-        *((word_t *)mem_space + index + i) = ((l1_dcache_entry_t *)entry_toinsert)->line[i];
-    void *cache = l1_cache;
-    hit_index = (phaddr / (L1_DCACHE_LINE)) % L1_DCACHE_LINES;
-    saved_index = hit_index;
-    findPlace(L1_DCACHE, l1_dcache_entry_t, L1_DCACHE_WAYS)
-        moveL1_to_L2(L1_DCACHE, L1_DCACHE_WAYS, l1_dcache_entry_t, L1_DCACHE_LINES);
-    return ERR_NONE;
+    M_REQUIRE((phaddr % sizeof(word_t)) == 0, ERR_BAD_PARAMETER, "physical address %d not word aligned", phaddr);
+    hit_lvl_t level = HIT_NONE;
+    return cache_write_sized(mem_space, phaddr, l1_cache, l2_cache, word, sizeof(word_t), &level, replace, NULL);
 }
 
 int cache_write_byte(void *mem_space,
@@ -509,22 +678,9 @@ int cache_write_byte(void *mem_space,
                      uint8_t p_byte,
                      cache_replace_t replace)
 {
-
-    M_REQUIRE_NON_NULL(mem_space);
-    M_REQUIRE_NON_NULL(l1_cache);
-    M_REQUIRE_NON_NULL(l2_cache);
     M_REQUIRE_NON_NULL(paddr);
     if (replace != LRU)
         return ERR_BAD_PARAMETER;
-    uint32_t phaddr = getPhaddr(paddr);
-    uint8_t byteIndex = phaddr % sizeof(word_t); // gives the last 2 bits
-    word_t word = 0;
-    paddr->page_offset -= (paddr->page_offset % WORDS_PER_LINE); //making the physica address word aligned
-    M_EXIT_IF_ERR(cache_read(mem_space, paddr, DATA, l1_cache, l2_cache, &word, replace), "CALLING read");
-    uint32_t mask = (BYTE_MASK << (byteIndex * BITS_IN_BYTE)); //little endian
-    mask = ~mask;
-    uint32_t modified = p_byte << (byteIndex * BITS_IN_BYTE);
-    word = (word & mask) | modified;
-    M_EXIT_IF_ERR(cache_write(mem_space, paddr, l1_cache, l2_cache, &word, replace), "CALLING WRITE");
-    return ERR_NONE;
-}
\ No newline at end of file
+    hit_lvl_t level = HIT_NONE;
+    return cache_write_sized(mem_space, getPhaddr(paddr), l1_cache, l2_cache, &p_byte, 1, &level, replace, NULL);
+}
@@ -11,6 +11,7 @@
 #include "mem_access.h"
 #include "addr.h"
 #include "cache.h"
+#include "heatmap.h"
 #include <stdio.h> // for FILE
 
 enum cache_replacement_policy { LRU };
@@ -96,6 +97,45 @@ int cache_entry_init(const void * mem_space,
                      void * cache_entry,
                      cache_t cache_type);
 
+//=========================================================================
+/**
+ * @brief Ask cache for the line holding a physical address.
+ *  Exclusive policy (see cache_read): on L1 miss, the line is brought to L1
+ *  (from L2 or from main memory), possibly evicting an L1 line to L2.
+ *  This is the only traversal of the hierarchy needed for any access size.
+ *
+ * @param mem_space pointer to the memory space
+ * @param paddr pointer to a physical address
+ * @param access to distinguish between fetching instructions and reading/writing data
+ * @param l1_cache pointer to the beginning of L1 CACHE
+ * @param l2_cache pointer to the beginning of L2 CACHE
+ * @param p_line (modified) pointer to the L1 cache line holding the address
+ * @param level (modified) HIT_L1, HIT_L2, or HIT_NONE when the line was fetched from memory
+ * @param replace replacement policy
+ * @return error code
+ */
+int cache_get_line(const void * mem_space,
+                   phy_addr_t * paddr,
+                   mem_access_t access,
+                   void * l1_cache,
+                   void * l2_cache,
+                   word_t ** p_line,
+                   hit_lvl_t * level,
+                   cache_replace_t replace);
+
+//=========================================================================
+/**
+ * @brief Copy a (modified) cache line back to main memory (write-through policy).
+ *
+ * @param mem_space pointer to the memory space
+ * @param paddr pointer to a physical address inside the line
+ * @param line the cache line to be written
+ * @return error code
+ */
+int cache_write_through(void * mem_space,
+                        const phy_addr_t * paddr,
+                        const word_t * line);
+
 //=========================================================================
 /**
  * @brief Ask cache for a word of data.
@@ -169,6 +209,64 @@ int cache_write(void * mem_space,
                 const uint32_t * word,
                 cache_replace_t replace);
 
+//=========================================================================
+/**
+ * @brief Ask cache for size consecutive bytes of data (1 to a full cache line).
+ *  Accesses crossing a line boundary are split into their two lines;
+ *  each line is obtained through cache_get_line().
+ *
+ * @param mem_space pointer to the memory space
+ * @param phaddr the physical address of the first byte, as a number; the access shall not cross a page
+ * @param access to distinguish between fetching instructions and reading/writing data
+ * @param l1_cache pointer to the beginning of L1 CACHE
+ * @param l2_cache pointer to the beginning of L2 CACHE
+ * @param data (modified) buffer of at least size bytes, filled in memory order
+ * @param size the number of bytes to read
+ * @param level (modified) deepest level any of the lines was found at
+ * @param replace replacement policy
+ * @param heat the per-set counters of hits, misses and evictions to update, NULL for none
+ * @return error code
+ */
+int cache_read_sized(const void * mem_space,
+                     uint32_t phaddr,
+                     mem_access_t access,
+                     void * l1_cache,
+                     void * l2_cache,
+                     void * data,
+                     size_t size,
+                     hit_lvl_t * level,
+                     cache_replace_t replace,
+                     cache_heatmap_t * heat);
+
+//=========================================================================
+/**
+ * @brief Write to cache size consecutive bytes of data (1 to a full cache line),
+ *  with a single traversal of the hierarchy per line touched: one lookup (with
+ *  fill on miss, see cache_get_line), the data merged in place into the L1 line,
+ *  then the line written through to memory. Accesses crossing a line boundary
+ *  are split into their two lines.
+ *
+ * @param mem_space pointer to the memory space
+ * @param phaddr the physical address of the first byte, as a number; the access shall not cross a page
+ * @param l1_cache pointer to the beginning of L1 DCACHE
+ * @param l2_cache pointer to the beginning of L2 CACHE
+ * @param data the bytes to be written, in memory order
+ * @param size the number of bytes to write
+ * @param level (modified) deepest level any of the lines was found at
+ * @param replace replacement policy
+ * @param heat the per-set counters of hits, misses and evictions to update, NULL for none
+ * @return error code
+ */
+int cache_write_sized(void * mem_space,
+                      uint32_t phaddr,
+                      void * l1_cache,
+                      void * l2_cache,
+                      const void * data,
+                      size_t size,
+                      hit_lvl_t * level,
+                      cache_replace_t replace,
+                      cache_heatmap_t * heat);
+
 //=========================================================================
 /**
  * @brief Write to cache a byte of data. Endianess: LITTLE.
@@ -197,3 +295,20 @@ int cache_write_byte(void * mem_space,
  * @return error code
  */
 int cache_dump(FILE* output, const void* cache, cache_t cache_type);
+
+//=========================================================================
+/**
+ * @brief Print, as cache_dump() does, only the entries of a cache that changed
+ *        since the previous call, and record them in previous.
+ *
+ * previous is a copy of the cache, zeroed (thus all invalid) before the first
+ * call: applying the printed entries in turn to an all-invalid cache gives back
+ * its full contents at each call.
+ *
+ * @param output the stream to print to.
+ * @param cache pointer to the cache
+ * @param previous (modified) the cache as of the previous call, of the same type
+ * @param cache_type to distinguish between different caches
+ * @return error code
+ */
+int cache_dump_delta(FILE* output, const void* cache, void* previous, cache_t cache_type);
@@ -0,0 +1,171 @@
+/**
+ * @file checkpoint.c
+ * @brief checkpoint and restore of a whole simulator state
+ *
+ * File layout (native byte order, meant to be read back by the same build):
+ *   header (with the current ASID, the page-table roots and the next free
+ *   frame of demand paging), the seven TLB and cache arrays as they
+ *   are in memory, the hit counters, then for each dirty page its physical
+ *   page number (uint32_t) followed by its PAGE_SIZE bytes (fewer for a
+ *   truncated last page).
+ *
+ * @date 2019
+ */
+#include "checkpoint.h"
+#include "sim.h"
+#include "error.h"
+#include "util.h"
+
+#include <stdint.h>
+#include <inttypes.h> // for PRIu64
+#include <string.h>   // for memcmp()
+
+#define NB_SECTIONS 7 // 3 TLBs, the micro-TLBs and 3 caches
+
+/**
+ * @brief checkpoint header; the section sizes reject a file written by an incompatible build
+ */
+typedef struct
+{
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    uint32_t version;
+    uint32_t section_sizes[NB_SECTIONS];
+    uint32_t asid;
+    uint32_t page_table_roots[NB_ASIDS];
+    uint64_t mem_size;
+    uint64_t nb_dirty_pages;
+    uint64_t next_frame; // 0 without demand paging
+} checkpoint_header_t;
+
+// pointers to the arrays of a simulator, in file order
+#define SIM_SECTIONS(SIM)                                                        \
+    {                                                                            \
+        (SIM)->l1_itlb, (SIM)->l1_dtlb, (SIM)->l2_tlb, (SIM)->utlb,              \
+            (SIM)->l1_icache, (SIM)->l1_dcache, (SIM)->l2_cache                  \
+    }
+#define SIM_SECTION_SIZES(SIM)                                                   \
+    {                                                                            \
+        sizeof((SIM)->l1_itlb), sizeof((SIM)->l1_dtlb), sizeof((SIM)->l2_tlb),   \
+            sizeof((SIM)->utlb),                                                 \
+            sizeof((SIM)->l1_icache), sizeof((SIM)->l1_dcache), sizeof((SIM)->l2_cache) \
+    }
+
+// number of bytes of a page lying inside memory
+#define page_bytes(MEM_SIZE, PAGE) \
+    ((MEM_SIZE) - (PAGE) * PAGE_SIZE < PAGE_SIZE ? (MEM_SIZE) - (PAGE) * PAGE_SIZE : PAGE_SIZE)
+
+#define write_or_fail(PTR, SIZE, FILE)                                            \
+    M_REQUIRE(fwrite(PTR, SIZE, 1, FILE) == 1, ERR_IO, "cannot write %zu bytes", (size_t)(SIZE))
+#define read_or_fail(PTR, SIZE, FILE)                                             \
+    M_REQUIRE(fread(PTR, SIZE, 1, FILE) == 1, ERR_IO, "cannot read %zu bytes", (size_t)(SIZE))
+
+int checkpoint_write(FILE *output, const sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE_NON_NULL(sim->mem_space);
+    M_REQUIRE_NON_NULL(sim->dirty_pages);
+
+    const uint64_t nb_pages = SIM_NB_PAGES(sim->mem_size);
+    checkpoint_header_t header;
+    zero_init_var(header);
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    const size_t sizes[NB_SECTIONS] = SIM_SECTION_SIZES(sim);
+    for (int i = 0; i < NB_SECTIONS; ++i)
+        header.section_sizes[i] = (uint32_t)sizes[i];
+    header.asid = sim->asid;
+    for (int asid = 0; asid < NB_ASIDS; ++asid)
+        header.page_table_roots[asid] = sim->page_table_roots[asid];
+    header.mem_size = sim->mem_size;
+    if (sim->frames != NULL)
+        header.next_frame = sim->frames->next_frame;
+    for (uint64_t page = 0; page < nb_pages; ++page)
+        header.nb_dirty_pages += sim_page_is_dirty(sim, page);
+    write_or_fail(&header, sizeof(header), output);
+
+    const void *sections[NB_SECTIONS] = SIM_SECTIONS(sim);
+    for (int i = 0; i < NB_SECTIONS; ++i)
+        write_or_fail(sections[i], sizes[i], output);
+    write_or_fail(&sim->stats, sizeof(sim->stats), output);
+
+    const byte_t *mem = sim->mem_space;
+    for (uint64_t page = 0; page < nb_pages; ++page)
+    {
+        if (sim_page_is_dirty(sim, page))
+        {
+            const uint32_t page_num = (uint32_t)page;
+            write_or_fail(&page_num, sizeof(page_num), output);
+            write_or_fail(mem + page * PAGE_SIZE, page_bytes(sim->mem_size, page), output);
+        }
+    }
+    return ERR_NONE;
+}
+
+int checkpoint_read(FILE *input, sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(input);
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE_NON_NULL(sim->mem_space);
+    M_REQUIRE_NON_NULL(sim->dirty_pages);
+
+    checkpoint_header_t header;
+    read_or_fail(&header, sizeof(header), input);
+    M_REQUIRE(memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0, ERR_IO, "not a %s file", "checkpoint");
+    M_REQUIRE(header.version == CHECKPOINT_VERSION, ERR_IO, "unsupported checkpoint version %u", header.version);
+    const size_t sizes[NB_SECTIONS] = SIM_SECTION_SIZES(sim);
+    for (int i = 0; i < NB_SECTIONS; ++i)
+        M_REQUIRE(header.section_sizes[i] == sizes[i], ERR_SIZE, "section %d has size %u instead of %zu", i, header.section_sizes[i], sizes[i]);
+    M_REQUIRE(header.asid < NB_ASIDS, ERR_IO, "ASID %u is not below %d", header.asid, NB_ASIDS);
+    M_REQUIRE(header.mem_size == sim->mem_size, ERR_SIZE, "checkpoint memory size %" PRIu64 " differs from %zu", header.mem_size, sim->mem_size);
+    for (int asid = 0; asid < NB_ASIDS; ++asid)
+        M_REQUIRE(header.page_table_roots[asid] % PAGE_SIZE == 0 && (uint64_t)header.page_table_roots[asid] + PAGE_SIZE <= header.mem_size,
+                  ERR_IO, "page-table root 0x%" PRIx32 " is not a page of memory", header.page_table_roots[asid]);
+    const uint64_t nb_pages = SIM_NB_PAGES(sim->mem_size);
+    M_REQUIRE(header.nb_dirty_pages <= nb_pages, ERR_SIZE, "too many dirty pages: %" PRIu64, header.nb_dirty_pages);
+    M_REQUIRE(header.next_frame % PAGE_SIZE == 0 && header.next_frame <= header.mem_size, ERR_IO,
+              "next free frame 0x%" PRIx64 " is not a page of memory", header.next_frame);
+
+    void *sections[NB_SECTIONS] = SIM_SECTIONS(sim);
+    for (int i = 0; i < NB_SECTIONS; ++i)
+        read_or_fail(sections[i], sizes[i], input);
+    read_or_fail(&sim->stats, sizeof(sim->stats), input);
+    sim->asid = (asid_t)header.asid;
+    for (int asid = 0; asid < NB_ASIDS; ++asid)
+        sim->page_table_roots[asid] = header.page_table_roots[asid];
+    // the frames taken before the checkpoint are restored below as dirty pages
+    if (sim->frames != NULL && header.next_frame > sim->frames->next_frame)
+        sim->frames->next_frame = header.next_frame;
+
+    byte_t *mem = sim->mem_space;
+    for (uint64_t i = 0; i < header.nb_dirty_pages; ++i)
+    {
+        uint32_t page_num = 0;
+        read_or_fail(&page_num, sizeof(page_num), input);
+        M_REQUIRE(page_num < nb_pages, ERR_ADDR, "dirty page %" PRIu32 " is outside of memory", page_num);
+        read_or_fail(mem + (uint64_t)page_num * PAGE_SIZE, page_bytes(sim->mem_size, (uint64_t)page_num), input);
+        sim->dirty_pages[page_num / 8] |= (byte_t)(1 << (page_num % 8));
+    }
+    return ERR_NONE;
+}
+
+int checkpoint_save(const char *filename, const sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(filename);
+    FILE *file = fopen(filename, "wb");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(file, ERR_IO);
+    int err = checkpoint_write(file, sim);
+    if (fclose(file) != 0 && err == ERR_NONE)
+        err = ERR_IO;
+    return err;
+}
+
+int checkpoint_load(const char *filename, sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(filename);
+    FILE *file = fopen(filename, "rb");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(file, ERR_IO);
+    const int err = checkpoint_read(file, sim);
+    fclose(file);
+    return err;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+/**
+ * @file checkpoint.h
+ * @brief checkpoint and restore of a whole simulator state
+ *
+ * A checkpoint holds the TLBs, micro-TLBs and caches (entries with their LRU ages),
+ * the current address space, the next free frame of demand paging, the hit counters and the content of every memory page written since
+ * sim_init(). Restoring it into a simulator freshly initialized from the
+ * same memory dump or description brings it back to the very same state,
+ * so that one warm-up can be replayed into many experiments.
+ *
+ * @date 2019
+ */
+
+#include "sim.h"
+
+#include <stdio.h> // for FILE
+
+#define CHECKPOINT_MAGIC "PPSCKPT"
+#define CHECKPOINT_VERSION 6
+
+//=========================================================================
+/**
+ * @brief Write the state of a simulator to a binary stream.
+ *
+ * @param output the stream to write to (opened in binary mode)
+ * @param sim the simulator to save
+ * @return error code
+ */
+int checkpoint_write(FILE *output, const sim_t *sim);
+
+//=========================================================================
+/**
+ * @brief Restore the state of a simulator from a binary stream.
+ *
+ * The simulator must have been initialized on a memory of the same size
+ * holding the same initial content as the saved one; the pages written
+ * before the checkpoint are overwritten with their saved content.
+ *
+ * @param input the stream to read from (opened in binary mode)
+ * @param sim (modified) the simulator to restore
+ * @return error code
+ */
+int checkpoint_read(FILE *input, sim_t *sim);
+
+//=========================================================================
+/**
+ * @brief Save the state of a simulator to a file, see checkpoint_write().
+ * @param filename the name of the file to write
+ * @param sim the simulator to save
+ * @return error code
+ */
+int checkpoint_save(const char *filename, const sim_t *sim);
+
+//=========================================================================
+/**
+ * @brief Restore the state of a simulator from a file, see checkpoint_read().
+ * @param filename the name of the file to read
+ * @param sim (modified) the simulator to restore
+ * @return error code
+ */
+int checkpoint_load(const char *filename, sim_t *sim);
@@ -9,17 +9,29 @@
 #include <stdio.h>	// for size_t, FILE
 #include <stdint.h>   // for uint32_t
 #include <string.h>
-#include <ctype.h>
+#include <limits.h> // for UCHAR_MAX
 #include <inttypes.h>
 #include <stdlib.h>
 #include "error.h"
 #include "addr_mng.h"
 #include "addr.h"
+#include "trace_io.h"
 
 #define INIT_NBLINES 10
 #define BITS_IN_BYTE 8
 #define MASK_WORD ((uint32_t)-1)
-int fill_command(FILE *fp, command_t *command);
+
+// letters used in the text format for each data size, indexed by log2 of the size in bytes
+static const char DATA_SIZE_LETTERS[] = {'B', 'H', 'W', 'D', 'L'};
+#define NB_DATA_SIZES (sizeof(DATA_SIZE_LETTERS) / sizeof(DATA_SIZE_LETTERS[0]))
+
+static inline int data_size_index(size_t data_size)
+{ // the index of a data size in DATA_SIZE_LETTERS, -1 if not a valid size
+	for (size_t i = 0; i < NB_DATA_SIZES; ++i)
+		if (data_size == ((size_t)1 << i))
+			return (int)i;
+	return -1;
+}
 
 int program_init(program_t *program)
 { //initialising the program
@@ -36,6 +48,40 @@ int program_init(program_t *program)
 	return ERR_NONE;
 }
 
+int command_set_vaddr(command_t *command, uint64_t vaddr64)
+{
+	M_REQUIRE_NON_NULL(command);
+	M_EXIT_IF_ERR(init_virt_addr64(&command->vaddr, vaddr64), "initialising the virtual address");
+	command->vaddr64 = vaddr64;
+	return ERR_NONE;
+}
+
+int command_print(FILE *output, const command_t *command)
+{ // printing one command
+
+	M_REQUIRE_NON_NULL(output);
+	M_REQUIRE_NON_NULL(command);
+	if (command->process != 0) // untagged traces are printed as before
+		fprintf(output, "P%u ", (unsigned)command->process);
+	fprintf(output, (command->order == READ) ? "R " : "W "); //check for a read
+	const int size_index = data_size_index(command->data_size);
+	M_REQUIRE(size_index >= 0, ERR_SIZE, "invalid data size %zu", command->data_size);
+	if (command->type == INSTRUCTION)
+		fprintf(output, "I ");
+	else
+		fprintf(output, "D%c ", DATA_SIZE_LETTERS[size_index]);
+	if (command->order == WRITE)
+	{ // checking if we need write data, printed with two hex digits per byte (a line write holds a doubleword pattern)
+		const int digits = 2 * (int)(command->data_size < sizeof(uint64_t) ? command->data_size : sizeof(uint64_t));
+		fprintf(output, "0x%0*" PRIX64, digits, command->write_data);
+	}
+	fprintf(output, " @");
+	uint64_t vaddr_num = virt_addr_t_to_virtual_page_number(&(command->vaddr)) << PAGE_OFFSET | (command->vaddr).page_offset;
+	fprintf(output, "0x%016" PRIX64, vaddr_num); // printing the virtual address
+	fprintf(output, "\n");
+	return ERR_NONE;
+}
+
 int program_print(FILE *output, const program_t *program)
 { // printing the program
 
@@ -43,20 +89,8 @@ int program_print(FILE *output, const program_t *program)
 	M_REQUIRE_NON_NULL(program->listing);
 	M_REQUIRE_NON_NULL(output);
 	for_all_lines(line, program)
-	{														  // looping trough the lines
-		fprintf(output, (line->order == READ) ? "R " : "W "); //check for a read
-		fprintf(output, (line->type == INSTRUCTION) ? "I " : (line->data_size == 1) ? "DB " : "DW ");
-		if (line->order == WRITE)
-		{ // checking if we need write data
-			if (line->data_size == 1)
-				fprintf(output, "0x%02" PRIX32, line->write_data);
-			else
-				fprintf(output, "0x%08" PRIX32, line->write_data);
-		}
-		fprintf(output, " @");
-		uint64_t vaddr_num = virt_addr_t_to_virtual_page_number(&(line->vaddr)) << PAGE_OFFSET | (line->vaddr).page_offset;
-		fprintf(output, "0x%016" PRIX64, vaddr_num); // printing the virtual address
-		fprintf(output, "\n");
+	{ // looping trough the lines
+		M_EXIT_IF_ERR(command_print(output, line), "printing a command");
 	}
 	return ERR_NONE;
 }
@@ -66,15 +100,11 @@ int program_shrink(program_t *program)
 
 	M_REQUIRE_NON_NULL(program);
 	M_REQUIRE_NON_NULL(program->listing);
-	size_t old_allocated = program->allocated;										// saving the old allocated value
-	program->allocated = program->nb_lines == 0 ? INIT_NBLINES : program->nb_lines; // allocating only a needed number of lines
-	command_t *listing = NULL;
-	if ((listing = (command_t *)realloc(program->listing, program->allocated * sizeof(command_t)), program->allocated * sizeof(command_t)) == NULL)
-	{
-		program->allocated = old_allocated;
-		return ERR_MEM; // IF REALLOC FAILS
-	}
+	const size_t new_allocated = (program->nb_lines == 0 ? INIT_NBLINES : program->nb_lines) * sizeof(command_t); // allocating only the needed bytes
+	command_t *listing = (command_t *)realloc(program->listing, new_allocated);
+	M_REQUIRE_NON_NULL_CUSTOM_ERR(listing, ERR_MEM); // the old listing is left untouched if realloc fails
 	program->listing = listing;
+	program->allocated = new_allocated;
 	return ERR_NONE;
 }
 
@@ -84,10 +114,10 @@ int program_add_command(program_t *program, const command_t *command)
 	M_REQUIRE_NON_NULL(command);
 	M_REQUIRE_NON_NULL(program->listing);
 
-	M_EXIT_IF((command->type == DATA) && ((command->data_size != 1) && (command->data_size != sizeof(word_t))), ERR_SIZE, "data can not have length different than 1 byte or word, length is %u", command->data_size);
-	M_EXIT_IF((command->type == INSTRUCTION) && (command->data_size != sizeof(word_t)), ERR_SIZE, "Instructions must have length of a word, but size is %z", command->data_size); //should we use err size or err bad parameter??
+	M_EXIT_IF((command->type == DATA) && (data_size_index(command->data_size) < 0), ERR_SIZE, "data must be a byte, halfword, word, doubleword or line, length is %zu", command->data_size);
+	M_EXIT_IF((command->type == INSTRUCTION) && (command->data_size != sizeof(word_t)), ERR_SIZE, "Instructions must have length of a word, but size is %zu", command->data_size); //should we use err size or err bad parameter??
 	M_EXIT_IF((command->type == INSTRUCTION) && (command->order != READ), ERR_BAD_PARAMETER, "cannot write only %s commands", "read");
-	M_EXIT_IF((command->order == WRITE) && (command->type == DATA) && ((command->data_size == 1) && (command->write_data >> BITS_IN_BYTE != 0)), ERR_BAD_PARAMETER, "wite data is not good size %d", command->write_data);
+	M_EXIT_IF((command->order == WRITE) && (command->type == DATA) && (command->data_size < sizeof(uint64_t)) && (command->write_data >> (command->data_size * BITS_IN_BYTE) != 0), ERR_BAD_PARAMETER, "wite data is not good size %" PRIx64, command->write_data);
 	//M_EXIT_IF((command->order == READ) && (command->write_data != 0), ERR_BAD_PARAMETER, "wite data is not good size %d", command->write_data);// gives an error !
 
 	size_t old_allocated = program->allocated; // saving the old allocated value to be able to initialise the new allocated memory part
@@ -99,104 +129,236 @@ int program_add_command(program_t *program, const command_t *command)
 		program->listing = listing;
 		memset(program->listing + (old_allocated / sizeof(command_t)), 0, old_allocated); // initialiing the uninitialised parts of memory
 	}
-	M_REQUIRE((program->nb_lines) < 100, ERR_MEM, "programm already contains %u commands", program->nb_lines);
 	program->listing[program->nb_lines] = *command; //adding the command
 	++(program->nb_lines);
 	return ERR_NONE;
 }
 
-int program_read(const char *filename, program_t *program)
+//=========================================================================
+/* Buffered reading of the text format: the file is read by large blocks and
+ * parsed character by character from memory; hex digits and spaces are
+ * classified with constant lookup tables (so that parsing is thread safe). */
+
+#define READ_BUFFER_SIZE (1 << 20)
+
+typedef struct
 {
+	trace_file_t file; // NULL when parsing a text already in memory
+	const unsigned char *buffer;
+	size_t pos; // next character to read
+	size_t len; // number of characters in the buffer
+} command_reader_t;
 
-	program_init(program);
-	FILE *fp;
-	fp = fopen(filename, "r"); // read mode
-	M_REQUIRE_NON_NULL(fp);
-	command_t command;
-	int k;
-	while ((k = fill_command(fp, &command)) != EOF)
-	{
+// one plus the value of each hex digit, 0 for other characters
+static const unsigned char HEX_VALUES[UCHAR_MAX + 1] = {
+	['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+	['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16};
+// non-zero for the characters isspace() accepts in the C locale
+static const unsigned char SPACES[UCHAR_MAX + 1] = {
+	[' '] = 1, ['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1};
 
-		if ((k != ERR_NONE))
-		{
-			fclose(fp);
-			return k;
-		}
+// the next character (as an unsigned char), or EOF
+static inline int next_char(command_reader_t *reader)
+{
+	if (reader->pos == reader->len)
+	{ // refill, rare
+		if (reader->file == NULL)
+			return EOF;
+		reader->len = trace_read(reader->file, (unsigned char *)reader->buffer, READ_BUFFER_SIZE);
+		reader->pos = 0;
+		if (reader->len == 0)
+			return EOF;
+	}
+	return reader->buffer[reader->pos++];
+}
+
+// give back the last character read (at most one, never EOF)
+static inline void unread_char(command_reader_t *reader)
+{
+	--reader->pos;
+}
 
-		if ((k = program_add_command(program, &command)) != ERR_NONE)
+static inline int is_space(int c)
+{
+	return c != EOF && SPACES[c];
+}
+
+// the first character after spaces
+static inline int skip_spaces(command_reader_t *reader)
+{
+	int c;
+	while (is_space(c = next_char(reader)))
+	{
+	}
+	return c;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to read a hex number the way fscanf("%x") does:
+ *        leading spaces, optional 0x or 0X, then hex digits.
+ * @param reader the reader
+ * @param value (modified) the number read
+ * @return 1 if a number was read, 0 otherwise
+ */
+static int read_hex(command_reader_t *reader, uint64_t *value)
+{
+	int c = skip_spaces(reader);
+	int digits = 0;
+	uint64_t v = 0;
+	if (c == '0')
+	{
+		++digits; // "0" alone is a number
+		c = next_char(reader);
+		if (c == 'x' || c == 'X')
 		{
-			fclose(fp);
-			return k;
+			c = next_char(reader);
+			digits = 0;
 		}
 	}
-	program_shrink(program);
-	fclose(fp);
-	return ERR_NONE;
+	for (; c != EOF && HEX_VALUES[c] != 0; c = next_char(reader))
+	{
+		if (v >> (64 - 4) != 0)
+			return 0; // does not fit in 64 bits
+		v = (v << 4) | (uint64_t)(HEX_VALUES[c] - 1);
+		++digits;
+	}
+	if (c != EOF)
+		unread_char(reader);
+	*value = v;
+	return digits > 0;
 }
 
-int fill_command(FILE *fp, command_t *command)
+//=========================================================================
+/**
+ * @brief Tool function to parse one command.
+ * @param reader the reader
+ * @param command (modified) the command read
+ * @return error code, or EOF when there is no more command
+ */
+static int parse_command(command_reader_t *reader, command_t *command)
 {
-	int n = 0;
-	char c;
-	while (isspace(c = fgetc(fp)))
-	{
-	}; // skipping the spaces in the begining or end of last line
+	int c = skip_spaces(reader); // skipping the spaces in the begining or end of last line
 	if (c == EOF)
 		return EOF; // if we have reached End of File
+	command->process = 0;
+	if (c == 'P')
+	{ // the process tag, in decimal
+		unsigned process = 0;
+		c = next_char(reader);
+		M_REQUIRE(c >= '0' && c <= '9', ERR_BAD_PARAMETER, "P must be followed by a process number, not by %c", c);
+		while (c >= '0' && c <= '9' && process < NB_ASIDS)
+		{
+			process = 10 * process + (unsigned)(c - '0');
+			c = next_char(reader);
+		}
+		M_REQUIRE(process < NB_ASIDS, ERR_BAD_PARAMETER, "process %u is not below %d", process, NB_ASIDS);
+		M_REQUIRE(is_space(c), ERR_BAD_PARAMETER, "the process must be followed by space but is followed by %c", c);
+		command->process = (asid_t)process;
+		c = skip_spaces(reader);
+	}
 	if (c == 'R')
 		command->order = READ;
 	else if (c == 'W')
-	{
 		command->order = WRITE;
-	}
 	else
-	{
 		M_EXIT(ERR_BAD_PARAMETER, "The command must start with R or W, starts with %c", c);
-	}
 
-	M_REQUIRE(isspace(c = fgetc(fp)), ERR_BAD_PARAMETER, "W or R must be followed by space but is followed by %c", c);
+	c = next_char(reader);
+	M_REQUIRE(is_space(c), ERR_BAD_PARAMETER, "W or R must be followed by space but is followed by %c", c);
 
-	while (isspace(c = fgetc(fp)))
-	{
-	}; // might have more spaces in between
+	c = skip_spaces(reader); // might have more spaces in between
 	switch (c)
 	{
 	case 'I':
-	{
 		command->type = INSTRUCTION;
 		command->data_size = sizeof(word_t);
-		M_REQUIRE(isspace(c = fgetc(fp)), ERR_BAD_PARAMETER, "I must be followed by space, but is followed by %c", c);
+		command->write_data = 0;
+		c = next_char(reader);
+		M_REQUIRE(is_space(c), ERR_BAD_PARAMETER, "I must be followed by space, but is followed by %c", c);
 		break;
-	}
 	case 'D':
 	{
 		command->type = DATA;
-		c = fgetc(fp);
-		M_REQUIRE((c == 'W') || (c == 'B'), ERR_BAD_PARAMETER, "Must specify data size word or byte character read is %c", c);
-		command->data_size = (c == 'W') ? sizeof(word_t) : 1;
+		c = next_char(reader);
+		const char *letter = c == EOF ? NULL : memchr(DATA_SIZE_LETTERS, c, NB_DATA_SIZES);
+		M_REQUIRE(letter != NULL, ERR_BAD_PARAMETER, "Must specify data size B, H, W, D or L, character read is %c", c);
+		command->data_size = (size_t)1 << (letter - DATA_SIZE_LETTERS);
+		command->write_data = 0;
 		if (command->order == WRITE)
 		{
-			uint32_t writeData;
-			M_REQUIRE(n = fscanf(fp, "%x" SCNx32, &writeData) == 1, ERR_BAD_PARAMETER, "number of 32 bits read is %d", n); // getting the write data
-			command->write_data = writeData;
+			M_REQUIRE(read_hex(reader, &command->write_data), ERR_BAD_PARAMETER, "no valid write data for a %s", "write"); // getting the write data
 		}
-		M_REQUIRE(isspace(c = fgetc(fp)), ERR_BAD_PARAMETER, "WRITEDATA must be followed by space but is followed by %c", c);
+		c = next_char(reader);
+		M_REQUIRE(is_space(c), ERR_BAD_PARAMETER, "WRITEDATA must be followed by space but is followed by %c", c);
 		break;
 	}
 	default:
-	{
 		M_EXIT_ERR(ERR_BAD_PARAMETER, "Must specify a type instruction I or data D, but character is %c", c);
 	}
-	}
-	while (isspace(c = fgetc(fp)))
-	{
-	}; // might have more spaces in between
+
+	c = skip_spaces(reader); // might have more spaces in between
 	M_REQUIRE(c == '@', ERR_ADDR, "virtadd  must start with @, first character is %c", c);
 	uint64_t vaddr = 0;
+	M_REQUIRE(read_hex(reader, &vaddr), ERR_BAD_PARAMETER, "no valid virtual address after %c", '@');
+
+	return command_set_vaddr(command, vaddr); // initialising the virtual address of the command
+}
 
-	M_REQUIRE(n = fscanf(fp, "%lx" SCNx64, &vaddr) == 1, ERR_BAD_PARAMETER, "number of 64 bits read is %d", n);
+//=========================================================================
+/**
+ * @brief Tool function to add all the commands of a reader to a program.
+ */
+static int parse_all(command_reader_t *reader, program_t *program)
+{
+	command_t command;
+	int k = ERR_NONE;
+	while ((k = parse_command(reader, &command)) != EOF)
+	{
+		M_EXIT_IF_ERR(k, "parsing a command");
+		M_EXIT_IF_ERR(program_add_command(program, &command), "adding a command");
+	}
+	return ERR_NONE;
+}
 
-	return init_virt_addr64(&(command->vaddr), vaddr); // initialising the virtual address of the command
+int program_read(const char *filename, program_t *program)
+{
+	M_REQUIRE_NON_NULL(filename);
+	M_EXIT_IF_ERR(program_init(program), "initialising the program");
+	command_reader_t reader = {NULL, NULL, 0, 0};
+	reader.file = trace_open(filename); // read mode, gzip-compressed or not
+	unsigned char *buffer = malloc(READ_BUFFER_SIZE);
+	reader.buffer = buffer;
+	int err = reader.file == NULL ? ERR_IO : (buffer == NULL ? ERR_MEM : ERR_NONE);
+	if (err == ERR_NONE)
+		err = parse_all(&reader, program);
+	if (err == ERR_NONE && trace_error(reader.file))
+		err = ERR_IO;
+
+	if (reader.file != NULL)
+		trace_close(reader.file);
+	free(buffer);
+	if (err != ERR_NONE)
+	{
+		program_free(program);
+		return err;
+	}
+	return program_shrink(program);
+}
+
+int program_parse(const char *text, size_t length, program_t *program)
+{
+	M_REQUIRE_NON_NULL(text);
+	M_EXIT_IF_ERR(program_init(program), "initialising the program");
+	command_reader_t reader = {NULL, (const unsigned char *)text, 0, length};
+	const int err = parse_all(&reader, program);
+	if (err != ERR_NONE)
+	{
+		program_free(program);
+		return err;
+	}
+	return program_shrink(program);
 }
 
 int program_free(program_t *program)
@@ -15,6 +15,15 @@
 
 #define START_SIZE 10
 
+/* sizes (in bytes) of the data a command can access:
+ * byte (DB), halfword (DH), word (DW), doubleword (DD) and full cache line (DL) */
+#define DATA_SIZE_BYTE 1
+#define DATA_SIZE_HALF 2
+#define DATA_SIZE_WORD 4
+#define DATA_SIZE_DOUBLE 8
+#define DATA_SIZE_LINE 16
+#define DATA_SIZE_MAX DATA_SIZE_LINE
+
 /* TODO WEEK 05:
  * Définir ici les types
  *      command_word_t
@@ -33,19 +42,28 @@ typedef enum
 
 /** 
  * @brief a structure representing an abstraction of an assembly instruction
+ * write_data holds up to a doubleword; a full line write (DL) stores
+ * write_data twice, as a memset-like fill pattern.
+ * The virtual address is carried both as a structure and as a number, so
+ * that the simulator does not have to convert it on every access.
+ * In the text format, a command of another process than 0 starts with P
+ * followed by the process number, e.g. "P3 R DW @0x...", so that the traces
+ * of several processes can be interleaved.
  **/
 typedef struct
 {
 	command_word_t order;
 	mem_access_t type;
 	size_t data_size;
-	word_t write_data;
+	uint64_t write_data;
 	virt_addr_t vaddr;
+	uint64_t vaddr64; // vaddr as a number; both are set together by command_set_vaddr()
+	asid_t process;	  // the process issuing the command, i.e. its address space (0 if untagged)
 } command_t;
 
 /** 
  * @brief a structure representing an abstraction of a list of assembly code
- * the maximal number of instructions for now is 100
+ * (allocated is the size of listing, in bytes)
  **/
 
 typedef struct
@@ -70,6 +88,14 @@ typedef struct
 	const command_t *end_pgm_ = (P)->listing + (P)->nb_lines; \
 	for (const command_t *X = (P)->listing; X < end_pgm_; ++X)
 
+/**
+ * @brief Set the virtual address of a command, in both of its forms.
+ * @param command (modified) the command
+ * @param vaddr64 the virtual address, as a number
+ * @return ERR_NONE if ok, appropriate error code otherwise (e.g. reserved bits set).
+ */
+int command_set_vaddr(command_t *command, uint64_t vaddr64);
+
 /**
  * @brief "Constructor" for program_t: initialize a program.
  * @param program (modified) the program to be initialized.
@@ -100,6 +126,14 @@ int program_shrink(program_t *program);
  */
 int program_print(FILE *output, const program_t *program);
 
+/**
+ * @brief Print one command to a stream, in the text format read by program_read().
+ * @param output the stream to print to.
+ * @param command the command to be printed.
+ * @return ERR_NONE if ok, appropriate error code otherwise.
+ */
+int command_print(FILE *output, const command_t *command);
+
 /**
  * @brief Read a program (list of commands) from a file.
  * @param filename the name of the file to read from.
@@ -109,6 +143,15 @@ int program_print(FILE *output, const program_t *program);
 
 int program_read(const char *filename, program_t *program);
 
+/**
+ * @brief Read a program (list of commands) from a text in memory, with the same format as program_read().
+ * @param text the text to parse (not necessarily null terminated).
+ * @param length the number of characters of the text.
+ * @param program the program to be filled from the text.
+ * @return ERR_NONE if ok, appropriate error code otherwise.
+ */
+int program_parse(const char *text, size_t length, program_t *program);
+
 /**
  * @brief "Destructor" for program_t: free its content.
  * @param program the program to be filled from file.
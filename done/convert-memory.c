@@ -0,0 +1,60 @@
+/**
+ * @file convert-memory.c
+ * @brief convert a memory description, either packing it and its page files
+ *        into one memory image (see memory.h), or loading it into a memory dump
+ *
+ * @date 2019
+ */
+
+#if defined _WIN32  || defined _WIN64
+#define __USE_MINGW_ANSI_STDIO 1
+#endif
+
+#include "error.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ======================================================================
+static void usage(const char* pgm)
+{
+    fprintf(stderr, "usage:    %s (image|dump) description_filename output_filename [nb_threads]\n", pgm);
+    fprintf(stderr, "          image: packs the description and its pages, to be given instead of the description\n");
+    fprintf(stderr, "          dump:  writes the whole memory described, its pages read by nb_threads threads\n");
+    fprintf(stderr, "example:  %s image memory-desc-02.txt memory-02.img\n", pgm);
+}
+
+// ======================================================================
+static int write_dump(const char* description, const char* filename, size_t nb_threads)
+{
+    void* mem_space = NULL;
+    size_t mem_size = 0;
+    M_EXIT_IF_ERR(mem_init_from_description_parallel(description, &mem_space, &mem_size, nb_threads),
+                  "loading the description");
+    FILE* output = fopen(filename, "wb");
+    int err = output == NULL ? ERR_IO : ERR_NONE;
+    if (err == ERR_NONE && fwrite(mem_space, mem_size, 1, output) != 1) err = ERR_IO;
+    if (output != NULL && fclose(output) != 0 && err == ERR_NONE) err = ERR_IO;
+    free(mem_space);
+    return err;
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    if (argc < 4 || (strcmp(argv[1], "image") && strcmp(argv[1], "dump"))) {
+        usage(argv[0]);
+        return 1;
+    }
+    const size_t nb_threads = argc > 4 ? strtoul(argv[4], NULL, 0) : 4;
+
+    const int err = strcmp(argv[1], "dump") ? mem_image_from_description(argv[2], argv[3])
+                                            : write_dump(argv[2], argv[3], nb_threads);
+    if (err != ERR_NONE) {
+        fprintf(stderr, "ERROR: %s\n", ERR_MESSAGES[err - ERR_NONE]);
+        return 2;
+    }
+    return 0;
+}
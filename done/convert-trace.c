@@ -0,0 +1,68 @@
+/**
+ * @file convert-trace.c
+ * @brief convert a trace between the text format and the binary one (see trace_bin.h)
+ *
+ * @date 2019
+ */
+
+#if defined _WIN32  || defined _WIN64
+#define __USE_MINGW_ANSI_STDIO 1
+#endif
+
+#include "error.h"
+#include "commands.h"
+#include "trace_bin.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ======================================================================
+static void usage(const char* pgm)
+{
+    fprintf(stderr, "usage:    %s (text|bin) input_trace output_trace\n", pgm);
+    fprintf(stderr, "          converts the input trace (text or binary, detected) to the given format\n");
+    fprintf(stderr, "example:  %s bin commands01.txt commands01.bin\n", pgm);
+}
+
+// ======================================================================
+static int write_binary(const program_t* program, const char* filename)
+{
+    trace_bin_writer_t writer;
+    M_EXIT_IF_ERR(trace_bin_writer_open(&writer, filename), "creating the binary trace");
+    int err = ERR_NONE;
+    for_all_lines(line, program) {
+        if ((err = trace_bin_write(&writer, line)) != ERR_NONE) break;
+    }
+    const int close_err = trace_bin_writer_close(&writer);
+    return err == ERR_NONE ? close_err : err;
+}
+
+// ======================================================================
+static int write_text(const program_t* program, const char* filename)
+{
+    FILE* output = fopen(filename, "w");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(output, ERR_IO);
+    const int err = program_print(output, program);
+    if (fclose(output) != 0 && err == ERR_NONE) return ERR_IO;
+    return err;
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    if (argc < 4 || (strcmp(argv[1], "text") && strcmp(argv[1], "bin"))) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    program_t program;
+    int err = program_read_any(argv[2], &program);
+    if (err != ERR_NONE) {
+        fprintf(stderr, "ERROR: %s\n", ERR_MESSAGES[err - ERR_NONE]);
+        return 2;
+    }
+    err = strcmp(argv[1], "bin") ? write_text(&program, argv[3]) : write_binary(&program, argv[3]);
+    if (err != ERR_NONE) fprintf(stderr, "ERROR: %s\n", ERR_MESSAGES[err - ERR_NONE]);
+    program_free(&program);
+    return err == ERR_NONE ? 0 : 2;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file decode-state.c
+ * @brief render binary state dumps (see state_dump.h) as text, or compare two of them
+ *
+ * @date 2019
+ */
+
+#if defined _WIN32  || defined _WIN64
+#define __USE_MINGW_ANSI_STDIO 1
+#endif
+#define _POSIX_C_SOURCE 200809L // for open_memstream()
+
+#include "error.h"
+#include "state_dump.h"
+#include "util.h" // for SIZE_T_FMT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ======================================================================
+static void usage(const char* pgm)
+{
+    fprintf(stderr, "usage:    %s print dump_filename [structure...]\n", pgm);
+    fprintf(stderr, "          %s diff dump_filename other_dump_filename [structure...]\n", pgm);
+    fprintf(stderr, "          structures: L1_ITLB L1_DTLB L2_TLB L1_ICACHE L1_DCACHE L2_CACHE (all by default)\n");
+    fprintf(stderr, "          diff exits with 1 when the dumps differ\n");
+    fprintf(stderr, "example:  %s print states.bin L1_ICACHE L1_DCACHE L2_CACHE\n", pgm);
+}
+
+// ======================================================================
+// the structures named on the command line, all of them if none is
+static int read_shown(int argc, char* argv[], int shown[NB_STATE_SECTIONS])
+{
+    for (int i = 0; i < NB_STATE_SECTIONS; ++i)
+        shown[i] = argc == 0;
+    for (int i = 0; i < argc; ++i) {
+        state_section_t section;
+        if (state_section_from_name(argv[i], &section) != ERR_NONE) {
+            fprintf(stderr, "ERROR: unknown structure \"%s\"\n", argv[i]);
+            return ERR_BAD_PARAMETER;
+        }
+        shown[section] = 1;
+    }
+    return ERR_NONE;
+}
+
+// ======================================================================
+static int print_dumps(FILE* input, const int shown[NB_STATE_SECTIONS])
+{
+    static sim_state_t state;
+    int err = ERR_NONE;
+    while ((err = state_dump_read(input, &state)) == ERR_NONE) {
+        M_EXIT_IF_ERR(state_print(stdout, &state, shown), "printing a dump");
+        printf("\n=======================================\n\n");
+    }
+    return err == ERR_EOF ? ERR_NONE : err;
+}
+
+// ======================================================================
+static int diff_dumps(FILE* first, FILE* second, const int shown[NB_STATE_SECTIONS], size_t* nb_diffs)
+{
+    static sim_state_t state1;
+    static sim_state_t state2;
+    *nb_diffs = 0;
+    for (size_t index = 0; ; ++index) {
+        const int err1 = state_dump_read(first, &state1);
+        const int err2 = state_dump_read(second, &state2);
+        if (err1 != ERR_NONE && err1 != ERR_EOF) return err1;
+        if (err2 != ERR_NONE && err2 != ERR_EOF) return err2;
+        if (err1 == ERR_EOF && err2 == ERR_EOF) return ERR_NONE;
+        if (err1 == ERR_EOF || err2 == ERR_EOF) {
+            printf("dump " SIZE_T_FMT ": only in the %s file\n", index, err1 == ERR_EOF ? "second" : "first");
+            ++*nb_diffs;
+            return ERR_NONE;
+        }
+
+        // the differences are printed in a buffer, so as to name the dump first
+        char* text = NULL;
+        size_t text_size = 0;
+        FILE* diffs = open_memstream(&text, &text_size);
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(diffs, ERR_MEM);
+        size_t nb = 0;
+        const int err = state_diff(diffs, &state1, &state2, shown, &nb);
+        fclose(diffs);
+        if (err == ERR_NONE && nb > 0)
+            printf("dump " SIZE_T_FMT ": \n%s", index, text);
+        free(text);
+        M_EXIT_IF_ERR(err, "comparing two dumps");
+        *nb_diffs += nb;
+    }
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    const int diff = argc > 1 && !strcmp(argv[1], "diff");
+    if (argc < 3 + diff || (!diff && strcmp(argv[1], "print"))) {
+        usage(argv[0]);
+        return 2;
+    }
+    int shown[NB_STATE_SECTIONS];
+    if (read_shown(argc - 3 - diff, argv + 3 + diff, shown) != ERR_NONE) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE* inputs[2] = {NULL, NULL};
+    for (int i = 0; i <= diff; ++i) {
+        inputs[i] = fopen(argv[2 + i], "rb");
+        if (inputs[i] == NULL) {
+            fprintf(stderr, "ERROR: cannot open \"%s\"\n", argv[2 + i]);
+            if (i > 0) fclose(inputs[0]);
+            return 2;
+        }
+    }
+
+    size_t nb_diffs = 0;
+    const int err = diff ? diff_dumps(inputs[0], inputs[1], shown, &nb_diffs)
+                         : print_dumps(inputs[0], shown);
+    for (int i = 0; i <= diff; ++i)
+        fclose(inputs[i]);
+    if (err != ERR_NONE) {
+        fprintf(stderr, "ERROR: %s\n", ERR_MESSAGES[err - ERR_NONE]);
+        return 2;
+    }
+    return nb_diffs > 0;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * @file dump_buf.h
+ * @brief output buffer of the dumps (see cache_dump(), tlb_dump() and vmem_page_dump())
+ *
+ * The lines of a dump are rendered into a buffer, numbers in hexadecimal
+ * through a digit table, and the buffer is written with a single fwrite()
+ * each time it fills up, instead of one printf() per field or byte.
+ *
+ * @date 2019
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h> // for size_t
+#include <string.h> // for memcpy(), strlen()
+
+#define DUMP_BUF_SIZE 32768
+#define DUMP_BUF_MAX_NUMBER 32 // the most characters a number may take, %p included
+
+typedef struct
+{
+    FILE *output;
+    size_t len;
+    char data[DUMP_BUF_SIZE];
+} dump_buf_t;
+
+static const char dump_hex_lower[] = "0123456789abcdef";
+static const char dump_hex_upper[] = "0123456789ABCDEF";
+
+/**
+ * @brief write (and empty) the buffer
+ */
+static inline void dump_buf_flush(dump_buf_t *buf)
+{
+    if (buf->len > 0)
+        (void)fwrite(buf->data, 1, buf->len, buf->output);
+    buf->len = 0;
+}
+
+static inline void dump_buf_init(dump_buf_t *buf, FILE *output)
+{
+    buf->output = output;
+    buf->len = 0;
+}
+
+/**
+ * @brief make room for n more characters, n being at most DUMP_BUF_SIZE
+ */
+static inline void dump_buf_reserve(dump_buf_t *buf, size_t n)
+{
+    if (buf->len + n > DUMP_BUF_SIZE)
+        dump_buf_flush(buf);
+}
+
+static inline void dump_buf_putc(dump_buf_t *buf, char c)
+{
+    dump_buf_reserve(buf, 1);
+    buf->data[buf->len++] = c;
+}
+
+static inline void dump_buf_puts(dump_buf_t *buf, const char *s)
+{
+    size_t n = strlen(s);
+    while (n > DUMP_BUF_SIZE - buf->len)
+    { // longer than the room left: by pieces
+        const size_t part = DUMP_BUF_SIZE - buf->len;
+        memcpy(buf->data + buf->len, s, part);
+        buf->len += part;
+        s += part;
+        n -= part;
+        dump_buf_flush(buf);
+    }
+    memcpy(buf->data + buf->len, s, n);
+    buf->len += n;
+}
+
+/**
+ * @brief a number in hexadecimal, as printf("%0<min_digits>x") (DIGITS being
+ * dump_hex_lower) or printf("%0<min_digits>X") (DIGITS being dump_hex_upper) would
+ */
+static inline void dump_buf_hex(dump_buf_t *buf, uint64_t value, unsigned min_digits, const char *digits)
+{
+    unsigned nb = 1;
+    while (nb < 16 && (value >> (4 * nb)) != 0)
+        ++nb;
+    if (nb < min_digits)
+        nb = min_digits < DUMP_BUF_MAX_NUMBER ? min_digits : DUMP_BUF_MAX_NUMBER;
+    dump_buf_reserve(buf, nb);
+    for (unsigned i = nb; i > 0; --i)
+    {
+        buf->data[buf->len + i - 1] = digits[value & 0xF];
+        value >>= 4;
+    }
+    buf->len += nb;
+}
+
+/**
+ * @brief a byte as two upper-case hexadecimal digits, as printf("%02X")
+ */
+static inline void dump_buf_byte(dump_buf_t *buf, uint8_t byte)
+{
+    dump_buf_reserve(buf, 2);
+    buf->data[buf->len++] = dump_hex_upper[byte >> 4];
+    buf->data[buf->len++] = dump_hex_upper[byte & 0xF];
+}
+
+/**
+ * @brief a number in decimal, as printf("%zu")
+ */
+static inline void dump_buf_dec(dump_buf_t *buf, size_t value)
+{
+    char digits[DUMP_BUF_MAX_NUMBER];
+    size_t nb = 0;
+    do
+    {
+        digits[nb++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    dump_buf_reserve(buf, nb);
+    while (nb > 0)
+        buf->data[buf->len++] = digits[--nb];
+}
+
+/**
+ * @brief a pointer, as printf("%p"), whose format is up to the C library
+ */
+static inline void dump_buf_ptr(dump_buf_t *buf, const void *ptr)
+{
+    dump_buf_reserve(buf, DUMP_BUF_MAX_NUMBER);
+    const int n = snprintf(buf->data + buf->len, DUMP_BUF_MAX_NUMBER, "%p", ptr);
+    if (n > 0)
+        buf->len += (size_t)(n < DUMP_BUF_MAX_NUMBER ? n : DUMP_BUF_MAX_NUMBER - 1);
+}
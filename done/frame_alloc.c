@@ -0,0 +1,54 @@
+/**
+ * @file frame_alloc.c
+ * @brief physical frame allocator for demand paging
+ *
+ * @date 2019
+ */
+#include "frame_alloc.h"
+#include "page_walk.h" // for PAGE_WALK_LEVELS
+#include "error.h"
+#include "util.h"
+
+#include <inttypes.h> // for PRIx64
+#include <string.h>   // for memset()
+
+int frame_allocator_init(frame_allocator_t *frames, void *mem_space, size_t mem_size, uint64_t first_free)
+{
+    M_REQUIRE_NON_NULL(frames);
+    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE(first_free % PAGE_SIZE == 0 && first_free <= mem_size, ERR_ADDR,
+              "first free frame 0x%" PRIx64 " is not a page of memory", first_free);
+    zero_init_ptr(frames);
+    frames->mem_space = mem_space;
+    frames->mem_size = mem_size;
+    frames->next_frame = first_free;
+    return ERR_NONE;
+}
+
+int frame_alloc(frame_allocator_t *frames, pte_t *frame)
+{
+    M_REQUIRE_NON_NULL(frames);
+    M_REQUIRE_NON_NULL(frame);
+    M_REQUIRE(frames->next_frame + PAGE_SIZE <= frames->mem_size, ERR_MEM,
+              "no free frame left in %zu bytes of memory", frames->mem_size);
+    memset(frames->mem_space + frames->next_frame, 0, PAGE_SIZE);
+    *frame = (pte_t)frames->next_frame;
+    frames->next_frame += PAGE_SIZE;
+    return ERR_NONE;
+}
+
+int frame_fault(void *arg, pte_t table, uint16_t index, int level, pte_t *entry)
+{
+    M_REQUIRE_NON_NULL(arg);
+    M_REQUIRE_NON_NULL(entry);
+    M_REQUIRE(level >= 0 && level < PAGE_WALK_LEVELS, ERR_BAD_PARAMETER, "page-table level %d", level);
+    frame_allocator_t *frames = arg;
+    M_REQUIRE((uint64_t)table + (index + 1) * sizeof(pte_t) <= frames->mem_size, ERR_ADDR,
+              "page table 0x%" PRIx32 " is outside of memory", table);
+
+    pte_t frame = 0;
+    M_EXIT_IF_ERR(frame_alloc(frames, &frame), "allocating a frame");
+    *entry = frame | PTE_PRESENT;
+    ((pte_t *)(frames->mem_space + table))[index] = *entry;
+    return ERR_NONE;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+/**
+ * @file frame_alloc.h
+ * @brief physical frame allocator for demand paging
+ *
+ * The frames are handed out in address order from a first free one up to
+ * the end of memory and are never given back: a simulated process only
+ * grows. frame_fault() builds the missing page tables and pages on first
+ * touch (see page_fault_handler_t in page_walk.h).
+ *
+ * @date 2019
+ */
+
+#include "addr.h"
+
+#include <stdint.h>
+#include <stddef.h> // for size_t
+
+/**
+ * @brief a frame allocator over a memory space
+ */
+typedef struct
+{
+    byte_t *mem_space;
+    size_t mem_size;
+    uint64_t next_frame; // physical address of the next free frame
+} frame_allocator_t;
+
+//=========================================================================
+/**
+ * @brief Initialize a frame allocator.
+ * @param frames (modified) the allocator
+ * @param mem_space the memory space, whose frames are handed out
+ * @param mem_size its size, in bytes
+ * @param first_free physical address of the first free frame, page aligned
+ * @return error code
+ */
+int frame_allocator_init(frame_allocator_t *frames, void *mem_space, size_t mem_size, uint64_t first_free);
+
+//=========================================================================
+/**
+ * @brief Take a free frame, filled with zeros.
+ * @param frames the allocator
+ * @param frame (modified) physical address of the frame
+ * @return error code, ERR_MEM once memory is full
+ */
+int frame_alloc(frame_allocator_t *frames, pte_t *frame);
+
+//=========================================================================
+/**
+ * @brief Page-fault handler (see page_walk.h) for an allocator: the missing
+ *        page table or page gets a new frame, and the entry becomes present.
+ * @param arg the allocator
+ * @param table physical address of the page table holding the entry
+ * @param index index of the entry in that table
+ * @param level level of the table, 0 for the PGD
+ * @param entry (modified) the new entry
+ * @return error code
+ */
+int frame_fault(void *arg, pte_t table, uint16_t index, int level, pte_t *entry);
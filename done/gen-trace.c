@@ -0,0 +1,131 @@
+/**
+ * @file gen-trace.c
+ * @brief command-line front end of the synthetic trace generator
+ *
+ * Writes "<prefix>-commands.txt" (a program in the text format), or
+ * "<prefix>-commands.bin" with format=bin (see trace_bin.h), and the
+ * matching memory description "<prefix>-desc.txt" with its page files.
+ *
+ * @date 2019
+ */
+
+#if defined _WIN32  || defined _WIN64
+#define __USE_MINGW_ANSI_STDIO 1
+#endif
+
+#include "error.h"
+#include "commands.h"
+#include "trace_gen.h"
+#include "trace_bin.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FILENAME 100
+
+// ======================================================================
+static void usage(const char* pgm)
+{
+    fprintf(stderr, "usage:    %s pattern nb_commands prefix [key=value...]\n", pgm);
+    fprintf(stderr, "patterns: sequential stride random chase zipf mix\n");
+    fprintf(stderr, "keys:     pages base size stride zipf writes instr seed format(=txt|bin)\n");
+    fprintf(stderr, "example:  %s zipf 1000000 /tmp/zipf pages=1024 zipf=1.2 writes=10\n", pgm);
+}
+
+// ======================================================================
+static int set_option(gen_config_t* config, int* binary, const char* option)
+{
+    const char* value = strchr(option, '=');
+    if (value == NULL) return ERR_BAD_PARAMETER;
+    const size_t key_len = (size_t)(value - option);
+    ++value;
+#define key_is(K) (key_len == strlen(K) && !strncmp(option, K, key_len))
+    if (key_is("pages"))       config->nb_pages = strtoul(value, NULL, 0);
+    else if (key_is("base"))   config->base = strtoull(value, NULL, 0);
+    else if (key_is("size"))   config->data_size = strtoul(value, NULL, 0);
+    else if (key_is("stride")) config->stride = strtoul(value, NULL, 0);
+    else if (key_is("zipf"))   config->zipf_s = strtod(value, NULL);
+    else if (key_is("writes")) config->write_percent = (unsigned)strtoul(value, NULL, 0);
+    else if (key_is("instr"))  config->instr_percent = (unsigned)strtoul(value, NULL, 0);
+    else if (key_is("seed"))   config->seed = strtoull(value, NULL, 0);
+    else if (key_is("format") && !strcmp(value, "txt")) *binary = 0;
+    else if (key_is("format") && !strcmp(value, "bin")) *binary = 1;
+    else return ERR_BAD_PARAMETER;
+#undef key_is
+    return ERR_NONE;
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        usage(argv[0]);
+        return 1;
+    }
+    int pattern = 0;
+    while (pattern < NB_GEN_PATTERNS && strcmp(argv[1], GEN_PATTERN_NAMES[pattern]))
+        ++pattern;
+    if (pattern == NB_GEN_PATTERNS) {
+        fprintf(stderr, "ERROR: unknown pattern \"%s\"\n", argv[1]);
+        usage(argv[0]);
+        return 1;
+    }
+
+    gen_config_t config;
+    gen_config_init(&config, (gen_pattern_t) pattern);
+    config.nb_commands = strtoul(argv[2], NULL, 0);
+    int binary = 0;
+    for (int i = 4; i < argc; ++i) {
+        if (set_option(&config, &binary, argv[i]) != ERR_NONE) {
+            fprintf(stderr, "ERROR: bad option \"%s\"\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const char* prefix = argv[3];
+    char filename[MAX_FILENAME];
+    const char* extension = binary ? "bin" : "txt";
+    if (snprintf(filename, sizeof(filename), "%s-commands.%s", prefix, extension) >= (int) sizeof(filename)) {
+        fprintf(stderr, "ERROR: prefix \"%s\" is too long\n", prefix);
+        return 1;
+    }
+
+    int err = gen_write_memory(&config, prefix);
+    gen_t gen;
+    if (err == ERR_NONE) err = gen_init(&gen, &config);
+    if (err == ERR_NONE && binary) {
+        trace_bin_writer_t writer;
+        err = trace_bin_writer_open(&writer, filename);
+        if (err == ERR_NONE) {
+            command_t command;
+            while (err == ERR_NONE && (err = gen_next(&gen, &command)) == ERR_NONE)
+                err = trace_bin_write(&writer, &command);
+            if (err == ERR_EOF) err = ERR_NONE;
+            const int close_err = trace_bin_writer_close(&writer);
+            if (err == ERR_NONE) err = close_err;
+        }
+        gen_free(&gen);
+    } else if (err == ERR_NONE) {
+        FILE* output = fopen(filename, "w");
+        if (output == NULL) {
+            err = ERR_IO;
+        } else {
+            command_t command;
+            while (err == ERR_NONE && (err = gen_next(&gen, &command)) == ERR_NONE)
+                err = command_print(output, &command) == ERR_NONE ? ERR_NONE : ERR_IO;
+            if (err == ERR_EOF) err = ERR_NONE;
+            if (fclose(output) != 0 && err == ERR_NONE) err = ERR_IO;
+        }
+        gen_free(&gen);
+    }
+
+    if (err != ERR_NONE) {
+        fprintf(stderr, "ERROR: %s\n", ERR_MESSAGES[err - ERR_NONE]);
+        return 2;
+    }
+    printf("%s-commands.%s: %zu %s commands over %zu pages\n", prefix, extension, config.nb_commands, argv[1], config.nb_pages);
+    printf("%s-desc.txt: matching memory description\n", prefix);
+    return 0;
+}
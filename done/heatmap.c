@@ -0,0 +1,174 @@
+/**
+ * @file heatmap.c
+ * @brief locality instrumentation: per-set and per-page counters
+ *
+ * @date 2019
+ */
+
+#include "heatmap.h"
+#include "error.h"
+#include "util.h"
+
+#include <inttypes.h> // for PRIu64, PRIx64
+#include <stdlib.h>   // for calloc(), free(), qsort()
+#include <string.h>   // for memset()
+
+#define HISTOGRAM_START_CAPACITY 256
+#define MAX_FILENAME 100
+
+// Fibonacci hashing: the top bits of the product are well mixed
+#define vpn_hash(VPN, CAPACITY) ((size_t)(((VPN)*UINT64_C(0x9E3779B97F4A7C15)) >> 32) & ((CAPACITY)-1))
+
+static const char *const CACHE_NAMES[] = {"l1_icache", "l1_dcache", "l2_cache"};
+static const char *const TLB_NAMES[NB_HEAT_TLBS] = {"l1_itlb", "l1_dtlb", "l2_tlb"};
+
+int heatmap_init(heatmap_t *heatmap)
+{
+    M_REQUIRE_NON_NULL(heatmap);
+    zero_init_ptr(heatmap);
+    return ERR_NONE;
+}
+
+int heatmap_free(heatmap_t *heatmap)
+{
+    M_REQUIRE_NON_NULL(heatmap);
+    for (int tlb = 0; tlb < NB_HEAT_TLBS; ++tlb)
+        free(heatmap->tlbs[tlb].slots);
+    zero_init_ptr(heatmap);
+    return ERR_NONE;
+}
+
+int heatmap_clear(heatmap_t *heatmap)
+{
+    M_REQUIRE_NON_NULL(heatmap);
+    zero_init_var(heatmap->caches);
+    for (int tlb = 0; tlb < NB_HEAT_TLBS; ++tlb)
+    {
+        vpn_histogram_t *histogram = &heatmap->tlbs[tlb];
+        if (histogram->slots != NULL)
+            memset(histogram->slots, 0, histogram->capacity * sizeof(vpn_counter_t));
+        histogram->size = 0;
+    }
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to find the slot of a page (or the free slot where it belongs).
+ */
+static vpn_counter_t *find_slot(vpn_counter_t *slots, size_t capacity, uint64_t vpn)
+{
+    size_t i = vpn_hash(vpn, capacity);
+    while (slots[i].misses != 0 && slots[i].vpn != vpn)
+        i = (i + 1) & (capacity - 1);
+    return &slots[i];
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to double the capacity of a histogram (or to allocate it).
+ */
+static int grow(vpn_histogram_t *histogram)
+{
+    const size_t capacity = histogram->capacity == 0 ? HISTOGRAM_START_CAPACITY : 2 * histogram->capacity;
+    vpn_counter_t *slots = calloc(capacity, sizeof(vpn_counter_t));
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(slots, ERR_MEM);
+    for (size_t i = 0; i < histogram->capacity; ++i)
+        if (histogram->slots[i].misses != 0)
+            *find_slot(slots, capacity, histogram->slots[i].vpn) = histogram->slots[i];
+    free(histogram->slots);
+    histogram->slots = slots;
+    histogram->capacity = capacity;
+    return ERR_NONE;
+}
+
+int heatmap_tlb_miss(heatmap_t *heatmap, enum heat_tlb tlb, uint64_t vpn)
+{
+    M_REQUIRE_NON_NULL(heatmap);
+    M_REQUIRE(tlb >= HEAT_L1_ITLB && tlb < NB_HEAT_TLBS, ERR_BAD_PARAMETER, "unknown TLB %d", tlb);
+    vpn_histogram_t *histogram = &heatmap->tlbs[tlb];
+    if (2 * (histogram->size + 1) > histogram->capacity) // load factor at most 1/2
+    {
+        M_EXIT_IF_ERR(grow(histogram), "growing the page histogram");
+    }
+    vpn_counter_t *slot = find_slot(histogram->slots, histogram->capacity, vpn);
+    if (slot->misses == 0)
+    {
+        slot->vpn = vpn;
+        ++histogram->size;
+    }
+    ++slot->misses;
+    return ERR_NONE;
+}
+
+int heatmap_write_sets_csv(FILE *output, const heatmap_t *heatmap)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(heatmap);
+    const set_counters_t *caches[] = {heatmap->caches.l1_icache, heatmap->caches.l1_dcache, heatmap->caches.l2_cache};
+    const size_t nb_sets[] = {L1_ICACHE_LINES, L1_DCACHE_LINES, L2_CACHE_LINES};
+    fprintf(output, "cache,set,hits,misses,evictions\n");
+    for (size_t c = 0; c < sizeof(caches) / sizeof(caches[0]); ++c)
+        for (size_t set = 0; set < nb_sets[c]; ++set)
+            fprintf(output, "%s,%zu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n", CACHE_NAMES[c], set,
+                    caches[c][set].hits, caches[c][set].misses, caches[c][set].evictions);
+    return ferror(output) ? ERR_IO : ERR_NONE;
+}
+
+static int compare_vpn(const void *a, const void *b)
+{
+    const uint64_t va = ((const vpn_counter_t *)a)->vpn;
+    const uint64_t vb = ((const vpn_counter_t *)b)->vpn;
+    return (va > vb) - (va < vb);
+}
+
+int heatmap_write_pages_csv(FILE *output, const heatmap_t *heatmap)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(heatmap);
+    fprintf(output, "tlb,vpn,misses\n");
+    for (int tlb = 0; tlb < NB_HEAT_TLBS; ++tlb)
+    {
+        const vpn_histogram_t *histogram = &heatmap->tlbs[tlb];
+        if (histogram->size == 0)
+            continue;
+        vpn_counter_t *pages = calloc(histogram->size, sizeof(vpn_counter_t));
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(pages, ERR_MEM);
+        size_t n = 0;
+        for (size_t i = 0; i < histogram->capacity; ++i)
+            if (histogram->slots[i].misses != 0)
+                pages[n++] = histogram->slots[i];
+        qsort(pages, n, sizeof(vpn_counter_t), compare_vpn);
+        for (size_t i = 0; i < n; ++i)
+            fprintf(output, "%s,0x%09" PRIx64 ",%" PRIu64 "\n", TLB_NAMES[tlb], pages[i].vpn, pages[i].misses);
+        free(pages);
+    }
+    return ferror(output) ? ERR_IO : ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to write one CSV file of a heatmap.
+ */
+static int save_csv(const char *prefix, const char *suffix, const heatmap_t *heatmap,
+                    int (*write)(FILE *, const heatmap_t *))
+{
+    char filename[MAX_FILENAME];
+    M_REQUIRE(snprintf(filename, sizeof(filename), "%s%s", prefix, suffix) < (int)sizeof(filename),
+              ERR_BAD_PARAMETER, "prefix \"%s\" is too long", prefix);
+    FILE *output = fopen(filename, "w");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(output, ERR_IO);
+    const int err = write(output, heatmap);
+    if (fclose(output) != 0 && err == ERR_NONE)
+        return ERR_IO;
+    return err;
+}
+
+int heatmap_save(const char *prefix, const heatmap_t *heatmap)
+{
+    M_REQUIRE_NON_NULL(prefix);
+    M_REQUIRE_NON_NULL(heatmap);
+    M_EXIT_IF_ERR(save_csv(prefix, "-sets.csv", heatmap, heatmap_write_sets_csv), "writing the set counters");
+    M_EXIT_IF_ERR(save_csv(prefix, "-pages.csv", heatmap, heatmap_write_pages_csv), "writing the page counters");
+    return ERR_NONE;
+}
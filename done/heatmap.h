@@ -0,0 +1,139 @@
+#pragma once
+
+/**
+ * @file heatmap.h
+ * @brief locality instrumentation: per-set hit/miss/eviction counters of
+ *        each cache and per-virtual-page miss counters of each TLB
+ *
+ * The counters are only updated while a heatmap is attached to a simulator
+ * (sim_enable_heatmap()); the cost is then a few increments per access,
+ * plus a hash table update per TLB miss.
+ *
+ * @date 2019
+ */
+
+#include "cache.h"
+#include "mem_access.h"
+
+#include <stdio.h>  // for FILE
+#include <stdint.h>
+#include <stddef.h> // for size_t
+
+/**
+ * @brief counters of one cache set
+ */
+typedef struct
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions; // valid entries replaced (moved to L2 for L1, dropped for L2)
+} set_counters_t;
+
+/**
+ * @brief counters of every set of every cache
+ */
+typedef struct
+{
+    set_counters_t l1_icache[L1_ICACHE_LINES];
+    set_counters_t l1_dcache[L1_DCACHE_LINES];
+    set_counters_t l2_cache[L2_CACHE_LINES];
+} cache_heatmap_t;
+
+/**
+ * @brief number of misses of one virtual page
+ */
+typedef struct
+{
+    uint64_t vpn;
+    uint64_t misses; // 0 for a free slot of the table
+} vpn_counter_t;
+
+/**
+ * @brief misses per virtual page number, in an open-addressing hash table
+ */
+typedef struct
+{
+    vpn_counter_t *slots;
+    size_t capacity; // a power of 2
+    size_t size;     // number of pages with misses
+} vpn_histogram_t;
+
+enum heat_tlb
+{
+    HEAT_L1_ITLB,
+    HEAT_L1_DTLB,
+    HEAT_L2_TLB,
+    NB_HEAT_TLBS // not a TLB but the number of TLBs
+};
+
+/**
+ * @brief all the locality counters of a simulator
+ */
+typedef struct
+{
+    cache_heatmap_t caches;
+    vpn_histogram_t tlbs[NB_HEAT_TLBS];
+} heatmap_t;
+
+//=========================================================================
+/**
+ * @brief "Constructor" for heatmap_t: all counters at 0.
+ * @param heatmap (modified) the heatmap to initialize
+ * @return error code
+ */
+int heatmap_init(heatmap_t *heatmap);
+
+//=========================================================================
+/**
+ * @brief "Destructor" for heatmap_t.
+ * @param heatmap the heatmap to free
+ * @return error code
+ */
+int heatmap_free(heatmap_t *heatmap);
+
+//=========================================================================
+/**
+ * @brief Reset all counters to 0 (e.g. at the end of a warm-up).
+ * @param heatmap the heatmap
+ * @return error code
+ */
+int heatmap_clear(heatmap_t *heatmap);
+
+//=========================================================================
+/**
+ * @brief Count a miss of a virtual page in a TLB.
+ * @param heatmap the heatmap
+ * @param tlb the TLB that missed
+ * @param vpn the virtual page number
+ * @return error code
+ */
+int heatmap_tlb_miss(heatmap_t *heatmap, enum heat_tlb tlb, uint64_t vpn);
+
+//=========================================================================
+/**
+ * @brief Write the cache counters as CSV, one line per set of each cache:
+ *        "cache,set,hits,misses,evictions".
+ * @param output the stream to write to
+ * @param heatmap the heatmap
+ * @return error code
+ */
+int heatmap_write_sets_csv(FILE *output, const heatmap_t *heatmap);
+
+//=========================================================================
+/**
+ * @brief Write the TLB counters as CSV, one line per virtual page that missed,
+ *        by TLB then by increasing page number: "tlb,vpn,misses".
+ * @param output the stream to write to
+ * @param heatmap the heatmap
+ * @return error code
+ */
+int heatmap_write_pages_csv(FILE *output, const heatmap_t *heatmap);
+
+//=========================================================================
+/**
+ * @brief Write both CSV files "<prefix>-sets.csv" and "<prefix>-pages.csv".
+ * @param prefix the prefix of the file names
+ * @param heatmap the heatmap
+ * @return error code
+ */
+int heatmap_save(const char *prefix, const heatmap_t *heatmap);
@@ -1,28 +1,34 @@
 #include "cache.h"
 #include "cache_mng.h"
-#define LRU_age_increase(TYPE, WAYS, WAY_INDEX, LINE_INDEX)          \
-                                                                     \
-    foreach_way(way, WAYS)                                           \
-    {                                                                \
-        if (way != WAY_INDEX)                                        \
-        {                                                            \
-                                                                     \
-            if (cache_age(TYPE, WAYS, LINE_INDEX, way) < (WAYS - 1)) \
-                cache_age(TYPE, WAYS, LINE_INDEX, way) += 1;         \
-        }                                                            \
-        else                                                         \
-            cache_age(TYPE, WAYS, LINE_INDEX, way) = 0;              \
+#define LRU_age_increase(TYPE, WAYS, WAY_INDEX, LINE_INDEX)           \
+                                                                      \
+    foreach_way(way_, WAYS)                                           \
+    {                                                                 \
+        if (way_ != WAY_INDEX)                                        \
+        {                                                             \
+                                                                      \
+            if (cache_age(TYPE, WAYS, LINE_INDEX, way_) < (WAYS - 1)) \
+                cache_age(TYPE, WAYS, LINE_INDEX, way_) += 1;         \
+        }                                                             \
+        else                                                          \
+            cache_age(TYPE, WAYS, LINE_INDEX, way_) = 0;              \
     }
 
-#define LRU_age_update(TYPE, WAYS, WAY_INDEX, LINE_INDEX)                                                                                                         \
-    foreach_way(way, WAYS)                                                                                                                                        \
-    {                                                                                                                                                             \
-        if (way != WAY_INDEX)                                                                                                                                     \
-        {                                                                                                                                                         \
-                                                                                                                                                                  \
-            if ((cache_age(TYPE, WAYS, LINE_INDEX, way) < (WAYS - 1)) && (cache_age(TYPE, WAYS, LINE_INDEX, way) < cache_age(TYPE, WAYS, LINE_INDEX, WAY_INDEX))) \
-                cache_age(TYPE, WAYS, LINE_INDEX, way) += 1;                                                                                                      \
-        }                                                                                                                                                         \
-        else                                                                                                                                                      \
-            cache_age(TYPE, WAYS, LINE_INDEX, way) = 0;                                                                                                           \
-    }
+// the age of the accessed way is saved first, since it is reset to 0 during the loop
+#define LRU_age_update(TYPE, WAYS, WAY_INDEX, LINE_INDEX)                                                          \
+    do                                                                                                             \
+    {                                                                                                              \
+        const uint8_t used_age_ = cache_age(TYPE, WAYS, LINE_INDEX, WAY_INDEX);                                    \
+        foreach_way(way_, WAYS)                                                                                    \
+        {                                                                                                          \
+            if (way_ != WAY_INDEX)                                                                                 \
+            {                                                                                                      \
+                                                                                                                   \
+                if ((cache_age(TYPE, WAYS, LINE_INDEX, way_) < (WAYS - 1)) &&                                      \
+                    (cache_age(TYPE, WAYS, LINE_INDEX, way_) < used_age_))                                         \
+                    cache_age(TYPE, WAYS, LINE_INDEX, way_) += 1;                                                  \
+            }                                                                                                      \
+            else                                                                                                   \
+                cache_age(TYPE, WAYS, LINE_INDEX, way_) = 0;                                                       \
+        }                                                                                                          \
+    } while (0)
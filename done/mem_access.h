@@ -14,3 +14,16 @@ enum mem_access_type
     DATA
 };
 typedef enum mem_access_type mem_access_t;
+
+/**
+ * @brief level of a two-level hierarchy (TLBs or caches) an access was served from;
+ * HIT_NONE means that both levels missed (page walk or main memory access)
+ */
+enum hit_level
+{
+    HIT_L1,
+    HIT_L2,
+    HIT_NONE,
+    NB_HIT_LEVELS // not an actual level but the number of levels
+};
+typedef enum hit_level hit_lvl_t;
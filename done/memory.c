@@ -9,58 +9,66 @@
 #if defined _WIN32 || defined _WIN64
 #define __USE_MINGW_ANSI_STDIO 1
 #endif
+#define _POSIX_C_SOURCE 200809L // for pthreads
 
 #include "memory.h"
 #include "page_walk.h"
 #include "addr_mng.h"
-#include "util.h" // for SIZE_T_FMT
+#include "util.h" // for zero_init_var()
 #include "error.h"
+#include "dump_buf.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>   // for memset()
 #include <inttypes.h> // for SCNx macros
 #include <assert.h>
+#include <pthread.h>
 
 #define BYTE_SIZE 1
 #define FOURKI 4096
 #define MAXSIZE_STRING 100
+#define START_PAGES 64 // initial capacity of the page list of a description being packed
+#define MAX_LOADER_THREADS 64
 
 // ======================================================================
 /**
  * @brief Tool function to print an address.
  *
+ * @param buf the buffer to print to
  * @param show_addr the format how to display addresses; see addr_fmt_t type in memory.h
  * @param reference the reference address; i.e. the top of the main memory
  * @param addr the address to be displayed
  * @param sep a separator to print after the address (and its colon, printed anyway)
  *
  */
-static void address_print(addr_fmt_t show_addr, const void *reference,
+static void address_print(dump_buf_t *buf, addr_fmt_t show_addr, const void *reference,
                           const void *addr, const char *sep)
 {
     switch (show_addr)
     {
     case POINTER:
-        (void)printf("%p", addr);
+        dump_buf_ptr(buf, addr);
         break;
     case OFFSET:
-        (void)printf("%zX", (const char *)addr - (const char *)reference);
+        dump_buf_hex(buf, (size_t)((const char *)addr - (const char *)reference), 1, dump_hex_upper);
         break;
     case OFFSET_U:
-        (void)printf(SIZE_T_FMT, (const char *)addr - (const char *)reference);
+        dump_buf_dec(buf, (size_t)((const char *)addr - (const char *)reference));
         break;
     default:
         // do nothing
         return;
     }
-    (void)printf(":%s", sep);
+    dump_buf_putc(buf, ':');
+    dump_buf_puts(buf, sep);
 }
 
 // ======================================================================
 /**
  * @brief Tool function to print the content of a memory area
  *
+ * @param buf the buffer to print to
  * @param reference the reference address; i.e. the top of the main memory
  * @param from first address to print
  * @param to first address NOT to print; if less that `from`, nothing is printed;
@@ -69,7 +77,7 @@ static void address_print(addr_fmt_t show_addr, const void *reference,
  * @param sep a separator to print after the address and between bytes
  *
  */
-static void mem_dump_with_options(const void *reference, const void *from, const void *to,
+static void mem_dump_with_options(dump_buf_t *buf, const void *reference, const void *from, const void *to,
                                   addr_fmt_t show_addr, size_t line_size, const char *sep)
 {
     assert(line_size != 0);
@@ -78,17 +86,18 @@ static void mem_dump_with_options(const void *reference, const void *from, const
     {
         if (nb_to_print == line_size)
         {
-            address_print(show_addr, reference, addr, sep);
+            address_print(buf, show_addr, reference, addr, sep);
         }
-        (void)printf("%02" PRIX8 "%s", *addr, sep);
+        dump_buf_byte(buf, *addr);
+        dump_buf_puts(buf, sep);
         if (--nb_to_print == 0)
         {
             nb_to_print = line_size;
-            putchar('\n');
+            dump_buf_putc(buf, '\n');
         }
     }
     if (nb_to_print != line_size)
-        putchar('\n');
+        dump_buf_putc(buf, '\n');
 }
 // ======================================================================
 
@@ -129,7 +138,7 @@ int mem_init_from_dumpfile(const char *filename, void **memory, size_t *mem_capa
 
 // ==========================================================================
 
-static int page_file_read(char *filename, void *phyaddr)
+static int page_file_read(const char *filename, void *phyaddr)
 { //helper method to read at physical address from file
     M_REQUIRE_NON_NULL(filename);
     M_REQUIRE_NON_NULL(phyaddr);
@@ -145,12 +154,32 @@ static int page_file_read(char *filename, void *phyaddr)
     return ERR_NONE;
 }
 
+// ==========================================================================
+/**
+ * @brief Tool function to tell whether a file is a packed memory image (see memory.h).
+ *
+ * @param filename the file
+ * @return 1 if it starts with MEM_IMAGE_MAGIC, 0 otherwise (including when it cannot be read)
+ */
+static int is_image(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+        return 0;
+    char magic[MEM_IMAGE_MAGIC_SIZE];
+    const int image = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, MEM_IMAGE_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return image;
+}
+
 int mem_init_from_description(const char *master_filename, void **memory, size_t *mem_capacity_in_bytes)
 {
 
     M_REQUIRE_NON_NULL(master_filename);
     M_REQUIRE_NON_NULL(memory);
     M_REQUIRE_NON_NULL(mem_capacity_in_bytes);
+    if (is_image(master_filename)) // a packed image instead of a description
+        return mem_init_from_image(master_filename, memory, mem_capacity_in_bytes);
     FILE *file;
     file = fopen(master_filename, "rb"); // read binary mode
     M_REQUIRE_NON_NULL_CUSTOM_ERR(file, ERR_IO);
@@ -166,6 +195,8 @@ int mem_init_from_description(const char *master_filename, void **memory, size_t
         return ERR_MEM;
     }
     error_code ret = ERR_NONE;
+    page_walker_t walker; // a description has the page tables of a single process, from 0
+    (void)page_walker_init(&walker, *memory, *mem_capacity_in_bytes, 0);
     char pgd_filename[MAXSIZE_STRING];
     if (fscanf(file, "%s", pgd_filename) != 1)
     {
@@ -243,7 +274,7 @@ int mem_init_from_description(const char *master_filename, void **memory, size_t
             free(*memory);
             return ret;
         }
-        if (ret = page_walk(*memory, &virtaddr, &paddr) != ERR_NONE)
+        if (ret = page_walk(&walker, &virtaddr, &paddr) != ERR_NONE)
         {
             fclose(file);
             free(*memory);
@@ -266,11 +297,410 @@ int mem_init_from_description(const char *master_filename, void **memory, size_t
     fclose(file);
     return ERR_NONE;
 }
+
+// ==========================================================================
+/**
+ * @brief Tool function to find where a page goes in memory, walking the
+ *        page tables for a virtual address.
+ *
+ * @param memory the memory, with its page tables loaded
+ * @param mem_size the size of the memory
+ * @param entry the table entry of the page
+ * @param target (modified) the first byte of the page in memory
+ * @return error code
+ */
+static int page_target(byte_t *memory, size_t mem_size, const mem_image_entry_t *entry, byte_t **target)
+{
+    uint64_t phaddr = entry->address;
+    if (entry->flags & MEM_IMAGE_VIRTUAL)
+    {
+        virt_addr_t vaddr;
+        phy_addr_t paddr;
+        page_walker_t walker; // the page tables of the image, from 0
+        M_EXIT_IF_ERR(page_walker_init(&walker, memory, mem_size, 0), "walking the page tables of the image");
+        M_EXIT_IF_ERR(init_virt_addr64(&vaddr, entry->address), "reading the virtual address of a page");
+        M_EXIT_IF_ERR(page_walk(&walker, &vaddr, &paddr), "translating the virtual address of a page");
+        phaddr = phy_addr_to_uint32(&paddr);
+    }
+    M_REQUIRE(phaddr <= mem_size && mem_size - phaddr >= PAGE_SIZE, ERR_ADDR,
+              "page at physical address 0x%" PRIx64 " is outside of memory", phaddr);
+    *target = memory + phaddr;
+    return ERR_NONE;
+}
+
+// ==========================================================================
+/**
+ * @brief Tool function to copy one page of a memory image to its place in memory.
+ *
+ * @param memory the memory, of which the previous pages were loaded
+ * @param mem_size the size of the memory
+ * @param image the whole image file
+ * @param image_size the size of the image file
+ * @param entry the table entry of the page
+ * @return error code
+ */
+static int image_page_load(byte_t *memory, size_t mem_size, const byte_t *image, size_t image_size,
+                           const mem_image_entry_t *entry)
+{
+    M_REQUIRE(entry->offset <= image_size && image_size - entry->offset >= PAGE_SIZE, ERR_IO,
+              "page content at offset %" PRIu64 " is outside of the image", entry->offset);
+    byte_t *target = NULL;
+    M_EXIT_IF_ERR(page_target(memory, mem_size, entry, &target), "placing a page");
+    memcpy(target, image + entry->offset, PAGE_SIZE);
+    return ERR_NONE;
+}
+
+// ==========================================================================
+/**
+ * @brief Tool function to build the memory from a whole image file.
+ *
+ * @param image the image file content
+ * @param image_size its size
+ * @param memory (modified) the memory created
+ * @param mem_capacity_in_bytes (modified) its size
+ * @return error code
+ */
+static int image_load(const byte_t *image, size_t image_size, void **memory, size_t *mem_capacity_in_bytes)
+{
+    mem_image_header_t header;
+    M_REQUIRE(image_size >= sizeof(header), ERR_IO, "image of %zu bytes has no header", image_size);
+    memcpy(&header, image, sizeof(header));
+    M_REQUIRE(memcmp(header.magic, MEM_IMAGE_MAGIC, MEM_IMAGE_MAGIC_SIZE) == 0 && header.version == MEM_IMAGE_VERSION,
+              ERR_IO, "not a memory image of version %d", MEM_IMAGE_VERSION);
+    M_REQUIRE((image_size - sizeof(header)) / sizeof(mem_image_entry_t) >= header.nb_pages, ERR_IO,
+              "truncated table of %" PRIu32 " pages", header.nb_pages);
+    M_REQUIRE(header.mem_size > 0 && header.mem_size <= SIZE_MAX, ERR_SIZE, "memory of %" PRIu64 " bytes", header.mem_size);
+
+    byte_t *mem = calloc((size_t)header.mem_size, 1);
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(mem, ERR_MEM);
+    int err = ERR_NONE;
+    for (uint32_t i = 0; i < header.nb_pages && err == ERR_NONE; ++i)
+    {
+        mem_image_entry_t entry;
+        memcpy(&entry, image + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        err = image_page_load(mem, (size_t)header.mem_size, image, image_size, &entry);
+    }
+    if (err != ERR_NONE)
+    {
+        free(mem);
+        return err;
+    }
+    *memory = mem;
+    *mem_capacity_in_bytes = (size_t)header.mem_size;
+    return ERR_NONE;
+}
+
 // See memory.h for description
+int mem_init_from_image(const char *filename, void **memory, size_t *mem_capacity_in_bytes)
+{
+    M_REQUIRE_NON_NULL(filename);
+    M_REQUIRE_NON_NULL(memory);
+    M_REQUIRE_NON_NULL(mem_capacity_in_bytes);
+    *memory = NULL;
+    FILE *file = fopen(filename, "rb");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(file, ERR_IO);
+
+    // the whole image at once: the table and the pages are then read from memory
+    long image_size = -1;
+    if (fseek(file, 0L, SEEK_END) == 0)
+        image_size = ftell(file);
+    rewind(file);
+    if (image_size < (long)sizeof(mem_image_header_t))
+    {
+        fclose(file);
+        return ERR_IO;
+    }
+    byte_t *image = malloc((size_t)image_size);
+    if (image == NULL)
+    {
+        fclose(file);
+        return ERR_MEM;
+    }
+    const int read_ok = fread(image, (size_t)image_size, 1, file) == 1;
+    fclose(file);
+    const int err = read_ok ? image_load(image, (size_t)image_size, memory, mem_capacity_in_bytes) : ERR_IO;
+    free(image);
+    return err;
+}
 
-int vmem_page_dump_with_options(const void *mem_space, const virt_addr_t *from,
+// ==========================================================================
+/**
+ * @brief a page listed by a memory description, while packing it
+ */
+typedef struct
+{
+    mem_image_entry_t entry;
+    char filename[MAXSIZE_STRING];
+} image_page_t;
+
+// ==========================================================================
+/**
+ * @brief Tool function to add a page to the list of a description being packed.
+ *
+ * @param pages (modified) the list, reallocated when full
+ * @param nb_pages (modified) its number of pages
+ * @param allocated (modified) its capacity
+ * @param address the address of the page
+ * @param flags MEM_IMAGE_VIRTUAL for a virtual address, 0 for a physical one
+ * @param filename the page file
+ * @return error code
+ */
+static int image_page_add(image_page_t **pages, uint32_t *nb_pages, uint32_t *allocated,
+                          uint64_t address, uint32_t flags, const char *filename)
+{
+    if (*nb_pages == *allocated)
+    {
+        M_REQUIRE(*allocated < UINT32_MAX / 2, ERR_SIZE, "more than %" PRIu32 " pages", *allocated);
+        const uint32_t new_allocated = *allocated == 0 ? START_PAGES : 2 * *allocated;
+        image_page_t *new_pages = realloc(*pages, new_allocated * sizeof(image_page_t));
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(new_pages, ERR_MEM);
+        *pages = new_pages;
+        *allocated = new_allocated;
+    }
+    image_page_t *page = *pages + *nb_pages;
+    memset(page, 0, sizeof(*page));
+    page->entry.address = address;
+    page->entry.flags = flags;
+    strncpy(page->filename, filename, MAXSIZE_STRING - 1);
+    ++*nb_pages;
+    return ERR_NONE;
+}
+
+// ==========================================================================
+/**
+ * @brief Tool function to list the pages of a memory description, in order.
+ *
+ * @param description the description file
+ * @param mem_size (modified) the memory size it gives
+ * @param pages (modified) the list of its pages, to be freed
+ * @param nb_pages (modified) the number of pages
+ * @return error code
+ */
+static int description_pages(FILE *description, uint64_t *mem_size, image_page_t **pages, uint32_t *nb_pages)
+{
+    uint32_t allocated = 0;
+    char filename[MAXSIZE_STRING];
+    int nb_tables = 0;
+    M_REQUIRE(fscanf(description, "%" SCNu64, mem_size) == 1, ERR_IO, "no memory size in the %s", "description");
+    M_REQUIRE(fscanf(description, "%99s", filename) == 1, ERR_IO, "no PGD page in the %s", "description");
+    M_EXIT_IF_ERR(image_page_add(pages, nb_pages, &allocated, 0, 0, filename), "adding the PGD");
+    M_REQUIRE(fscanf(description, "%d", &nb_tables) == 1 && nb_tables >= 0, ERR_IO, "no number of tables in the %s", "description");
+    for (int i = 0; i < nb_tables; ++i)
+    {
+        uint32_t phaddr = 0;
+        M_REQUIRE(fscanf(description, "%" SCNx32 "%99s", &phaddr, filename) == 2, ERR_IO, "bad table page %d", i);
+        M_EXIT_IF_ERR(image_page_add(pages, nb_pages, &allocated, phaddr, 0, filename), "adding a table");
+    }
+    uint64_t vaddr = 0;
+    int n = 0;
+    while ((n = fscanf(description, "%" SCNx64 "%99s", &vaddr, filename)) == 2)
+    {
+        M_EXIT_IF_ERR(image_page_add(pages, nb_pages, &allocated, vaddr, MEM_IMAGE_VIRTUAL, filename), "adding a data page");
+    }
+    M_REQUIRE(n == EOF, ERR_IO, "bad data page after %" PRIu32 " pages", *nb_pages);
+    return ERR_NONE;
+}
+
+// ==========================================================================
+/**
+ * @brief Tool function to write a memory image from the list of its pages.
+ *
+ * @param image the image file
+ * @param mem_size the memory size
+ * @param pages the pages
+ * @param nb_pages the number of pages
+ * @return error code
+ */
+static int image_write(FILE *image, uint64_t mem_size, image_page_t *pages, uint32_t nb_pages)
+{
+    mem_image_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MEM_IMAGE_MAGIC, MEM_IMAGE_MAGIC_SIZE);
+    header.version = MEM_IMAGE_VERSION;
+    header.nb_pages = nb_pages;
+    header.mem_size = mem_size;
+    M_REQUIRE(fwrite(&header, sizeof(header), 1, image) == 1, ERR_IO, "cannot write the %s", "header");
+
+    const uint64_t first_offset = sizeof(header) + (uint64_t)nb_pages * sizeof(mem_image_entry_t);
+    for (uint32_t i = 0; i < nb_pages; ++i)
+    {
+        pages[i].entry.offset = first_offset + (uint64_t)i * PAGE_SIZE;
+        M_REQUIRE(fwrite(&pages[i].entry, sizeof(mem_image_entry_t), 1, image) == 1, ERR_IO, "cannot write entry %" PRIu32, i);
+    }
+    byte_t content[PAGE_SIZE];
+    for (uint32_t i = 0; i < nb_pages; ++i)
+    {
+        M_EXIT_IF_ERR(page_file_read(pages[i].filename, content), "reading a page file");
+        M_REQUIRE(fwrite(content, PAGE_SIZE, 1, image) == 1, ERR_IO, "cannot write page %" PRIu32, i);
+    }
+    return ERR_NONE;
+}
+
+// See memory.h for description
+int mem_image_from_description(const char *description_filename, const char *image_filename)
+{
+    M_REQUIRE_NON_NULL(description_filename);
+    M_REQUIRE_NON_NULL(image_filename);
+    FILE *description = fopen(description_filename, "r");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(description, ERR_IO);
+    uint64_t mem_size = 0;
+    image_page_t *pages = NULL;
+    uint32_t nb_pages = 0;
+    int err = description_pages(description, &mem_size, &pages, &nb_pages);
+    fclose(description);
+
+    if (err == ERR_NONE)
+    {
+        FILE *image = fopen(image_filename, "wb");
+        if (image == NULL)
+        {
+            err = ERR_IO;
+        }
+        else
+        {
+            err = image_write(image, mem_size, pages, nb_pages);
+            if (fclose(image) != 0 && err == ERR_NONE)
+                err = ERR_IO;
+        }
+    }
+    free(pages);
+    return err;
+}
+
+// ==========================================================================
+/**
+ * @brief page files read by the workers of mem_init_from_description_parallel()
+ */
+typedef struct
+{
+    const image_page_t *pages; // the page files
+    byte_t *const *targets;    // where each of them goes in memory
+    uint32_t nb_pages;
+    uint32_t next; // next page to read, taken under the lock
+    int err;       // first error met, which stops the workers
+    pthread_mutex_t lock;
+} page_loader_t;
+
+// ==========================================================================
+/**
+ * @brief Body of the workers: each reads the next page file not taken yet.
+ */
+static void *page_loader_worker(void *arg)
+{
+    page_loader_t *loader = arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&loader->lock);
+        const uint32_t i = loader->next;
+        const int done = loader->err != ERR_NONE || i == loader->nb_pages;
+        if (!done)
+            ++loader->next;
+        pthread_mutex_unlock(&loader->lock);
+        if (done)
+            return NULL;
+
+        const int err = page_file_read(loader->pages[i].filename, loader->targets[i]);
+        if (err != ERR_NONE)
+        {
+            pthread_mutex_lock(&loader->lock);
+            if (loader->err == ERR_NONE)
+                loader->err = err;
+            pthread_mutex_unlock(&loader->lock);
+        }
+    }
+}
+
+// ==========================================================================
+/**
+ * @brief Tool function to read page files into memory concurrently.
+ *
+ * @param pages the page files
+ * @param targets where each of them goes in memory
+ * @param nb_pages the number of pages
+ * @param nb_threads the number of threads reading them, the calling one included
+ * @return error code
+ */
+static int pages_load(const image_page_t *pages, byte_t *const *targets, uint32_t nb_pages, size_t nb_threads)
+{
+    page_loader_t loader;
+    memset(&loader, 0, sizeof(loader));
+    loader.pages = pages;
+    loader.targets = targets;
+    loader.nb_pages = nb_pages;
+    loader.err = ERR_NONE;
+    pthread_mutex_init(&loader.lock, NULL);
+
+    pthread_t threads[MAX_LOADER_THREADS];
+    size_t nb_started = 0;
+    while (nb_started + 1 < nb_threads && nb_started < nb_pages && nb_started < MAX_LOADER_THREADS &&
+           pthread_create(&threads[nb_started], NULL, page_loader_worker, &loader) == 0)
+        ++nb_started;
+    page_loader_worker(&loader); // the calling thread reads as well (alone, if none could be started)
+    for (size_t i = 0; i < nb_started; ++i)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&loader.lock);
+    return loader.err;
+}
+
+// See memory.h for description
+int mem_init_from_description_parallel(const char *master_filename, void **memory, size_t *mem_capacity_in_bytes,
+                                       size_t nb_threads)
+{
+    M_REQUIRE_NON_NULL(master_filename);
+    M_REQUIRE_NON_NULL(memory);
+    M_REQUIRE_NON_NULL(mem_capacity_in_bytes);
+    M_REQUIRE(nb_threads > 0, ERR_BAD_PARAMETER, "needs at least %d thread", 1);
+    if (is_image(master_filename)) // already a single read
+        return mem_init_from_image(master_filename, memory, mem_capacity_in_bytes);
+
+    FILE *description = fopen(master_filename, "r");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(description, ERR_IO);
+    uint64_t mem_size = 0;
+    image_page_t *pages = NULL;
+    uint32_t nb_pages = 0;
+    int err = description_pages(description, &mem_size, &pages, &nb_pages);
+    fclose(description);
+    if (err == ERR_NONE && (mem_size == 0 || mem_size > SIZE_MAX))
+        err = ERR_SIZE;
+
+    byte_t *mem = err == ERR_NONE ? calloc((size_t)mem_size, 1) : NULL;
+    byte_t **targets = err == ERR_NONE ? calloc(nb_pages, sizeof(byte_t *)) : NULL;
+    if (err == ERR_NONE && (mem == NULL || targets == NULL))
+        err = ERR_MEM;
+
+    // the page tables come first in a description: they are read, then all
+    // the data pages are placed by walking them, then read
+    uint32_t nb_tables = 0;
+    while (nb_tables < nb_pages && !(pages[nb_tables].entry.flags & MEM_IMAGE_VIRTUAL))
+        ++nb_tables;
+    for (uint32_t i = 0; i < nb_tables && err == ERR_NONE; ++i)
+        err = page_target(mem, (size_t)mem_size, &pages[i].entry, &targets[i]);
+    if (err == ERR_NONE)
+        err = pages_load(pages, targets, nb_tables, nb_threads);
+    for (uint32_t i = nb_tables; i < nb_pages && err == ERR_NONE; ++i)
+        err = page_target(mem, (size_t)mem_size, &pages[i].entry, &targets[i]);
+    if (err == ERR_NONE)
+        err = pages_load(pages + nb_tables, targets + nb_tables, nb_pages - nb_tables, nb_threads);
+
+    free(targets);
+    free(pages);
+    if (err != ERR_NONE)
+    {
+        free(mem);
+        return err;
+    }
+    *memory = mem;
+    *mem_capacity_in_bytes = (size_t)mem_size;
+    return ERR_NONE;
+}
+
+// See memory.h for description
+
+int vmem_page_dump_with_options(const page_walker_t *walker, const virt_addr_t *from,
                                 addr_fmt_t show_addr, size_t line_size, const char *sep)
 {
+    M_REQUIRE_NON_NULL(walker);
+    const void *const mem_space = walker->mem_space;
 #ifdef DEBUG
     debug_print("mem_space=%p\n", mem_space);
     (void)fprintf(stderr, __FILE__ ":%d:%s(): virt. addr.=", __LINE__, __func__);
@@ -280,7 +710,7 @@ int vmem_page_dump_with_options(const void *mem_space, const virt_addr_t *from,
     phy_addr_t paddr;
     zero_init_var(paddr);
 
-    M_EXIT_IF_ERR((error_code)page_walk(mem_space, from, &paddr),
+    M_EXIT_IF_ERR((error_code)page_walk(walker, from, &paddr),
                   "calling page_walk() from vmem_page_dump_with_options()");
 #ifdef DEBUG
     (void)fprintf(stderr, __FILE__ ":%d:%s(): phys. addr.=", __LINE__, __func__);
@@ -289,20 +719,29 @@ int vmem_page_dump_with_options(const void *mem_space, const virt_addr_t *from,
 #endif
 
     const uint32_t paddr_offset = ((uint32_t)paddr.phy_page_num << PAGE_OFFSET);
+    M_REQUIRE((uint64_t)paddr_offset + PAGE_SIZE <= walker->mem_size, ERR_ADDR,
+              "page at physical address 0x%" PRIx32 " is outside of memory", paddr_offset);
     const char *const page_start = (const char *)mem_space + paddr_offset;
     const char *const start = page_start + paddr.page_offset;
     const char *const end_line = start + (line_size - paddr.page_offset % line_size);
     const char *const end = page_start + PAGE_SIZE;
     debug_print("start=%p (offset=%zX)\n", (const void *)start, start - (const char *)mem_space);
     debug_print("end  =%p (offset=%zX)\n", (const void *)end, end - (const char *)mem_space);
-    mem_dump_with_options(mem_space, page_start, start, show_addr, line_size, sep);
+    // the whole page is rendered in a buffer, written to stdout as it fills up
+    dump_buf_t buf;
+    dump_buf_init(&buf, stdout);
+    mem_dump_with_options(&buf, mem_space, page_start, start, show_addr, line_size, sep);
     const size_t indent = paddr.page_offset % line_size;
     if (indent == 0)
-        putchar('\n');
-    address_print(show_addr, mem_space, start, sep);
+        dump_buf_putc(&buf, '\n');
+    address_print(&buf, show_addr, mem_space, start, sep);
     for (size_t i = 1; i <= indent; ++i)
-        printf("  %s", sep);
-    mem_dump_with_options(mem_space, start, end_line, NONE, line_size, sep);
-    mem_dump_with_options(mem_space, end_line, end, show_addr, line_size, sep);
+    {
+        dump_buf_puts(&buf, "  ");
+        dump_buf_puts(&buf, sep);
+    }
+    mem_dump_with_options(&buf, mem_space, start, end_line, NONE, line_size, sep);
+    mem_dump_with_options(&buf, mem_space, end_line, end, show_addr, line_size, sep);
+    dump_buf_flush(&buf);
     return ERR_NONE;
 }
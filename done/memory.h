@@ -9,7 +9,9 @@
  */
 
 #include "addr.h"   // for virt_addr_t
+#include "page_walk.h" // for page_walker_t
 #include <stdlib.h> // for size_t and free()
+#include <stdint.h>
 
 /**
  * @brief enum type to describe how to print address;
@@ -63,11 +65,79 @@ int mem_init_from_dumpfile(const char* filename, void** memory, size_t* mem_capa
 
 int mem_init_from_description(const char* master_filename, void** memory, size_t* mem_capacity_in_bytes);
 
+/**
+ * @brief Same as mem_init_from_description(), reading the page files concurrently.
+ * All the page tables are read first; the data pages are then all placed by
+ * walking them, and read straight to their place in memory. A data page
+ * overwriting a page table thus does not change where the others go.
+ *
+ * @param filename the name of the memory content description file to read from
+ * @param memory (modified) pointer to the begining of the memory
+ * @param mem_capacity_in_bytes (modified) total size of the created memory
+ * @param nb_threads number of threads reading the pages, the calling one included
+ * @return error code, *p_memory shall be NULL in case of error
+ */
+int mem_init_from_description_parallel(const char* master_filename, void** memory, size_t* mem_capacity_in_bytes,
+                                       size_t nb_threads);
+
+/**
+ * @brief Packed memory image: a whole memory description in one file,
+ * loaded with one open and one read instead of one per page file.
+ * Its layout (native byte order, as checkpoints) is:
+ *  - a header: MEM_IMAGE_MAGIC, the version, the number N of pages and
+ *    the total memory size;
+ *  - a table of contents of N entries: the address of a page, whether it
+ *    is virtual (MEM_IMAGE_VIRTUAL) or physical, and the offset of its
+ *    content in the file;
+ *  - the N page contents, PAGE_SIZE bytes each.
+ * The pages are loaded in the order of the table, as in a description:
+ * the page tables first, so that the virtual addresses can be walked.
+ * mem_init_from_description() also accepts an image.
+ */
+#define MEM_IMAGE_MAGIC "PPSMEMIM"
+#define MEM_IMAGE_MAGIC_SIZE 8
+#define MEM_IMAGE_VERSION 1
+#define MEM_IMAGE_VIRTUAL 1 // flag of a page given by its virtual address
+
+typedef struct {
+    char magic[MEM_IMAGE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t nb_pages;
+    uint64_t mem_size;
+} mem_image_header_t;
+
+typedef struct {
+    uint64_t address; // physical, or virtual when flags has MEM_IMAGE_VIRTUAL
+    uint64_t offset;  // of the page content, from the beginning of the file
+    uint32_t flags;
+    uint32_t reserved; // 0
+} mem_image_entry_t;
+
+/**
+ * @brief Create and initialize the whole memory space from a packed memory image.
+ *
+ * @param filename the name of the image file to read from
+ * @param memory (modified) pointer to the begining of the memory
+ * @param mem_capacity_in_bytes (modified) total size of the created memory
+ * @return error code, *p_memory shall be NULL in case of error
+ */
+int mem_init_from_image(const char* filename, void** memory, size_t* mem_capacity_in_bytes);
+
+/**
+ * @brief Pack a memory description (see mem_init_from_description()) and
+ * all the page files it lists into one memory image.
+ *
+ * @param description_filename the name of the memory description to read
+ * @param image_filename the name of the image file to create
+ * @return error code
+ */
+int mem_image_from_description(const char* description_filename, const char* image_filename);
+
 
 /**
  * @brief Prints the content of one page from its virtual address.
  * It prints the content reading it as 32 bits integers.
- * @param   mem_space the origin of the memory space simulating the whole memory
+ * @param   walker the memory space simulating the whole memory, and the page tables to walk
  * @param   from the virtual address of the page to print
  * @param   show_addr an option to indicate how to print the address of each printed bloc; see above
  * @param   line_size an option indicating how many 32-bits integers shall be displayed per line
@@ -75,8 +145,8 @@ int mem_init_from_description(const char* master_filename, void** memory, size_t
  * @return  error code
  */
 
-int vmem_page_dump_with_options(const void *mem_space, const virt_addr_t* from,
+int vmem_page_dump_with_options(const page_walker_t *walker, const virt_addr_t* from,
                                 addr_fmt_t show_addr, size_t line_size, const char* sep);
 
-#define vmem_page_dump(mem, from) vmem_page_dump_with_options(mem, from, OFFSET, 16, " ")
+#define vmem_page_dump(walker, from) vmem_page_dump_with_options(walker, from, OFFSET, 16, " ")
 
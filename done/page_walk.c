@@ -3,35 +3,66 @@
 #include "addr.h"
 #include "error.h"
 
-static inline pte_t read_page_entry(const pte_t *start,
-                                    pte_t page_start,
-                                    uint16_t index)
+#include <inttypes.h> // for PRIx32, PRIu16
+
+static inline int read_page_entry(const page_walker_t *walker,
+                                  pte_t page_start,
+                                  uint16_t index,
+                                  pte_t *entry)
 {
-    M_REQUIRE_NON_NULL(start);
+    // a stale or garbage entry may point anywhere: the table is checked to be in memory
+    M_REQUIRE((uint64_t)page_start + (index + 1) * sizeof(pte_t) <= walker->mem_size, ERR_ADDR,
+              "page table 0x%" PRIx32 " is outside of memory", page_start);
     // getting the page entry address from a pointer to memory start
-    int i = index + (page_start / sizeof(pte_t));
-    return start[i];
+    size_t i = index + (page_start / sizeof(pte_t));
+    *entry = ((const pte_t *)walker->mem_space)[i];
+    return ERR_NONE;
 }
 
-int page_walk(const void *mem_space, const virt_addr_t *vaddr, phy_addr_t *paddr)
+// see page_walk.h
+int page_walker_init(page_walker_t *walker, void *mem_space, size_t mem_size, pte_t root)
 {
-    // computitng the start adress of a TLB and using with proper index
-    // to get the start adress of the next TLB
+    M_REQUIRE_NON_NULL(walker);
     M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE(root % PAGE_SIZE == 0, ERR_ADDR, "page-table root 0x%" PRIx32 " is not page aligned", root);
+    walker->mem_space = mem_space;
+    walker->mem_size = mem_size;
+    walker->root = root;
+    walker->fault_handler = NULL;
+    walker->fault_arg = NULL;
+    walker->access_handler = NULL;
+    walker->access_arg = NULL;
+    return ERR_NONE;
+}
+
+int page_walk(const page_walker_t *walker, const virt_addr_t *vaddr, phy_addr_t *paddr)
+{
+    // each level gives the start address of the table of the next one,
+    // the last one that of the page
+    M_REQUIRE_NON_NULL(walker);
+    M_REQUIRE_NON_NULL(walker->mem_space);
     M_REQUIRE_NON_NULL(vaddr);
     M_REQUIRE_NON_NULL(paddr);
-    pte_t start_pud = read_page_entry((pte_t *)mem_space, 0, vaddr->pgd_entry);
-    if (start_pud == ERR_BAD_PARAMETER)
-        return start_pud;
-    pte_t start_pmd = read_page_entry((pte_t *)mem_space, start_pud, vaddr->pud_entry);
-    if (start_pmd == ERR_BAD_PARAMETER)
-        return start_pmd;
-    pte_t start_pte = read_page_entry((pte_t *)mem_space, start_pmd, vaddr->pmd_entry);
-    if (start_pte == ERR_BAD_PARAMETER)
-        return start_pte;
-    pte_t page_begin = read_page_entry((pte_t *)mem_space, start_pte, vaddr->pte_entry);
-    if (page_begin == ERR_BAD_PARAMETER)
-        return page_begin;
-    uint16_t page_offset = vaddr->page_offset;
-    return init_phy_addr(paddr, page_begin, page_offset);
+    const uint16_t indexes[PAGE_WALK_LEVELS] = {vaddr->pgd_entry, vaddr->pud_entry, vaddr->pmd_entry, vaddr->pte_entry};
+    pte_t table = walker->root;
+    for (int level = 0; level < PAGE_WALK_LEVELS; ++level)
+    {
+        pte_t entry = 0;
+        M_EXIT_IF_ERR(read_page_entry(walker, table, indexes[level], &entry), "reading a page-table entry");
+        // a PTE of 0 maps physical page 0 in the memories described before the
+        // present bit: it faults only for the handler, which built every entry
+        const int last_level = level == PAGE_WALK_LEVELS - 1;
+        if (!pte_is_present(entry) && (!last_level || walker->fault_handler != NULL))
+        {
+            M_REQUIRE(walker->fault_handler != NULL, ERR_ADDR, "page fault at level %d, entry %" PRIu16 " of table 0x%" PRIx32,
+                      level, indexes[level], table);
+            M_EXIT_IF_ERR(walker->fault_handler(walker->fault_arg, table, indexes[level], level, &entry), "handling a page fault");
+        }
+        if (walker->access_handler != NULL)
+        {
+            M_EXIT_IF_ERR(walker->access_handler(walker->access_arg, table, indexes[level], level, &entry), "updating an entry walked");
+        }
+        table = pte_address(entry);
+    }
+    return init_phy_addr(paddr, table, vaddr->page_offset);
 }
@@ -10,12 +10,62 @@
 
 #include "addr.h"
 
+#include <stddef.h> // for size_t
+
 /**
- * @brief Page walker: virtual address to physical address conversion.
+ * @brief Page-fault handler: makes a missing entry present.
  *
+ * @param arg the fault argument of the walker
+ * @param table physical address of the page table holding the entry
+ * @param index index of the entry in that table
+ * @param level level of the table: 0 for the PGD, ..., PAGE_WALK_LEVELS - 1 for a PTE page
+ * @param entry (modified) the new entry, which the handler also stored in the table
+ * @return error code
+ */
+typedef int (*page_fault_handler_t)(void *arg, pte_t table, uint16_t index, int level, pte_t *entry);
+
+#define PAGE_WALK_LEVELS 4 // PGD, PUD, PMD and PTE
+
+/**
+ * @brief What a walk goes through: the memory holding the page tables, the
+ *        root of the tables of one address space, and what to do when an
+ *        entry is not present. A fault handler may write the page tables:
+ *        the memory is not read-only.
+ */
+typedef struct
+{
+    void *mem_space;                    // starting address of our simulated memory space
+    size_t mem_size;                    // its size: an entry outside of it is an ERR_ADDR
+    pte_t root;                         // physical address of the PGD (as x86 CR3)
+    page_fault_handler_t fault_handler; // NULL for none: a fault is then an ERR_ADDR
+    void *fault_arg;                    // the first argument of fault_handler
+    // called for every entry walked, after any page fault, e.g. to maintain the
+    // PTE_ACCESSED and PTE_DIRTY bits as hardware does; NULL to leave the entries
+    page_fault_handler_t access_handler;
+    void *access_arg;                   // the first argument of access_handler
+} page_walker_t;
+
+/**
+ * @brief Initialize a page walker, with no fault nor access handler.
+ *
+ * @param walker (modified) the walker
  * @param mem_space starting address of our simulated memory space
+ * @param mem_size its size, in bytes
+ * @param root physical address of the PGD, page aligned (0 for the memories
+ *        of a single process)
+ * @return error code
+ */
+int page_walker_init(page_walker_t *walker, void *mem_space, size_t mem_size, pte_t root);
+
+/**
+ * @brief Page walker: virtual address to physical address conversion,
+ *        from the PGD of the walker. A page-table entry which is not present
+ *        (see pte_is_present()) is a page fault; so is a PTE of 0 once a fault
+ *        handler is set (without one, it maps page 0).
+ *
+ * @param walker the memory and the page tables to walk
  * @param vaddr virtual address to be converted
  * @param paddr (SET) physical address
  * @return error code
  */
-int page_walk(const void* mem_space, const virt_addr_t* vaddr, phy_addr_t* paddr);
+int page_walk(const page_walker_t* walker, const virt_addr_t* vaddr, phy_addr_t* paddr);
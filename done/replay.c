@@ -0,0 +1,226 @@
+/**
+ * @file replay.c
+ * @brief replay a (possibly huge) trace through the simulator: a text trace is
+ *        parsed on worker threads while the simulator runs, a binary trace
+ *        (see trace_bin.h) is decoded on the fly
+ *
+ * @date 2019
+ */
+
+#if defined _WIN32  || defined _WIN64
+#define __USE_MINGW_ANSI_STDIO 1
+#endif
+
+#include "error.h"
+#include "commands.h"
+#include "memory.h"
+#include "sim_mng.h"
+#include "trace_reader.h"
+#include "trace_bin.h"
+
+#include <inttypes.h> // for PRIu64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ======================================================================
+static void usage(const char* pgm)
+{
+    fprintf(stderr, "usage:    %s (dump|desc) mem_filename trace_filename [option...]\n", pgm);
+    fprintf(stderr, "          %s demand mem_size trace_filename [option...]\n", pgm);
+    fprintf(stderr, "example:  %s desc memory_description.txt commands01.txt --threads=4\n", pgm);
+    fprintf(stderr, "options:  --threads=N      parses the trace and the description on N threads (default 2)\n");
+    fprintf(stderr, "          --chunk=N        bytes per chunk of the parsing threads (default 0, for 1 MiB)\n");
+    fprintf(stderr, "          --utlb=N         micro-TLB entries in front of the TLB hierarchy (default 0, none)\n");
+    fprintf(stderr, "          --heatmap=PREFIX writes per-set and per-page counters to PREFIX-sets.csv and PREFIX-pages.csv\n");
+    fprintf(stderr, "          --roots=LIST     comma-separated physical addresses of the PGDs of processes 0, 1... (0 for the others)\n");
+    fprintf(stderr, "          --pte-tracking   maintains the accessed and dirty bits of the page tables and counts them\n");
+    fprintf(stderr, "binary traces are detected; the thread and chunk options are ignored for them\n");
+    fprintf(stderr, "desc also accepts a packed memory image (see convert-memory)\n");
+    fprintf(stderr, "demand:   starts from mem_size bytes of empty memory, the page tables and pages\n"
+                    "          being built on first touch after the PGDs of the roots\n");
+}
+
+// ======================================================================
+typedef struct {
+    size_t nb_threads;
+    size_t chunk_size;
+    size_t utlb_entries;
+    const char* heatmap_prefix; // NULL for no heatmap
+    const char* roots;          // NULL to leave the roots
+    int pte_tracking;
+} replay_options_t;
+
+// a count, in full: "--threads=4x" is an error rather than 4
+static int parse_count(const char* value, size_t* count)
+{
+    char* end = NULL;
+    const unsigned long n = strtoul(value, &end, 0);
+    M_REQUIRE(end != value && *end == '\0', ERR_BAD_PARAMETER, "bad count \"%s\"", value);
+    *count = (size_t) n;
+    return ERR_NONE;
+}
+
+static int set_option(replay_options_t* options, const char* option)
+{
+    if (!strcmp(option, "--pte-tracking")) {
+        options->pte_tracking = 1;
+        return ERR_NONE;
+    }
+    const char* value = strchr(option, '=');
+    if (value == NULL) return ERR_BAD_PARAMETER;
+    const size_t key_len = (size_t)(value - option);
+    ++value;
+#define key_is(K) (key_len == strlen(K) && !strncmp(option, K, key_len))
+    if (key_is("--threads"))      return parse_count(value, &options->nb_threads);
+    else if (key_is("--chunk"))   return parse_count(value, &options->chunk_size);
+    else if (key_is("--utlb"))    return parse_count(value, &options->utlb_entries);
+    else if (key_is("--heatmap")) options->heatmap_prefix = value;
+    else if (key_is("--roots"))   options->roots = value;
+    else return ERR_BAD_PARAMETER;
+#undef key_is
+    return ERR_NONE;
+}
+
+// ======================================================================
+// empty memory of the given size, for demand paging
+static int mem_init_empty(const char* size_arg, void** mem_space, size_t* mem_size)
+{
+    char* end = NULL;
+    const unsigned long long size = strtoull(size_arg, &end, 0);
+    M_REQUIRE(end != size_arg && *end == '\0' && size > 0 && size % PAGE_SIZE == 0 && size <= (1ULL << PHY_ADDR),
+              ERR_BAD_PARAMETER, "bad memory size \"%s\"", size_arg);
+    *mem_space = calloc(size, 1);
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(*mem_space, ERR_MEM);
+    *mem_size = (size_t) size;
+    return ERR_NONE;
+}
+
+// ======================================================================
+// the frames after the highest PGD are free
+static int enable_demand_paging(sim_t* sim)
+{
+    pte_t highest = 0;
+    for (int asid = 0; asid < NB_ASIDS; ++asid)
+        if (sim->page_table_roots[asid] > highest) highest = sim->page_table_roots[asid];
+    return sim_enable_demand_paging(sim, (uint64_t) highest + PAGE_SIZE);
+}
+
+// ======================================================================
+static int set_roots(sim_t* sim, const char* roots)
+{
+    char* end = NULL;
+    for (unsigned asid = 0; asid < NB_ASIDS; ++asid) {
+        const unsigned long root = strtoul(roots, &end, 0);
+        M_REQUIRE(end != roots && (*end == ',' || *end == '\0') && root <= UINT32_MAX,
+                  ERR_BAD_PARAMETER, "bad page-table root list \"%s\"", roots);
+        M_EXIT_IF_ERR(sim_set_page_table_root(sim, (asid_t) asid, (pte_t) root), "setting a page-table root");
+        if (*end == '\0') return ERR_NONE;
+        roots = end + 1;
+    }
+    M_EXIT_ERR(ERR_BAD_PARAMETER, "more than %d page-table roots", NB_ASIDS);
+}
+
+// ======================================================================
+// the accessed and dirty pages of each address space, its page tables being scanned once
+static int print_pte_scan(FILE* output, sim_t* sim)
+{
+    for (unsigned asid = 0; asid < NB_ASIDS; ++asid) {
+        unsigned other = 0;
+        while (other < asid && sim->page_table_roots[other] != sim->page_table_roots[asid]) ++other;
+        if (other < asid) continue;
+        uint64_t accessed = 0;
+        uint64_t dirty = 0;
+        M_EXIT_IF_ERR(sim_pte_scan(sim, (asid_t) asid, 0, &accessed, &dirty), "scanning the page tables");
+        fprintf(output, "ASID %u: accessed pages: %" PRIu64 ", dirty pages: %" PRIu64 "\n", asid, accessed, dirty);
+    }
+    return ERR_NONE;
+}
+
+// ======================================================================
+static int replay_binary(sim_t* sim, const char* filename)
+{
+    trace_bin_reader_t reader;
+    M_EXIT_IF_ERR(trace_bin_reader_open(&reader, filename), "opening the binary trace");
+    int err = ERR_NONE;
+    command_t command;
+    while ((err = trace_bin_reader_next(&reader, &command)) == ERR_NONE) {
+        byte_t data[DATA_SIZE_MAX];
+        if ((err = mem_access(sim, &command, data, NULL)) != ERR_NONE) break;
+    }
+    trace_bin_reader_close(&reader);
+    return err == ERR_EOF ? ERR_NONE : err;
+}
+
+// ======================================================================
+static int replay(sim_t* sim, const char* filename, size_t nb_threads, size_t chunk_size)
+{
+    trace_reader_t reader;
+    M_EXIT_IF_ERR(trace_reader_open(&reader, filename, nb_threads, chunk_size, 0), "opening the trace");
+    int err = ERR_NONE;
+    program_t chunk;
+    while (err == ERR_NONE && (err = trace_reader_next(&reader, &chunk)) == ERR_NONE) {
+        for_all_lines(line, &chunk) {
+            byte_t data[DATA_SIZE_MAX];
+            if ((err = mem_access(sim, line, data, NULL)) != ERR_NONE) break;
+        }
+        program_free(&chunk);
+    }
+    trace_reader_close(&reader);
+    return err == ERR_EOF ? ERR_NONE : err;
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        usage(argv[0]);
+        return 1;
+    }
+    const int dump = !strcmp(argv[1], "dump");
+    const int demand = !strcmp(argv[1], "demand");
+    if (!dump && !demand && strcmp(argv[1], "desc")) {
+        usage(argv[0]);
+        return 1;
+    }
+    replay_options_t options = { .nb_threads = 2 };
+    for (int i = 4; i < argc; ++i) {
+        if (set_option(&options, argv[i]) != ERR_NONE) {
+            fprintf(stderr, "ERROR: bad option \"%s\"\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    void* mem_space = NULL;
+    size_t mem_size = 0;
+    int err = dump   ? mem_init_from_dumpfile(argv[2], &mem_space, &mem_size)
+              : demand ? mem_init_empty(argv[2], &mem_space, &mem_size)
+                       : mem_init_from_description_parallel(argv[2], &mem_space, &mem_size, options.nb_threads);
+    if (err != ERR_NONE) {
+        fprintf(stderr, "ERROR: problem initializing memory from provided file.\n");
+        return 3;
+    }
+
+    static sim_t sim;
+    err = sim_init(&sim, mem_space, mem_size);
+    if (err == ERR_NONE) err = sim_set_utlb(&sim, options.utlb_entries);
+    if (err == ERR_NONE && options.heatmap_prefix != NULL) err = sim_enable_heatmap(&sim);
+    if (err == ERR_NONE && options.roots != NULL) err = set_roots(&sim, options.roots);
+    if (err == ERR_NONE && demand) err = enable_demand_paging(&sim);
+    if (err == ERR_NONE && options.pte_tracking) err = sim_enable_pte_tracking(&sim);
+    if (err == ERR_NONE) err = trace_bin_is_binary(argv[3]) ? replay_binary(&sim, argv[3])
+                                                            : replay(&sim, argv[3], options.nb_threads, options.chunk_size);
+    if (err == ERR_NONE && options.heatmap_prefix != NULL) err = heatmap_save(options.heatmap_prefix, sim.heatmap);
+    if (err == ERR_NONE) {
+        sim_print_stats(stdout, &sim);
+        if (options.pte_tracking) err = print_pte_scan(stdout, &sim);
+    }
+    if (err != ERR_NONE) {
+        fprintf(stderr, "ERROR: %s\n", ERR_MESSAGES[err - ERR_NONE]);
+    }
+
+    sim_free(&sim);
+    free(mem_space);
+    return err == ERR_NONE ? 0 : 2;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file sampling.c
+ * @brief statistical sampling of a program (SMARTS-style)
+ *
+ * @date 2019
+ */
+#include "sampling.h"
+#include "sim_mng.h"
+#include "error.h"
+#include "util.h"
+
+#include <math.h>   // for sqrt()
+#include <string.h> // for memset()
+
+#define Z_95 1.96 // normal quantile of a 95% two-sided confidence interval
+
+//=========================================================================
+/**
+ * @brief Tool function to compute the rates of one window from the counter
+ *        differences before and after it.
+ * @param before the counters before the window
+ * @param after the counters after the window
+ * @param rates (modified) the NB_SAMPLED_RATES rates of the window
+ */
+static void window_rates(const sim_stats_t *before, const sim_stats_t *after, double *rates)
+{
+    uint64_t accesses = 0;
+    uint64_t count[NB_SAMPLED_RATES] = {0};
+    for (int type = INSTRUCTION; type <= DATA; ++type)
+    {
+        accesses += after->accesses[type] - before->accesses[type];
+        count[RATE_TLB_L1_MISS] += (after->accesses[type] - before->accesses[type])
+                                 - (after->tlb[type][HIT_L1] - before->tlb[type][HIT_L1]);
+        count[RATE_PAGE_WALK] += after->tlb[type][HIT_NONE] - before->tlb[type][HIT_NONE];
+        count[RATE_CACHE_L1_MISS] += (after->accesses[type] - before->accesses[type])
+                                   - (after->cache[type][HIT_L1] - before->cache[type][HIT_L1]);
+        count[RATE_CACHE_MEMORY] += after->cache[type][HIT_NONE] - before->cache[type][HIT_NONE];
+    }
+    for (int r = 0; r < NB_SAMPLED_RATES; ++r)
+        rates[r] = accesses == 0 ? 0.0 : (double)count[r] / (double)accesses;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to run commands [from, to) of a program.
+ * @param sim the simulator
+ * @param program the program
+ * @param from index of the first command
+ * @param to index after the last command
+ * @param detailed non-zero to go through the caches and TLBs, zero for a functional run
+ * @return error code
+ */
+static int run_commands(sim_t *sim, const program_t *program, size_t from, size_t to, int detailed)
+{
+    for (size_t i = from; i < to; ++i)
+    {
+        if (detailed)
+        {
+            byte_t data[DATA_SIZE_MAX];
+            M_EXIT_IF_ERR(mem_access(sim, &program->listing[i], data, NULL), "simulating a command");
+        }
+        else
+        {
+            M_EXIT_IF_ERR(mem_access_functional(sim, &program->listing[i], NULL), "fast-forwarding a command");
+        }
+    }
+    return ERR_NONE;
+}
+
+int sample_program(sim_t *sim, const program_t *program,
+                   const sampling_config_t *config, sampling_result_t *result)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE_NON_NULL(program);
+    M_REQUIRE_NON_NULL(config);
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE(config->window > 0, ERR_BAD_PARAMETER, "empty measurement %s", "window");
+    M_REQUIRE(config->warmup + config->window <= config->period, ERR_BAD_PARAMETER,
+              "warm-up (%zu) and window (%zu) do not fit in the period (%zu)", config->warmup, config->window, config->period);
+
+    zero_init_ptr(result);
+    double sum[NB_SAMPLED_RATES] = {0};
+    double sum_sq[NB_SAMPLED_RATES] = {0};
+    const size_t skipped = config->period - config->warmup - config->window;
+
+    size_t start = 0;
+    for (; start + config->period <= program->nb_lines; start += config->period)
+    {
+        const size_t warmup_start = start + skipped;
+        const size_t window_start = warmup_start + config->warmup;
+        M_EXIT_IF_ERR(run_commands(sim, program, start, warmup_start, config->warming), "fast-forwarding");
+        if (!config->warming && skipped > 0)
+            M_EXIT_IF_ERR(sim_flush(sim), "flushing stale caches");
+        M_EXIT_IF_ERR(run_commands(sim, program, warmup_start, window_start, 1), "warming up");
+
+        const sim_stats_t before = sim->stats;
+        M_EXIT_IF_ERR(run_commands(sim, program, window_start, start + config->period, 1), "measuring");
+        double rates[NB_SAMPLED_RATES];
+        window_rates(&before, &sim->stats, rates);
+        for (int r = 0; r < NB_SAMPLED_RATES; ++r)
+        {
+            sum[r] += rates[r];
+            sum_sq[r] += rates[r] * rates[r];
+        }
+        ++result->nb_windows;
+        if (config->warming)
+            result->detailed += skipped;
+        else
+            result->fast_forwarded += skipped;
+        result->detailed += config->warmup + config->window;
+    }
+    // the tail is not measured: just keep memory up to date
+    M_EXIT_IF_ERR(run_commands(sim, program, start, program->nb_lines, 0), "fast-forwarding the tail");
+    result->fast_forwarded += program->nb_lines - start;
+    result->measured = result->nb_windows * config->window;
+
+    const double n = (double)result->nb_windows;
+    for (int r = 0; r < NB_SAMPLED_RATES && result->nb_windows > 0; ++r)
+    {
+        result->rates[r].mean = sum[r] / n;
+        if (result->nb_windows > 1)
+        {
+            double variance = (sum_sq[r] - n * result->rates[r].mean * result->rates[r].mean) / (n - 1);
+            if (variance < 0.0)
+                variance = 0.0; // rounding errors
+            result->rates[r].half_width = Z_95 * sqrt(variance / n);
+        }
+    }
+    return ERR_NONE;
+}
+
+int sampling_print(FILE *output, const sampling_result_t *result)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(result);
+    static const char *const rate_names[NB_SAMPLED_RATES] = {
+        "TLB L1 miss rate", "page walk rate", "CACHE L1 miss rate", "memory access rate"};
+    fprintf(output, "%zu windows: %zu commands measured, %zu simulated in detail, %zu fast-forwarded\n",
+            result->nb_windows, result->measured, result->detailed, result->fast_forwarded);
+    for (int r = 0; r < NB_SAMPLED_RATES; ++r)
+        fprintf(output, "  %-18s: %.4f +/- %.4f (95%% CI)\n", rate_names[r],
+                result->rates[r].mean, result->rates[r].half_width);
+    return ERR_NONE;
+}
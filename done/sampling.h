@@ -0,0 +1,92 @@
+#pragma once
+
+/**
+ * @file sampling.h
+ * @brief statistical sampling of a program (SMARTS-style)
+ *
+ * Instead of simulating every command in detail, the program is cut into
+ * periods of `period` commands. Each period ends with `warmup` commands
+ * simulated in detail but not measured, followed by a measurement window
+ * of `window` commands. The rest of the period is fast-forwarded, either
+ * functionally (memory only, caches and TLBs flushed before the warm-up)
+ * or, with `warming` set, through the caches and TLBs without measurement.
+ * The miss rates are estimated by the mean over the windows, with a 95%
+ * confidence interval.
+ *
+ * @date 2019
+ */
+
+#include "sim.h"
+#include "commands.h"
+
+#include <stdio.h> // for FILE
+#include <stddef.h> // for size_t
+
+/**
+ * @brief parameters of the sampling
+ */
+typedef struct
+{
+    size_t period;  // number of commands from the start of a period to the next one
+    size_t window;  // number of commands measured per period
+    size_t warmup;  // number of commands simulated in detail, unmeasured, before each window
+    int warming;    // non-zero: fast-forward through the caches and TLBs (functional warming)
+} sampling_config_t;
+
+/**
+ * @brief estimated rates
+ */
+enum sampled_rate
+{
+    RATE_TLB_L1_MISS,   // the translation was not found in the L1 TLBs
+    RATE_PAGE_WALK,     // the translation needed a page walk
+    RATE_CACHE_L1_MISS, // the data was not found in the L1 caches
+    RATE_CACHE_MEMORY,  // the data was fetched from main memory
+    NB_SAMPLED_RATES
+};
+
+/**
+ * @brief an estimated rate: mean over the windows and half width of its 95% confidence interval
+ */
+typedef struct
+{
+    double mean;
+    double half_width;
+} rate_estimate_t;
+
+/**
+ * @brief result of a sampled run
+ */
+typedef struct
+{
+    size_t nb_windows;
+    size_t measured;       // number of commands measured
+    size_t detailed;       // number of commands simulated in detail (measured or not)
+    size_t fast_forwarded; // number of commands fast-forwarded
+    rate_estimate_t rates[NB_SAMPLED_RATES];
+} sampling_result_t;
+
+//=========================================================================
+/**
+ * @brief Run a program through a simulator by sampling.
+ *
+ * The commands left after the last whole period are fast-forwarded.
+ * The counters of the simulator count every command simulated in detail.
+ *
+ * @param sim the (initialized) simulator
+ * @param program the program to run
+ * @param config the sampling parameters; warmup + window shall not exceed period
+ * @param result (modified) the estimated rates
+ * @return error code
+ */
+int sample_program(sim_t *sim, const program_t *program,
+                   const sampling_config_t *config, sampling_result_t *result);
+
+//=========================================================================
+/**
+ * @brief Print the result of a sampled run to a stream.
+ * @param output the stream to print to
+ * @param result the result to print
+ * @return error code
+ */
+int sampling_print(FILE *output, const sampling_result_t *result);
@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ * @file sim.h
+ * @brief definitions associated to a simulator context: the main memory,
+ *        the two-level hierarchy of TLBs and the two-level hierarchy of caches
+ *
+ * @date 2019
+ */
+
+#include "addr.h"
+#include "mem_access.h"
+#include "tlb_hrchy.h"
+#include "cache.h"
+#include "heatmap.h"
+#include "frame_alloc.h"
+
+#include <stdint.h>
+#include <stddef.h> // for size_t
+
+#define NB_ACCESS_TYPES 2 // INSTRUCTION and DATA
+#define UTLB_MAX_ENTRIES 4 // largest micro-TLB
+
+/**
+ * @brief record of where one memory access was served from
+ */
+typedef struct
+{
+    hit_lvl_t tlb;   // HIT_NONE means a page walk was needed
+    hit_lvl_t cache; // HIT_NONE means the line was fetched from main memory
+} access_record_t;
+
+/**
+ * @brief hit counters of a simulator, per access type and per level
+ */
+typedef struct
+{
+    uint64_t accesses[NB_ACCESS_TYPES];
+    uint64_t tlb[NB_ACCESS_TYPES][NB_HIT_LEVELS];
+    uint64_t cache[NB_ACCESS_TYPES][NB_HIT_LEVELS];
+    uint64_t utlb_hits[NB_ACCESS_TYPES];   // translations served by the micro-TLB (also counted as TLB L1 hits)
+    uint64_t utlb_misses[NB_ACCESS_TYPES]; // translations passed on to the TLB hierarchy
+    uint64_t asid_switches;                // changes of address space (see sim_set_asid())
+    uint64_t page_faults;                  // entries made present by demand paging (see sim_enable_demand_paging())
+    uint64_t pte_updates;                  // entries whose accessed or dirty bit was set (see sim_enable_pte_tracking())
+    uint64_t dirty_walks;                  // walks only made to set the dirty bit of a PTE, on a first write through a TLB entry
+} sim_stats_t;
+
+/**
+ * @brief an entry of a micro-TLB: a whole virtual page number, its address space and its physical page
+ */
+typedef struct
+{
+    uint64_t vpn;
+    uint32_t ppn;
+    uint8_t v;
+    asid_t asid;
+    uint8_t dirty; // the PTE is known to be dirty, as in the TLB entries
+} utlb_entry_t;
+
+/**
+ * @brief a fully associative micro-TLB, in front of the L1 TLB of one access type;
+ *        its entries are kept from the most to the least recently used
+ */
+typedef struct
+{
+    size_t nb_entries; // 0 when the micro-TLB is switched off
+    utlb_entry_t entries[UTLB_MAX_ENTRIES];
+} utlb_t;
+
+/**
+ * @brief a simulator context: everything needed to replay commands
+ */
+typedef struct
+{
+    void *mem_space;
+    size_t mem_size;
+
+    l1_itlb_entry_t l1_itlb[L1_ITLB_LINES];
+    l1_dtlb_entry_t l1_dtlb[L1_DTLB_LINES];
+    l2_tlb_entry_t l2_tlb[L2_TLB_LINES];
+    utlb_t utlb[NB_ACCESS_TYPES];
+    asid_t asid; // address space of the accesses, tagging the TLB entries
+    pte_t page_table_roots[NB_ASIDS]; // physical address of the PGD of each address space (CR3)
+
+    l1_icache_entry_t l1_icache[L1_ICACHE_LINES * L1_ICACHE_WAYS];
+    l1_dcache_entry_t l1_dcache[L1_DCACHE_LINES * L1_DCACHE_WAYS];
+    l2_cache_entry_t l2_cache[L2_CACHE_LINES * L2_CACHE_WAYS];
+
+    sim_stats_t stats;
+
+    byte_t *dirty_pages; // bitmap of the physical pages written since sim_init(), one bit per page
+    heatmap_t *heatmap;  // locality counters, NULL unless sim_enable_heatmap() was called
+    frame_allocator_t *frames; // frames of demand paging, NULL unless sim_enable_demand_paging() was called
+    int pte_tracking;          // 1 once sim_enable_pte_tracking() was called
+} sim_t;
+
+#define SIM_NB_PAGES(MEM_SIZE) (((MEM_SIZE) + PAGE_SIZE - 1) / PAGE_SIZE)
+#define sim_page_is_dirty(SIM, PAGE) (((SIM)->dirty_pages[(PAGE) / 8] >> ((PAGE) % 8)) & 1)
+#define sim_mark_page_dirty(SIM, PAGE) ((SIM)->dirty_pages[(PAGE) / 8] |= (byte_t)(1 << ((PAGE) % 8)))
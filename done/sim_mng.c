@@ -0,0 +1,643 @@
+/**
+ * @file sim_mng.c
+ * @brief simulator management functions: translate-and-access pipeline
+ *
+ * @date 2019
+ */
+#include "sim.h"
+#include "sim_mng.h"
+#include "tlb_hrchy_mng.h"
+#include "cache_mng.h"
+#include "error.h"
+#include "util.h"
+#include "addr_mng.h"
+#include "page_walk.h"
+
+#include <inttypes.h> // for PRIu64
+#include <string.h>   // for memset(), memmove()
+#include <stdlib.h>   // for calloc(), malloc(), free()
+
+#define BITS_IN_BYTE 8
+
+int sim_init(sim_t *sim, void *mem_space, size_t mem_size)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE_NON_NULL(mem_space);
+    sim->mem_space = mem_space;
+    sim->mem_size = mem_size;
+    sim->utlb[INSTRUCTION].nb_entries = 0;
+    sim->utlb[DATA].nb_entries = 0;
+    sim->asid = 0;
+    zero_init_var(sim->page_table_roots);
+    sim->heatmap = NULL;
+    sim->frames = NULL;
+    sim->pte_tracking = 0;
+    sim->dirty_pages = calloc(SIM_NB_PAGES(mem_size) / BITS_IN_BYTE + 1, sizeof(byte_t));
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(sim->dirty_pages, ERR_MEM);
+
+    M_EXIT_IF_ERR(sim_flush(sim), "flushing the simulator");
+    zero_init_var(sim->stats);
+    return ERR_NONE;
+}
+
+int sim_flush(sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_EXIT_IF_ERR(tlb_flush(sim->l1_itlb, L1_ITLB), "flushing L1 ITLB");
+    M_EXIT_IF_ERR(tlb_flush(sim->l1_dtlb, L1_DTLB), "flushing L1 DTLB");
+    M_EXIT_IF_ERR(tlb_flush(sim->l2_tlb, L2_TLB), "flushing L2 TLB");
+    zero_init_var(sim->utlb[INSTRUCTION].entries);
+    zero_init_var(sim->utlb[DATA].entries);
+    M_EXIT_IF_ERR(cache_flush(sim->l1_icache, L1_ICACHE), "flushing L1 ICACHE");
+    M_EXIT_IF_ERR(cache_flush(sim->l1_dcache, L1_DCACHE), "flushing L1 DCACHE");
+    M_EXIT_IF_ERR(cache_flush(sim->l2_cache, L2_CACHE), "flushing L2 CACHE");
+    return ERR_NONE;
+}
+
+int sim_set_utlb(sim_t *sim, size_t nb_entries)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE(nb_entries <= UTLB_MAX_ENTRIES, ERR_BAD_PARAMETER, "micro-TLB of %zu entries", nb_entries);
+    for (int type = INSTRUCTION; type <= DATA; ++type)
+    {
+        sim->utlb[type].nb_entries = nb_entries;
+        zero_init_var(sim->utlb[type].entries);
+    }
+    return ERR_NONE;
+}
+
+int sim_set_asid(sim_t *sim, asid_t asid)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
+    if (asid != sim->asid)
+        ++sim->stats.asid_switches;
+    sim->asid = asid;
+    return ERR_NONE;
+}
+
+int sim_set_page_table_root(sim_t *sim, asid_t asid, pte_t root)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
+    M_REQUIRE(root % PAGE_SIZE == 0 && (uint64_t)root + PAGE_SIZE <= sim->mem_size, ERR_ADDR,
+              "page-table root 0x%" PRIx32 " is not a page of memory", root);
+    if (root != sim->page_table_roots[asid])
+    {
+        sim->page_table_roots[asid] = root;
+        M_EXIT_IF_ERR(sim_invalidate_asid(sim, asid), "invalidating the old translations");
+    }
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to invalidate consecutive virtual pages of an address space in all TLBs.
+ *
+ * @param sim the simulator
+ * @param asid the address space of the pages
+ * @param first_vpn the virtual page number of the first page
+ * @param nb_pages the number of pages
+ * @return error code
+ */
+static int invalidate_pages(sim_t *sim, asid_t asid, uint64_t first_vpn, uint64_t nb_pages)
+{
+    M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
+    M_EXIT_IF_ERR(tlb_invalidate_range(sim->l1_itlb, L1_ITLB, first_vpn, nb_pages, asid), "invalidating L1 ITLB");
+    M_EXIT_IF_ERR(tlb_invalidate_range(sim->l1_dtlb, L1_DTLB, first_vpn, nb_pages, asid), "invalidating L1 DTLB");
+    M_EXIT_IF_ERR(tlb_invalidate_range(sim->l2_tlb, L2_TLB, first_vpn, nb_pages, asid), "invalidating L2 TLB");
+    for (int type = INSTRUCTION; type <= DATA; ++type)
+    {
+        utlb_t *utlb = &sim->utlb[type];
+        for (size_t i = 0; i < utlb->nb_entries; ++i)
+        {
+            if (utlb->entries[i].asid == asid && utlb->entries[i].vpn >= first_vpn &&
+                utlb->entries[i].vpn - first_vpn < nb_pages)
+                utlb->entries[i].v = 0;
+        }
+    }
+    return ERR_NONE;
+}
+
+int sim_invalidate_page(sim_t *sim, asid_t asid, uint64_t vaddr)
+{
+    M_REQUIRE_NON_NULL(sim);
+    return invalidate_pages(sim, asid, vaddr64_page_number(vaddr), 1);
+}
+
+int sim_invalidate_range(sim_t *sim, asid_t asid, uint64_t vaddr, uint64_t size)
+{
+    M_REQUIRE_NON_NULL(sim);
+    if (size == 0)
+        return ERR_NONE;
+    const uint64_t first_vpn = vaddr64_page_number(vaddr);
+    return invalidate_pages(sim, asid, first_vpn, vaddr64_page_number(vaddr + size - 1) - first_vpn + 1);
+}
+
+int sim_invalidate_asid(sim_t *sim, asid_t asid)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
+    M_EXIT_IF_ERR(tlb_invalidate_asid(sim->l1_itlb, L1_ITLB, asid), "invalidating L1 ITLB");
+    M_EXIT_IF_ERR(tlb_invalidate_asid(sim->l1_dtlb, L1_DTLB, asid), "invalidating L1 DTLB");
+    M_EXIT_IF_ERR(tlb_invalidate_asid(sim->l2_tlb, L2_TLB, asid), "invalidating L2 TLB");
+    for (int type = INSTRUCTION; type <= DATA; ++type)
+    {
+        for (size_t i = 0; i < sim->utlb[type].nb_entries; ++i)
+        {
+            if (sim->utlb[type].entries[i].asid == asid)
+                sim->utlb[type].entries[i].v = 0;
+        }
+    }
+    return ERR_NONE;
+}
+
+int sim_enable_heatmap(sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(sim);
+    if (sim->heatmap != NULL)
+        return ERR_NONE;
+    sim->heatmap = malloc(sizeof(heatmap_t));
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(sim->heatmap, ERR_MEM);
+    return heatmap_init(sim->heatmap);
+}
+
+//=========================================================================
+/**
+ * @brief Page-fault handler of a simulator (see page_fault_handler_t):
+ *        the allocator of the simulator builds the missing level, and both
+ *        the table holding the entry and the new frame become dirty, so that
+ *        checkpoints hold them.
+ */
+static int sim_page_fault(void *arg, pte_t table, uint16_t index, int level, pte_t *entry)
+{
+    sim_t *sim = arg;
+    M_EXIT_IF_ERR(frame_fault(sim->frames, table, index, level, entry), "building a missing page-table level");
+    sim_mark_page_dirty(sim, table / PAGE_SIZE);
+    sim_mark_page_dirty(sim, pte_address(*entry) / PAGE_SIZE);
+    ++sim->stats.page_faults;
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to set up the walks of the page tables of an address
+ *        space, the missing entries being built once demand paging is enabled.
+ *
+ * @param sim the simulator
+ * @param asid the address space, below NB_ASIDS
+ * @param walker (modified) the walker
+ * @return error code
+ */
+static int sim_walker(sim_t *sim, asid_t asid, page_walker_t *walker)
+{
+    M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
+    M_EXIT_IF_ERR(page_walker_init(walker, sim->mem_space, sim->mem_size, sim->page_table_roots[asid]), "walking from the root");
+    if (sim->frames != NULL)
+    {
+        walker->fault_handler = sim_page_fault;
+        walker->fault_arg = sim;
+    }
+    return ERR_NONE;
+}
+
+int sim_enable_demand_paging(sim_t *sim, uint64_t first_free)
+{
+    M_REQUIRE_NON_NULL(sim);
+    if (sim->frames == NULL)
+    {
+        sim->frames = malloc(sizeof(frame_allocator_t));
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(sim->frames, ERR_MEM);
+    }
+    return frame_allocator_init(sim->frames, sim->mem_space, sim->mem_size, first_free);
+}
+
+int sim_enable_pte_tracking(sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(sim);
+    sim->pte_tracking = 1;
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to count (and clear) the accessed and dirty bits of the
+ *        PTEs below a page table (see sim_pte_scan()).
+ *
+ * @param sim the simulator
+ * @param table physical address of the page table
+ * @param level level of the table, 0 for the PGD
+ * @param clear whether to clear the bits
+ * @param accessed (modified) incremented for each accessed page
+ * @param dirty (modified) incremented for each dirty page
+ * @return error code
+ */
+static int scan_table(sim_t *sim, pte_t table, int level, int clear, uint64_t *accessed, uint64_t *dirty)
+{
+    M_REQUIRE((uint64_t)table + PAGE_SIZE <= sim->mem_size, ERR_ADDR, "page table 0x%" PRIx32 " is outside of memory", table);
+    pte_t *entries = (pte_t *)((byte_t *)sim->mem_space + table);
+    for (size_t i = 0; i < PD_ENTRIES; ++i)
+    {
+        if (level < PAGE_WALK_LEVELS - 1)
+        {
+            if (pte_is_present(entries[i]))
+            {
+                M_EXIT_IF_ERR(scan_table(sim, pte_address(entries[i]), level + 1, clear, accessed, dirty), "scanning a page table");
+            }
+            continue;
+        }
+        *accessed += (entries[i] & PTE_ACCESSED) != 0;
+        *dirty += (entries[i] & PTE_DIRTY) != 0;
+        if (clear && (entries[i] & (PTE_ACCESSED | PTE_DIRTY)))
+        {
+            entries[i] &= ~(PTE_ACCESSED | PTE_DIRTY);
+            sim_mark_page_dirty(sim, table / PAGE_SIZE);
+        }
+    }
+    return ERR_NONE;
+}
+
+int sim_pte_scan(sim_t *sim, asid_t asid, int clear, uint64_t *accessed, uint64_t *dirty)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE_NON_NULL(accessed);
+    M_REQUIRE_NON_NULL(dirty);
+    M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
+    *accessed = 0;
+    *dirty = 0;
+    M_EXIT_IF_ERR(scan_table(sim, sim->page_table_roots[asid], 0, clear, accessed, dirty), "scanning the page tables");
+    // the TLB entries would keep the cleared bits from being set again
+    return clear ? sim_invalidate_asid(sim, asid) : ERR_NONE;
+}
+
+int sim_free(sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(sim);
+    free(sim->dirty_pages);
+    sim->dirty_pages = NULL;
+    if (sim->heatmap != NULL)
+        heatmap_free(sim->heatmap);
+    free(sim->heatmap);
+    sim->heatmap = NULL;
+    free(sim->frames);
+    sim->frames = NULL;
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to count the TLB misses of a translation in the heatmap, if any.
+ *
+ * @param sim the simulator
+ * @param vpn the virtual page number translated
+ * @param type the access type
+ * @param level the TLB level that served the translation
+ * @return error code
+ */
+static int count_tlb_misses(sim_t *sim, uint64_t vpn, mem_access_t type, hit_lvl_t level)
+{
+    if (sim->heatmap == NULL || level == HIT_L1)
+        return ERR_NONE;
+    M_EXIT_IF_ERR(heatmap_tlb_miss(sim->heatmap, type == INSTRUCTION ? HEAT_L1_ITLB : HEAT_L1_DTLB, vpn), "counting an L1 TLB miss");
+    if (level == HIT_NONE)
+    {
+        M_EXIT_IF_ERR(heatmap_tlb_miss(sim->heatmap, HEAT_L2_TLB, vpn), "counting an L2 TLB miss");
+    }
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to translate a virtual address through the micro-TLB
+ *        of an access type, then through the TLB hierarchy on a micro-TLB miss.
+ *
+ * @param sim the simulator
+ * @param walker the page tables of the address space, walked on a TLB miss
+ * @param vaddr the virtual address to translate
+ * @param vaddr64 the same virtual address, as a number
+ * @param paddr (modified) the physical address
+ * @param type the access type
+ * @param level (modified) the TLB level that served the translation (HIT_L1 for the micro-TLB)
+ * @return error code
+ */
+static int utlb_translate(sim_t *sim, const page_walker_t *walker, const virt_addr_t *vaddr, uint64_t vaddr64, phy_addr_t *paddr,
+                          mem_access_t type, hit_lvl_t *level)
+{
+    utlb_t *utlb = &sim->utlb[type];
+    const uint64_t vpn = vaddr64_page_number(vaddr64);
+    if (utlb->nb_entries == 0)
+    {
+        M_EXIT_IF_ERR(tlb_translate(walker, vaddr, sim->asid, paddr, type,
+                                    sim->l1_itlb, sim->l1_dtlb, sim->l2_tlb, level),
+                      "translating the virtual address");
+        return count_tlb_misses(sim, vpn, type, *level);
+    }
+
+    size_t i = 0;
+    while (i < utlb->nb_entries &&
+           !(utlb->entries[i].v && utlb->entries[i].vpn == vpn && utlb->entries[i].asid == sim->asid))
+        ++i;
+    utlb_entry_t entry;
+    zero_init_var(entry); // padding included: the entries are checkpointed as they are in memory
+    if (i < utlb->nb_entries)
+    {
+        ++sim->stats.utlb_hits[type];
+        entry = utlb->entries[i];
+        paddr->phy_page_num = entry.ppn;
+        paddr->page_offset = vaddr64_page_offset(vaddr64);
+        *level = HIT_L1;
+    }
+    else
+    {
+        ++sim->stats.utlb_misses[type];
+        M_EXIT_IF_ERR(tlb_translate(walker, vaddr, sim->asid, paddr, type,
+                                    sim->l1_itlb, sim->l1_dtlb, sim->l2_tlb, level),
+                      "translating the virtual address");
+        M_EXIT_IF_ERR(count_tlb_misses(sim, vpn, type, *level), "counting the TLB misses");
+        entry.vpn = vpn;
+        entry.ppn = paddr->phy_page_num;
+        entry.v = 1;
+        entry.asid = sim->asid;
+        entry.dirty = 0;
+        i = utlb->nb_entries - 1; // the least recently used entry is replaced
+    }
+    // the entry used moves to the front
+    memmove(utlb->entries + 1, utlb->entries, i * sizeof(utlb_entry_t));
+    utlb->entries[0] = entry;
+    return ERR_NONE;
+}
+
+/**
+ * @brief what the walks of an access change in the entries they go through (see sim_pte_update())
+ */
+typedef struct
+{
+    sim_t *sim;
+    pte_t flags; // PTE_ACCESSED, with PTE_DIRTY for a write
+    int walked;  // whether a walk went through the PTE
+    pte_t pte;   // the PTE walked, once updated
+} pte_update_t;
+
+//=========================================================================
+/**
+ * @brief Handler of the entries walked (see page_walker_t) once
+ *        PTE tracking is enabled: sets the accessed bit of every entry, and the
+ *        dirty bit of the PTE for a write.
+ */
+static int sim_pte_update(void *arg, pte_t table, uint16_t index, int level, pte_t *entry)
+{
+    pte_update_t *update = arg;
+    sim_t *sim = update->sim;
+    M_REQUIRE((uint64_t)table + (index + 1) * sizeof(pte_t) <= sim->mem_size, ERR_ADDR,
+              "page table 0x%" PRIx32 " is outside of memory", table);
+    const int last_level = level == PAGE_WALK_LEVELS - 1;
+    const pte_t flags = last_level ? update->flags : update->flags & ~PTE_DIRTY;
+    if ((*entry & flags) != flags)
+    {
+        *entry |= flags;
+        ((pte_t *)sim->mem_space)[table / sizeof(pte_t) + index] = *entry;
+        sim_mark_page_dirty(sim, table / PAGE_SIZE);
+        ++sim->stats.pte_updates;
+    }
+    if (last_level)
+    {
+        update->walked = 1;
+        update->pte = *entry;
+    }
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to keep the dirty bit cached in the TLB entries of a
+ *        translation (micro-TLB, L1 and L2) after an access: a walk tells whether
+ *        the PTE is dirty; otherwise the first write through entries which are
+ *        not yet dirty walks again to set the dirty bit of the PTE.
+ *
+ * @param sim the simulator
+ * @param walker the page tables of the address space
+ * @param vaddr the virtual address translated
+ * @param vaddr64 the same virtual address, as a number
+ * @param command the command being executed (for its order and type)
+ * @param update (modified) what the walks of the access did
+ * @return error code
+ */
+static int cache_dirty_bit(sim_t *sim, const page_walker_t *walker, const virt_addr_t *vaddr, uint64_t vaddr64, const command_t *command,
+                           pte_update_t *update)
+{
+    if (!update->walked && command->order == READ)
+        return ERR_NONE; // nothing learnt about the PTE
+
+    const uint64_t vpn = vaddr64_page_number(vaddr64);
+    const int instruction = command->type == INSTRUCTION;
+    const size_t l1_lines = instruction ? L1_ITLB_LINES : L1_DTLB_LINES;
+    const unsigned l1_lines_bits = instruction ? L1_ITLB_LINES_BITS : L1_DTLB_LINES_BITS;
+    l1_itlb_entry_t *l1 = (instruction ? sim->l1_itlb : sim->l1_dtlb) + vpn % l1_lines;
+    l2_tlb_entry_t *l2 = sim->l2_tlb + vpn % L2_TLB_LINES;
+    // after a translation, the micro-TLB entry used is the first one
+    utlb_entry_t *micro = sim->utlb[command->type].nb_entries > 0 ? &sim->utlb[command->type].entries[0] : NULL;
+    const int in_l1 = tlb_hrchy_entry_hit(*l1, (uint32_t)(vpn >> l1_lines_bits), sim->asid,
+                                          l1_tlb_key, VIRT_PAGE_NUM - l1_lines_bits);
+    const int in_l2 = tlb_hrchy_entry_hit(*l2, (uint32_t)(vpn >> L2_TLB_LINES_BITS), sim->asid,
+                                          l2_tlb_key, VIRT_PAGE_NUM - L2_TLB_LINES_BITS);
+    const int in_micro = micro != NULL && micro->v && micro->vpn == vpn && micro->asid == sim->asid;
+
+    int dirty = (in_micro && micro->dirty) || (in_l1 && l1->dirty) || (in_l2 && l2->dirty);
+    if (update->walked)
+    {
+        dirty = (update->pte & PTE_DIRTY) != 0;
+    }
+    else if (!dirty)
+    {
+        phy_addr_t paddr;
+        page_walker_t dirty_walker = *walker;
+        dirty_walker.access_handler = sim_pte_update;
+        dirty_walker.access_arg = update;
+        M_EXIT_IF_ERR(page_walk(&dirty_walker, vaddr, &paddr), "walking the page tables to set a dirty bit");
+        ++sim->stats.dirty_walks;
+        dirty = 1;
+    }
+    if (in_micro)
+        micro->dirty = (uint8_t)dirty;
+    if (in_l1)
+        l1->dirty = (uint8_t)dirty;
+    if (in_l2)
+        l2->dirty = (uint8_t)dirty;
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to perform (part of) a command lying inside one virtual page.
+ *
+ * @param sim the simulator
+ * @param walker the page tables of the address space of the command
+ * @param command the command being executed (for its order and type)
+ * @param vaddr virtual address of the first byte of the part
+ * @param vaddr64 the same virtual address, as a number
+ * @param data the part of the data buffer to read to or write from
+ * @param size the number of bytes of the part
+ * @param record (modified) where the translation and the data were found;
+ *        NULL for a functional access, which bypasses the TLBs and the caches
+ * @return error code
+ */
+static int access_in_page(sim_t *sim, const page_walker_t *walker, const command_t *command, const virt_addr_t *vaddr, uint64_t vaddr64,
+                          byte_t *data, size_t size, access_record_t *record)
+{
+    phy_addr_t paddr;
+    pte_update_t update = {sim, command->order == WRITE ? PTE_ACCESSED | PTE_DIRTY : PTE_ACCESSED, 0, 0};
+    // the walks of this part update its entries, through a walker of its own
+    page_walker_t part_walker = *walker;
+    if (sim->pte_tracking)
+    {
+        part_walker.access_handler = sim_pte_update;
+        part_walker.access_arg = &update;
+    }
+    const int err = record == NULL ? page_walk(&part_walker, vaddr, &paddr)
+                                   : utlb_translate(sim, &part_walker, vaddr, vaddr64, &paddr, command->type, &record->tlb);
+    M_EXIT_IF_ERR(err, "translating the virtual address");
+    if (sim->pte_tracking && record != NULL)
+    {
+        M_EXIT_IF_ERR(cache_dirty_bit(sim, walker, vaddr, vaddr64, command, &update), "caching the dirty bit");
+    }
+    const uint32_t phy_addr = phy_addr_to_uint32(&paddr);
+    M_REQUIRE((uint64_t)phy_addr + size <= sim->mem_size, ERR_ADDR, "physical address 0x%" PRIx32 " is outside of memory", phy_addr);
+    if (command->order == WRITE)
+        sim_mark_page_dirty(sim, paddr.phy_page_num);
+
+    cache_heatmap_t *heat = sim->heatmap == NULL ? NULL : &sim->heatmap->caches;
+    if (record == NULL)
+    {
+        byte_t *mem = (byte_t *)sim->mem_space + phy_addr;
+        if (command->order == WRITE)
+            memcpy(mem, data, size);
+        else if (data != NULL)
+            memcpy(data, mem, size);
+    }
+    else if (command->order == WRITE)
+    {
+        M_EXIT_IF_ERR(cache_write_sized(sim->mem_space, phy_addr, sim->l1_dcache, sim->l2_cache,
+                                        data, size, &record->cache, LRU, heat),
+                      "writing to the cache");
+    }
+    else
+    {
+        void *l1_cache = (command->type == INSTRUCTION) ? (void *)sim->l1_icache : (void *)sim->l1_dcache;
+        M_EXIT_IF_ERR(cache_read_sized(sim->mem_space, phy_addr, command->type, l1_cache, sim->l2_cache,
+                                       data, size, &record->cache, LRU, heat),
+                      "reading from the cache");
+    }
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to perform a whole command, splitting it at page boundaries.
+ *
+ * @param sim the simulator
+ * @param walker the page tables of the address space of the command
+ * @param command the command to execute
+ * @param data the data buffer (see mem_access())
+ * @param record (modified) where the translation and the data were found;
+ *        NULL for a functional access (see mem_access_functional())
+ * @return error code
+ */
+static int do_access(sim_t *sim, const page_walker_t *walker, const command_t *command, void *data, access_record_t *record)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE_NON_NULL(command);
+    M_REQUIRE(command->type == INSTRUCTION || command->type == DATA, ERR_BAD_PARAMETER, "unknown access type %d", command->type);
+    M_REQUIRE(command->order == READ || command->type == DATA, ERR_BAD_PARAMETER, "cannot write %s", "instructions");
+    M_REQUIRE(command->order == WRITE || data != NULL || record == NULL, ERR_BAD_PARAMETER, "no place to read %s to", "data");
+    M_REQUIRE(command->data_size > 0 && command->data_size <= DATA_SIZE_MAX, ERR_SIZE, "unsupported data size %zu", command->data_size);
+    if (record == NULL && command->order == READ && data == NULL)
+        return ERR_NONE; // a functional read nobody looks at has no effect
+
+    byte_t buffer[DATA_SIZE_MAX];
+    byte_t *bytes = data;
+    if (command->order == WRITE)
+    { // little endian: byte 0 is the least significant byte of write_data, repeated for a line write
+        for (size_t i = 0; i < command->data_size; ++i)
+            buffer[i] = (byte_t)(command->write_data >> ((i % sizeof(uint64_t)) * BITS_IN_BYTE));
+        bytes = buffer;
+    }
+
+    // an access crossing a virtual page is split, each part being translated on its own
+    const size_t page_left = PAGE_SIZE - vaddr64_page_offset(command->vaddr64);
+    const size_t first_size = command->data_size < page_left ? command->data_size : page_left;
+    M_EXIT_IF_ERR(access_in_page(sim, walker, command, &command->vaddr, command->vaddr64, bytes, first_size, record), "accessing the first page");
+    if (first_size < command->data_size)
+    {
+        virt_addr_t next_vaddr;
+        access_record_t next_rec;
+        const uint64_t next_vaddr64 = command->vaddr64 + first_size;
+        M_EXIT_IF_ERR(init_virt_addr64(&next_vaddr, next_vaddr64), "computing the next page address");
+        M_EXIT_IF_ERR(access_in_page(sim, walker, command, &next_vaddr, next_vaddr64, bytes == NULL ? NULL : bytes + first_size,
+                                     command->data_size - first_size, record == NULL ? NULL : &next_rec),
+                      "accessing the next page");
+        if (record != NULL && next_rec.tlb > record->tlb)
+            record->tlb = next_rec.tlb;
+        if (record != NULL && next_rec.cache > record->cache)
+            record->cache = next_rec.cache;
+    }
+    return ERR_NONE;
+}
+
+int mem_access(sim_t *sim, const command_t *command, void *data, access_record_t *record)
+{
+    access_record_t rec;
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE_NON_NULL(command);
+    if (command->process != sim->asid)
+    {
+        M_EXIT_IF_ERR(sim_set_asid(sim, command->process), "switching to the process of the command");
+    }
+    page_walker_t walker;
+    M_EXIT_IF_ERR(sim_walker(sim, sim->asid, &walker), "selecting the page tables");
+    M_EXIT_IF_ERR(do_access(sim, &walker, command, data, &rec), "accessing memory");
+    ++sim->stats.accesses[command->type];
+    ++sim->stats.tlb[command->type][rec.tlb];
+    ++sim->stats.cache[command->type][rec.cache];
+    if (record != NULL)
+        *record = rec;
+    return ERR_NONE;
+}
+
+int mem_access_functional(sim_t *sim, const command_t *command, void *data)
+{
+    M_REQUIRE_NON_NULL(sim);
+    M_REQUIRE_NON_NULL(command);
+    M_REQUIRE(command->process < NB_ASIDS, ERR_BAD_PARAMETER, "process %u is not below %d", command->process, NB_ASIDS);
+    page_walker_t walker;
+    M_EXIT_IF_ERR(sim_walker(sim, command->process, &walker), "selecting the page tables");
+    return do_access(sim, &walker, command, data, NULL);
+}
+
+int sim_print_stats(FILE *output, const sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(sim);
+    static const char *const type_names[NB_ACCESS_TYPES] = {"INSTRUCTION", "DATA"};
+    for (int type = INSTRUCTION; type <= DATA; ++type)
+    {
+        const uint64_t *tlb = sim->stats.tlb[type];
+        const uint64_t *cache = sim->stats.cache[type];
+        fprintf(output, "%s: %" PRIu64 " accesses\n", type_names[type], sim->stats.accesses[type]);
+        fprintf(output, "  TLB:   L1 hits: %" PRIu64 ", L2 hits: %" PRIu64 ", page walks: %" PRIu64 "\n",
+                tlb[HIT_L1], tlb[HIT_L2], tlb[HIT_NONE]);
+        fprintf(output, "  CACHE: L1 hits: %" PRIu64 ", L2 hits: %" PRIu64 ", memory: %" PRIu64 "\n",
+                cache[HIT_L1], cache[HIT_L2], cache[HIT_NONE]);
+        if (sim->utlb[type].nb_entries > 0)
+            fprintf(output, "  uTLB:  %zu entries, hits: %" PRIu64 ", misses: %" PRIu64 "\n", sim->utlb[type].nb_entries,
+                    sim->stats.utlb_hits[type], sim->stats.utlb_misses[type]);
+    }
+    if (sim->stats.asid_switches > 0)
+        fprintf(output, "ASID switches: %" PRIu64 "\n", sim->stats.asid_switches);
+    if (sim->frames != NULL)
+        fprintf(output, "page faults: %" PRIu64 ", frames left: %" PRIu64 "\n", sim->stats.page_faults,
+                (sim->mem_size - sim->frames->next_frame) / PAGE_SIZE);
+    if (sim->pte_tracking)
+        fprintf(output, "PTE updates: %" PRIu64 ", dirty-bit walks: %" PRIu64 "\n", sim->stats.pte_updates,
+                sim->stats.dirty_walks);
+    return ERR_NONE;
+}
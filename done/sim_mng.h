@@ -0,0 +1,224 @@
+#pragma once
+
+/**
+ * @file sim_mng.h
+ * @brief simulator management functions: translate-and-access pipeline
+ *
+ * @date 2019
+ */
+
+#include "sim.h"
+#include "commands.h"
+
+#include <stdio.h> // for FILE
+
+//=========================================================================
+/**
+ * @brief "Constructor" for sim_t: flush all TLBs and caches, reset the counters,
+ *        switch the micro-TLBs off and allocate the (empty) dirty-page bitmap.
+ *
+ * @param sim (modified) the simulator to be initialized
+ * @param mem_space starting address of the memory space (not owned by the simulator)
+ * @param mem_size size of the memory space, in bytes
+ * @return error code
+ */
+int sim_init(sim_t *sim, void *mem_space, size_t mem_size);
+
+//=========================================================================
+/**
+ * @brief Start counting, for every later access, the hits, misses and evictions
+ *        of each cache set and the misses of each virtual page in each TLB
+ *        (see heatmap.h). Counting goes on until sim_free(); the counters are
+ *        not part of checkpoints.
+ *
+ * @param sim the simulator
+ * @return error code
+ */
+int sim_enable_heatmap(sim_t *sim);
+
+//=========================================================================
+/**
+ * @brief Build the page tables and pages on first touch: from now on, an
+ *        access through an entry which is not present (see pte_is_present())
+ *        takes a free frame of memory for the missing page table or page,
+ *        instead of failing. The frames are handed out from first_free up to
+ *        the end of memory (see frame_alloc.h), and the page faults are counted
+ *        in the statistics.
+ *
+ * @param sim the simulator
+ * @param first_free physical address of the first free frame, page aligned:
+ *        the pages below it (page-table roots included) are in use
+ * @return error code
+ */
+int sim_enable_demand_paging(sim_t *sim, uint64_t first_free);
+
+//=========================================================================
+/**
+ * @brief Maintain the accessed and dirty bits of the page tables, as hardware
+ *        does: from now on, each page walk sets PTE_ACCESSED in the entries it
+ *        goes through, and PTE_DIRTY in the PTE for a write. The TLB entries
+ *        cache the dirty bit, so that only the first write through an entry
+ *        which is not yet dirty walks again to set it.
+ *
+ * The page tables updated become dirty pages, so that checkpoints hold the bits.
+ * @param sim the simulator
+ * @return error code
+ */
+int sim_enable_pte_tracking(sim_t *sim);
+
+//=========================================================================
+/**
+ * @brief Count the pages of an address space whose PTE is accessed or dirty,
+ *        for working-set and writeback estimations.
+ *
+ * @param sim the simulator
+ * @param asid the address space, whose page tables are scanned
+ * @param clear if non-zero, also clear the bits counted, as a reclaim scan
+ *        does, and invalidate the TLB entries of the address space so that
+ *        the next accesses set them again
+ * @param accessed (modified) the number of accessed pages
+ * @param dirty (modified) the number of dirty pages
+ * @return error code
+ */
+int sim_pte_scan(sim_t *sim, asid_t asid, int clear, uint64_t *accessed, uint64_t *dirty);
+
+//=========================================================================
+/**
+ * @brief "Destructor" for sim_t: free the dirty-page bitmap, the heatmap and the frame allocator
+ *        (but not the memory space).
+ * @param sim the simulator to be freed
+ * @return error code
+ */
+int sim_free(sim_t *sim);
+
+//=========================================================================
+/**
+ * @brief Invalidate all TLBs (micro-TLBs included) and caches
+ *        (counters and memory are left untouched).
+ * @param sim the simulator
+ * @return error code
+ */
+int sim_flush(sim_t *sim);
+
+//=========================================================================
+/**
+ * @brief Switch the micro-TLBs (one per access type) on or off.
+ *
+ * A micro-TLB remembers the last translations of its access type and serves
+ * them without looking the L1 TLB up, which then does not see these
+ * accesses. Its hits are counted both as micro-TLB hits and as TLB L1 hits.
+ *
+ * @param sim the simulator
+ * @param nb_entries number of entries of each micro-TLB, from 1 to
+ *        UTLB_MAX_ENTRIES; 0 switches them off
+ * @return error code
+ */
+int sim_set_utlb(sim_t *sim, size_t nb_entries);
+
+//=========================================================================
+/**
+ * @brief Switch to another address space (0 after sim_init()).
+ *
+ * The TLB entries, micro-TLBs included, are tagged with the address space
+ * they were filled for and only hit for it: a switch flushes nothing, the
+ * address spaces sharing (and competing for) the TLBs.
+ * mem_access() switches to the process each command is tagged with.
+ *
+ * @param sim the simulator
+ * @param asid the address-space identifier, below NB_ASIDS
+ * @return error code
+ */
+int sim_set_asid(sim_t *sim, asid_t asid);
+
+//=========================================================================
+/**
+ * @brief Set the page-table root (as x86 CR3) of an address space: the
+ *        physical address of its PGD, 0 for all of them after sim_init().
+ *
+ * The address spaces of distinct roots translate the same virtual addresses
+ * to distinct physical pages, unless their page tables share them. The TLB
+ * entries of the address space are invalidated when its root changes.
+ *
+ * @param sim the simulator
+ * @param asid the address space
+ * @param root physical address of its PGD, page aligned and inside memory
+ * @return error code
+ */
+int sim_set_page_table_root(sim_t *sim, asid_t asid, pte_t root);
+
+//=========================================================================
+/**
+ * @brief Invalidate the translation of one virtual page of an address space
+ *        in all TLBs, micro-TLBs included (as x86 INVLPG); the caches are left.
+ * @param sim the simulator
+ * @param asid the address space of the page
+ * @param vaddr a virtual address in the page
+ * @return error code
+ */
+int sim_invalidate_page(sim_t *sim, asid_t asid, uint64_t vaddr);
+
+//=========================================================================
+/**
+ * @brief Invalidate the translations of the virtual pages overlapping
+ *        [vaddr, vaddr + size) of an address space in all TLBs, micro-TLBs included.
+ * @param sim the simulator
+ * @param asid the address space of the range
+ * @param vaddr the first virtual address of the range
+ * @param size the size of the range, in bytes (nothing is invalidated if 0)
+ * @return error code
+ */
+int sim_invalidate_range(sim_t *sim, asid_t asid, uint64_t vaddr, uint64_t size);
+
+//=========================================================================
+/**
+ * @brief Invalidate all the translations of an address space in all TLBs,
+ *        micro-TLBs included, leaving those of the other address spaces
+ *        (e.g. when it is recycled for another process).
+ * @param sim the simulator
+ * @param asid the address space
+ * @return error code
+ */
+int sim_invalidate_asid(sim_t *sim, asid_t asid);
+
+//=========================================================================
+/**
+ * @brief Execute one command: micro-TLB and TLB lookup (page walk on miss), then cache access.
+ *
+ * Any data size from a byte to a full cache line is accepted, at any alignment:
+ * accesses crossing a cache line or a page are split. Writes follow the cache
+ * policy: write-allocate, then write-through to main memory.
+ *
+ * @param sim the simulator
+ * @param command the command to execute
+ * @param data (modified) buffer of at least command->data_size bytes, filled with the
+ *        data read in memory order (little endian); untouched on writes (may then be NULL)
+ * @param record (modified) where the translation and the data were found; may be NULL
+ * @return error code
+ */
+int mem_access(sim_t *sim, const command_t *command, void *data, access_record_t *record);
+
+//=========================================================================
+/**
+ * @brief Execute one command functionally: page walk, then direct memory access,
+ *        bypassing the TLBs and the caches and leaving the counters untouched.
+ *
+ * Meant to fast-forward through a trace. Since the caches are not updated on
+ * writes, they may hold stale lines afterwards: flush them (sim_flush()) or
+ * warm them again before going back to mem_access().
+ *
+ * @param sim the simulator
+ * @param command the command to execute
+ * @param data (modified) buffer for the data read, as for mem_access(); may be
+ *        NULL, reads then having no effect at all
+ * @return error code
+ */
+int mem_access_functional(sim_t *sim, const command_t *command, void *data);
+
+//=========================================================================
+/**
+ * @brief Print the hit counters of a simulator to a stream.
+ * @param output the stream to print to
+ * @param sim the simulator
+ * @return error code
+ */
+int sim_print_stats(FILE *output, const sim_t *sim);
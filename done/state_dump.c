@@ -0,0 +1,236 @@
+/**
+ * @file state_dump.c
+ * @brief binary dumps of the TLBs and caches of a simulator, and their decoding
+ *
+ * File layout (native byte order, meant to be read back by the same build):
+ *   for each dump, a header, then for each of the six structures its
+ *   geometry followed by its entries as they are in memory.
+ *
+ * @date 2019
+ */
+#include "state_dump.h"
+#include "tlb_hrchy_mng.h"
+#include "cache_mng.h"
+#include "error.h"
+#include "util.h"
+
+#include <stdint.h>
+#include <string.h> // for memcmp(), strcmp()
+
+#define MAX_TEXT_LINE 256 // longer than any line of tlb_dump() or cache_dump()
+
+/**
+ * @brief header of a dump
+ */
+typedef struct
+{
+    char magic[sizeof(STATE_DUMP_MAGIC)];
+    uint32_t version;
+    uint32_t nb_sections;
+} state_dump_header_t;
+
+/**
+ * @brief geometry of a structure, written before its entries
+ */
+typedef struct
+{
+    uint32_t section;
+    uint32_t lines;
+    uint32_t ways;
+    uint32_t entry_size;
+} state_section_header_t;
+
+/**
+ * @brief what this build knows of each structure
+ */
+typedef struct
+{
+    const char *name;
+    uint32_t lines;
+    uint32_t ways;
+    uint32_t entry_size;
+    int is_tlb;
+    int type; // its tlb_t or cache_t
+} section_info_t;
+
+static const section_info_t SECTIONS[NB_STATE_SECTIONS] = {
+    {"L1_ITLB", L1_ITLB_LINES, 1, sizeof(l1_itlb_entry_t), 1, L1_ITLB},
+    {"L1_DTLB", L1_DTLB_LINES, 1, sizeof(l1_dtlb_entry_t), 1, L1_DTLB},
+    {"L2_TLB", L2_TLB_LINES, 1, sizeof(l2_tlb_entry_t), 1, L2_TLB},
+    {"L1_ICACHE", L1_ICACHE_LINES, L1_ICACHE_WAYS, sizeof(l1_icache_entry_t), 0, L1_ICACHE},
+    {"L1_DCACHE", L1_DCACHE_LINES, L1_DCACHE_WAYS, sizeof(l1_dcache_entry_t), 0, L1_DCACHE},
+    {"L2_CACHE", L2_CACHE_LINES, L2_CACHE_WAYS, sizeof(l2_cache_entry_t), 0, L2_CACHE},
+};
+
+// pointers to the arrays of a simulator or of a state, in file order
+#define STATE_SECTIONS(STATE)                                           \
+    {                                                                   \
+        (STATE)->l1_itlb, (STATE)->l1_dtlb, (STATE)->l2_tlb,            \
+            (STATE)->l1_icache, (STATE)->l1_dcache, (STATE)->l2_cache   \
+    }
+
+#define section_size(INFO) ((size_t)(INFO).lines * (INFO).ways * (INFO).entry_size)
+
+#define write_or_fail(PTR, SIZE, FILE)                                            \
+    M_REQUIRE(fwrite(PTR, SIZE, 1, FILE) == 1, ERR_IO, "cannot write %zu bytes", (size_t)(SIZE))
+#define read_or_fail(PTR, SIZE, FILE)                                             \
+    M_REQUIRE(fread(PTR, SIZE, 1, FILE) == 1, ERR_IO, "cannot read %zu bytes", (size_t)(SIZE))
+
+int state_section_from_name(const char *name, state_section_t *section)
+{
+    M_REQUIRE_NON_NULL(name);
+    M_REQUIRE_NON_NULL(section);
+    for (int i = 0; i < NB_STATE_SECTIONS; ++i)
+    {
+        if (strcmp(SECTIONS[i].name, name) == 0)
+        {
+            *section = (state_section_t)i;
+            return ERR_NONE;
+        }
+    }
+    return ERR_BAD_PARAMETER;
+}
+
+int state_dump_write(FILE *output, const sim_t *sim)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(sim);
+
+    state_dump_header_t header;
+    zero_init_var(header);
+    memcpy(header.magic, STATE_DUMP_MAGIC, sizeof(header.magic));
+    header.version = STATE_DUMP_VERSION;
+    header.nb_sections = NB_STATE_SECTIONS;
+    write_or_fail(&header, sizeof(header), output);
+
+    const void *sections[NB_STATE_SECTIONS] = STATE_SECTIONS(sim);
+    for (int i = 0; i < NB_STATE_SECTIONS; ++i)
+    {
+        const state_section_header_t geometry = {(uint32_t)i, SECTIONS[i].lines, SECTIONS[i].ways, SECTIONS[i].entry_size};
+        write_or_fail(&geometry, sizeof(geometry), output);
+        write_or_fail(sections[i], section_size(SECTIONS[i]), output);
+    }
+    return ERR_NONE;
+}
+
+int state_dump_read(FILE *input, sim_state_t *state)
+{
+    M_REQUIRE_NON_NULL(input);
+    M_REQUIRE_NON_NULL(state);
+
+    state_dump_header_t header;
+    const size_t nb_read = fread(&header, 1, sizeof(header), input);
+    if (nb_read == 0 && feof(input))
+        return ERR_EOF;
+    M_REQUIRE(nb_read == sizeof(header), ERR_IO, "truncated header of %zu bytes", nb_read);
+    M_REQUIRE(memcmp(header.magic, STATE_DUMP_MAGIC, sizeof(header.magic)) == 0, ERR_IO, "not a %s file", "state dump");
+    M_REQUIRE(header.version == STATE_DUMP_VERSION, ERR_IO, "unsupported state dump version %u", header.version);
+    M_REQUIRE(header.nb_sections == NB_STATE_SECTIONS, ERR_SIZE, "%u structures instead of %d", header.nb_sections, NB_STATE_SECTIONS);
+
+    void *sections[NB_STATE_SECTIONS] = STATE_SECTIONS(state);
+    for (int i = 0; i < NB_STATE_SECTIONS; ++i)
+    {
+        state_section_header_t geometry;
+        read_or_fail(&geometry, sizeof(geometry), input);
+        M_REQUIRE(geometry.section == (uint32_t)i && geometry.lines == SECTIONS[i].lines && geometry.ways == SECTIONS[i].ways && geometry.entry_size == SECTIONS[i].entry_size,
+                  ERR_SIZE, "%s: %u lines of %u ways of %u bytes, not the geometry of this build",
+                  SECTIONS[i].name, geometry.lines, geometry.ways, geometry.entry_size);
+        read_or_fail(sections[i], section_size(SECTIONS[i]), input);
+    }
+    return ERR_NONE;
+}
+
+// prints the entries of a structure, without its name
+static int section_print(FILE *output, const sim_state_t *state, int section)
+{
+    const void *sections[NB_STATE_SECTIONS] = STATE_SECTIONS(state);
+    if (SECTIONS[section].is_tlb)
+    {
+        M_EXIT_IF_ERR(tlb_dump(output, sections[section], (tlb_t)SECTIONS[section].type), "printing a TLB");
+        putc('\n', output);
+        return ERR_NONE;
+    }
+    return cache_dump(output, sections[section], (cache_t)SECTIONS[section].type);
+}
+
+int state_print(FILE *output, const sim_state_t *state, const int shown[NB_STATE_SECTIONS])
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(state);
+    M_REQUIRE_NON_NULL(shown);
+
+    for (int i = 0; i < NB_STATE_SECTIONS; ++i)
+    {
+        if (shown[i])
+        {
+            fprintf(output, "%s: \n\n", SECTIONS[i].name);
+            M_EXIT_IF_ERR(section_print(output, state, i), "printing a structure");
+        }
+    }
+    return ERR_NONE;
+}
+
+// the text of a structure, in a temporary file rewound for reading
+static FILE *section_text(const sim_state_t *state, int section)
+{
+    FILE *text = tmpfile();
+    if (text == NULL)
+        return NULL;
+    if (section_print(text, state, section) != ERR_NONE || fflush(text) != 0)
+    {
+        fclose(text);
+        return NULL;
+    }
+    rewind(text);
+    return text;
+}
+
+// compares the texts of a structure line by line, the lines being the entries
+static int section_diff(FILE *output, FILE *first, FILE *second, const char *name, size_t *nb_diffs)
+{
+    char line1[MAX_TEXT_LINE];
+    char line2[MAX_TEXT_LINE];
+    int named = 0;
+    while (fgets(line1, sizeof(line1), first) != NULL)
+    {
+        M_REQUIRE(fgets(line2, sizeof(line2), second) != NULL, ERR_IO, "%s: texts of different lengths", name);
+        if (strcmp(line1, line2) != 0)
+        {
+            if (!named)
+                fprintf(output, "%s: \n", name);
+            named = 1;
+            fprintf(output, "< %s> %s", line1, line2);
+            ++*nb_diffs;
+        }
+    }
+    return ERR_NONE;
+}
+
+int state_diff(FILE *output, const sim_state_t *first, const sim_state_t *second,
+               const int shown[NB_STATE_SECTIONS], size_t *nb_diffs)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(first);
+    M_REQUIRE_NON_NULL(second);
+    M_REQUIRE_NON_NULL(shown);
+    M_REQUIRE_NON_NULL(nb_diffs);
+
+    *nb_diffs = 0;
+    const void *sections1[NB_STATE_SECTIONS] = STATE_SECTIONS(first);
+    const void *sections2[NB_STATE_SECTIONS] = STATE_SECTIONS(second);
+    for (int i = 0; i < NB_STATE_SECTIONS; ++i)
+    {
+        // identical entries print the same: only differing structures are rendered
+        if (!shown[i] || memcmp(sections1[i], sections2[i], section_size(SECTIONS[i])) == 0)
+            continue;
+        FILE *text1 = section_text(first, i);
+        FILE *text2 = section_text(second, i);
+        int err = text1 == NULL || text2 == NULL ? ERR_IO : section_diff(output, text1, text2, SECTIONS[i].name, nb_diffs);
+        if (text1 != NULL)
+            fclose(text1);
+        if (text2 != NULL)
+            fclose(text2);
+        M_EXIT_IF_ERR(err, "comparing a structure");
+    }
+    return ERR_NONE;
+}
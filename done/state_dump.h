@@ -0,0 +1,108 @@
+#pragma once
+
+/**
+ * @file state_dump.h
+ * @brief binary dumps of the TLBs and caches of a simulator, and their decoding
+ *
+ * A state dump is a header followed by the six TLB and cache arrays, each
+ * one preceded by its geometry (lines, ways, entry size) and written as it
+ * is in memory: writing one costs a few fwrite() of about 90 KiB, against
+ * about 400 KiB of text. Dumps may be appended to the same stream, e.g. one
+ * per command; decode-state renders them as text, or compares two streams,
+ * only when needed.
+ *
+ * @date 2019
+ */
+
+#include "sim.h"
+#include "tlb_hrchy.h"
+#include "cache.h"
+
+#include <stdio.h>  // for FILE
+#include <stddef.h> // for size_t
+
+#define STATE_DUMP_MAGIC "PPSSTAT"
+#define STATE_DUMP_VERSION 1
+
+/**
+ * @brief the structures of a state dump, in file order
+ */
+typedef enum
+{
+    STATE_L1_ITLB,
+    STATE_L1_DTLB,
+    STATE_L2_TLB,
+    STATE_L1_ICACHE,
+    STATE_L1_DCACHE,
+    STATE_L2_CACHE,
+    NB_STATE_SECTIONS
+} state_section_t;
+
+/**
+ * @brief the TLBs and caches of a simulator, as read back from a state dump
+ */
+typedef struct
+{
+    l1_itlb_entry_t l1_itlb[L1_ITLB_LINES];
+    l1_dtlb_entry_t l1_dtlb[L1_DTLB_LINES];
+    l2_tlb_entry_t l2_tlb[L2_TLB_LINES];
+
+    l1_icache_entry_t l1_icache[L1_ICACHE_LINES * L1_ICACHE_WAYS];
+    l1_dcache_entry_t l1_dcache[L1_DCACHE_LINES * L1_DCACHE_WAYS];
+    l2_cache_entry_t l2_cache[L2_CACHE_LINES * L2_CACHE_WAYS];
+} sim_state_t;
+
+//=========================================================================
+/**
+ * @brief Get a structure of a state dump from its name ("L1_ITLB", ..., "L2_CACHE").
+ * @param name the name of the structure
+ * @param section (modified) the structure of that name
+ * @return error code, ERR_BAD_PARAMETER for an unknown name
+ */
+int state_section_from_name(const char *name, state_section_t *section);
+
+//=========================================================================
+/**
+ * @brief Append a dump of the TLBs and caches of a simulator to a binary stream.
+ * @param output the stream to write to (opened in binary mode)
+ * @param sim the simulator to dump
+ * @return error code
+ */
+int state_dump_write(FILE *output, const sim_t *sim);
+
+//=========================================================================
+/**
+ * @brief Read the next dump of a binary stream.
+ *
+ * The geometry of each structure must be that of this build.
+ * @param input the stream to read from (opened in binary mode)
+ * @param state (modified) the TLBs and caches read
+ * @return error code, ERR_EOF if the stream has no more dump
+ */
+int state_dump_read(FILE *input, sim_state_t *state);
+
+//=========================================================================
+/**
+ * @brief Print some structures of a state as text: for each one its name, then
+ *        its entries as tlb_dump() or cache_dump() print them.
+ * @param output the stream to print to
+ * @param state the state to print
+ * @param shown which structures to print, indexed by state_section_t
+ * @return error code
+ */
+int state_print(FILE *output, const sim_state_t *state, const int shown[NB_STATE_SECTIONS]);
+
+//=========================================================================
+/**
+ * @brief Print the differences between two states, structure by structure:
+ *        the name of a structure which differs, then each differing entry as
+ *        printed for the first state ("< ") and for the second one ("> ").
+ * @param output the stream to print to
+ * @param first the first state
+ * @param second the second state
+ * @param shown which structures to compare, indexed by state_section_t
+ * @param nb_diffs (modified) the number of entries which differ
+ * @return error code
+ */
+int state_diff(FILE *output, const sim_state_t *first, const sim_state_t *second,
+               const int shown[NB_STATE_SECTIONS], size_t *nb_diffs);
@@ -0,0 +1,126 @@
+/**
+ * @file test-cache.c
+ * @brief black-box testing of cache management functions
+ *
+ * @author Atri Bhattacharyya
+ * @date 2019
+ */
+
+#if defined _WIN32  || defined _WIN64
+#define __USE_MINGW_ANSI_STDIO 1
+#endif
+
+#include "error.h"
+// #include "memory.h"
+// #include "util.h"  // for zero_init_var()
+// #include "addr_mng.h" // for init_virt_addr64()
+
+#include "cache_mng.h"
+#include "commands.h"
+#include "memory.h"
+#include "sim_mng.h"
+#include "state_dump.h"
+
+// #include <stdio.h>
+#include <assert.h>
+#include <string.h>
+// #include <ctype.h> // for isspace()
+// #include <inttypes.h> // for SCNx macro
+
+// ======================================================================
+static void error(const char* pgm, const char* msg)
+{
+    assert(msg != NULL);
+    fputs("ERROR: ", stderr);
+    fputs(msg, stderr);
+    fprintf(stderr, "\nusage:    %s (dump|desc) mem_filename command_filename [delta | state state_filename]\n", pgm);
+    fprintf(stderr, "examples: %s dump memory_dump.bin commands01.txt\n", pgm);
+    fprintf(stderr, "          %s desc memory_description.txt commands01.txt\n", pgm);
+    fprintf(stderr, "          %s dump memory_dump.bin commands01.txt delta  (only the entries changed by each command)\n", pgm);
+    fprintf(stderr, "          %s dump memory_dump.bin commands01.txt state states.bin  (binary dumps, see decode-state)\n", pgm);
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        error(argv[0], "please provide command, format, spacer and filename to read from:");
+        return 1;
+    }
+    int dump = 1;
+    if (strcmp(argv[1], "dump")) {
+        if (strcmp(argv[1], "desc")) {
+            error(argv[0], "unknown command.");
+            return 1;
+        }
+        dump = 0;
+    }
+    const int delta = argc > 4 && !strcmp(argv[4], "delta");
+    FILE* states = NULL;
+    if (argc > 4 && !strcmp(argv[4], "state")) {
+        states = argc > 5 ? fopen(argv[5], "wb") : NULL;
+        if (states == NULL) {
+            error(argv[0], "cannot open the state dump file.");
+            return 1;
+        }
+    }
+
+    void* mem_space = NULL;
+    size_t mem_size = 0;
+    int err = ERR_NONE;
+    if (dump)
+        err = mem_init_from_dumpfile(argv[2], &mem_space, &mem_size);
+    else
+        err = mem_init_from_description(argv[2], &mem_space, &mem_size);
+
+
+    program_t pgm;
+    if (err == ERR_NONE) {
+        if(program_read(argv[3], &pgm) == ERR_NONE) {
+            static sim_t sim;
+            assert(sim_init(&sim, mem_space, mem_size) == ERR_NONE);
+            // the caches as of the previous dump, all invalid at first
+            static l1_icache_entry_t shown_l1_icache[L1_ICACHE_LINES * L1_ICACHE_WAYS];
+            static l1_dcache_entry_t shown_l1_dcache[L1_DCACHE_LINES * L1_DCACHE_WAYS];
+            static l2_cache_entry_t shown_l2_cache[L2_CACHE_LINES * L2_CACHE_WAYS];
+
+            for_all_lines(line, &pgm) {
+                byte_t data[DATA_SIZE_MAX];
+                assert(mem_access(&sim, line, data, NULL) == ERR_NONE);
+
+                if (states != NULL) {
+                    assert(state_dump_write(states, &sim) == ERR_NONE);
+                    continue;
+                }
+                if (delta) {
+                    printf("L1_ICACHE: \n\n");
+                    cache_dump_delta(stdout, sim.l1_icache, shown_l1_icache, L1_ICACHE);
+                    printf("L1_DCACHE: \n\n");
+                    cache_dump_delta(stdout, sim.l1_dcache, shown_l1_dcache, L1_DCACHE);
+                    printf("L2_CACHE: \n\n");
+                    cache_dump_delta(stdout, sim.l2_cache, shown_l2_cache, L2_CACHE);
+                } else {
+                    printf("L1_ICACHE: \n\n");
+                    cache_dump(stdout, sim.l1_icache, L1_ICACHE);
+                    printf("L1_DCACHE: \n\n");
+                    cache_dump(stdout, sim.l1_dcache, L1_DCACHE);
+                    printf("L2_CACHE: \n\n");
+                    cache_dump(stdout, sim.l2_cache, L2_CACHE);
+                }
+                printf("\n=======================================\n\n");
+            }
+            sim_free(&sim);
+        } else {
+            error(argv[0], "problem initializing program from provided file.");
+            return 3;
+        }
+    } else {
+        error(argv[0], "problem initializing memory from provided file.");
+        return 3;
+    }
+
+    if (states != NULL) fclose(states);
+    (void)program_free(&pgm);
+    free(mem_space);
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file test-checkpoint.c
+ * @brief black-box testing of simulator checkpoint and restore
+ *
+ * Runs the first half of a program, saves a checkpoint and finishes the run;
+ * then restores the checkpoint into a fresh simulator, replays the second half
+ * and checks that both simulators end up in the very same state.
+ *
+ * @date 2019
+ */
+
+#if defined _WIN32  || defined _WIN64
+#define __USE_MINGW_ANSI_STDIO 1
+#endif
+
+#include "error.h"
+#include "commands.h"
+#include "memory.h"
+#include "sim_mng.h"
+#include "checkpoint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ======================================================================
+static void error(const char* pgm, const char* msg)
+{
+    fputs("ERROR: ", stderr);
+    fputs(msg, stderr);
+    fprintf(stderr, "\nusage:    %s (dump|desc) mem_filename command_filename [utlb_entries]\n", pgm);
+    fprintf(stderr, "examples: %s dump memory_dump.bin commands01.txt\n", pgm);
+    fprintf(stderr, "          %s desc memory_description.txt commands01.txt\n", pgm);
+}
+
+// ======================================================================
+static int load_memory(int dump, const char* filename, void** mem_space, size_t* mem_size)
+{
+    return dump ? mem_init_from_dumpfile(filename, mem_space, mem_size)
+                : mem_init_from_description(filename, mem_space, mem_size);
+}
+
+// ======================================================================
+static int run(sim_t* sim, const program_t* pgm, size_t from, size_t to)
+{
+    for (size_t i = from; i < to; ++i) {
+        byte_t data[DATA_SIZE_MAX];
+        M_EXIT_IF_ERR(mem_access(sim, &pgm->listing[i], data, NULL), "executing a command");
+    }
+    return ERR_NONE;
+}
+
+// ======================================================================
+#define same(A, B, FIELD) (memcmp(&(A)->FIELD, &(B)->FIELD, sizeof((A)->FIELD)) == 0)
+
+static int same_state(const sim_t* a, const sim_t* b)
+{
+    return same(a, b, l1_itlb) && same(a, b, l1_dtlb) && same(a, b, l2_tlb) && same(a, b, utlb)
+        && same(a, b, l1_icache) && same(a, b, l1_dcache) && same(a, b, l2_cache)
+        && same(a, b, stats) && a->mem_size == b->mem_size
+        && memcmp(a->mem_space, b->mem_space, a->mem_size) == 0;
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        error(argv[0], "please provide format, memory and command filenames:");
+        return 1;
+    }
+    int dump = 1;
+    if (strcmp(argv[1], "dump")) {
+        if (strcmp(argv[1], "desc")) {
+            error(argv[0], "unknown command.");
+            return 1;
+        }
+        dump = 0;
+    }
+
+    void* mem_ref = NULL;
+    void* mem_restored = NULL;
+    size_t mem_size = 0;
+    if (load_memory(dump, argv[2], &mem_ref, &mem_size) != ERR_NONE
+        || load_memory(dump, argv[2], &mem_restored, &mem_size) != ERR_NONE) {
+        error(argv[0], "problem initializing memory from provided file.");
+        return 3;
+    }
+
+    program_t pgm;
+    if (program_read(argv[3], &pgm) != ERR_NONE) {
+        error(argv[0], "problem initializing program from provided file.");
+        return 3;
+    }
+
+    static sim_t ref, restored;
+    const size_t half = pgm.nb_lines / 2;
+    FILE* checkpoint = tmpfile();
+    int err = checkpoint == NULL ? ERR_IO : ERR_NONE;
+    if (err == ERR_NONE) err = sim_init(&ref, mem_ref, mem_size);
+    if (err == ERR_NONE) err = sim_init(&restored, mem_restored, mem_size);
+    // the micro-TLBs of the reference are restored, their size included
+    if (err == ERR_NONE && argc > 4) err = sim_set_utlb(&ref, strtoul(argv[4], NULL, 0));
+    if (err == ERR_NONE) err = run(&ref, &pgm, 0, half);
+    if (err == ERR_NONE) err = checkpoint_write(checkpoint, &ref);
+    if (err == ERR_NONE) err = run(&ref, &pgm, half, pgm.nb_lines);
+    if (err == ERR_NONE) {
+        rewind(checkpoint);
+        err = checkpoint_read(checkpoint, &restored);
+    }
+    if (err == ERR_NONE) err = run(&restored, &pgm, half, pgm.nb_lines);
+
+    if (err != ERR_NONE) {
+        fprintf(stderr, "ERROR: %s\n", ERR_MESSAGES[err - ERR_NONE]);
+    } else {
+        printf("restored after %zu of %zu commands\n", half, pgm.nb_lines);
+        sim_print_stats(stdout, &restored);
+        puts(same_state(&ref, &restored) ? "same state" : "DIFFERENT state");
+    }
+
+    if (checkpoint != NULL) fclose(checkpoint);
+    sim_free(&ref);
+    sim_free(&restored);
+    (void)program_free(&pgm);
+    free(mem_ref);
+    free(mem_restored);
+    return err == ERR_NONE ? 0 : 2;
+}
@@ -80,6 +80,8 @@ int main(int argc, char *argv[])
     if (err == ERR_NONE) {
         virt_addr_t vaddr;
         zero_init_var(vaddr);
+        page_walker_t walker;
+        (void)page_walker_init(&walker, mem_space, mem_size, 0);
 
         int i;
         uint64_t vaddr64;
@@ -95,7 +97,7 @@ int main(int argc, char *argv[])
                 return 2;
             }
 
-            vmem_page_dump_with_options(mem_space, &vaddr, t_fmt, 16, argv[4]);
+            vmem_page_dump_with_options(&walker, &vaddr, t_fmt, 16, argv[4]);
 
         }
 
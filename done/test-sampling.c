@@ -0,0 +1,84 @@
+/**
+ * @file test-sampling.c
+ * @brief black-box testing of the sampling executor
+ *
+ * @date 2019
+ */
+
+#if defined _WIN32  || defined _WIN64
+#define __USE_MINGW_ANSI_STDIO 1
+#endif
+
+#include "error.h"
+#include "commands.h"
+#include "memory.h"
+#include "sim_mng.h"
+#include "sampling.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ======================================================================
+static void error(const char* pgm, const char* msg)
+{
+    fputs("ERROR: ", stderr);
+    fputs(msg, stderr);
+    fprintf(stderr, "\nusage:    %s (dump|desc) mem_filename command_filename period window warmup [warm]\n", pgm);
+    fprintf(stderr, "examples: %s dump memory_dump.bin commands01.txt 1000 100 50\n", pgm);
+    fprintf(stderr, "          %s desc memory_description.txt commands01.txt 1000 100 0 warm\n", pgm);
+}
+
+// ======================================================================
+int main(int argc, char *argv[])
+{
+    if (argc < 7) {
+        error(argv[0], "please provide format, memory and command filenames and sampling parameters:");
+        return 1;
+    }
+    int dump = 1;
+    if (strcmp(argv[1], "dump")) {
+        if (strcmp(argv[1], "desc")) {
+            error(argv[0], "unknown command.");
+            return 1;
+        }
+        dump = 0;
+    }
+    const sampling_config_t config = {
+        .period = strtoul(argv[4], NULL, 10),
+        .window = strtoul(argv[5], NULL, 10),
+        .warmup = strtoul(argv[6], NULL, 10),
+        .warming = argc > 7 && !strcmp(argv[7], "warm")
+    };
+
+    void* mem_space = NULL;
+    size_t mem_size = 0;
+    int err = dump ? mem_init_from_dumpfile(argv[2], &mem_space, &mem_size)
+                   : mem_init_from_description(argv[2], &mem_space, &mem_size);
+    if (err != ERR_NONE) {
+        error(argv[0], "problem initializing memory from provided file.");
+        return 3;
+    }
+
+    program_t pgm;
+    if (program_read(argv[3], &pgm) != ERR_NONE) {
+        error(argv[0], "problem initializing program from provided file.");
+        free(mem_space);
+        return 3;
+    }
+
+    static sim_t sim;
+    sampling_result_t result;
+    err = sim_init(&sim, mem_space, mem_size);
+    if (err == ERR_NONE) err = sample_program(&sim, &pgm, &config, &result);
+    if (err == ERR_NONE) {
+        sampling_print(stdout, &result);
+    } else {
+        fprintf(stderr, "ERROR: %s\n", ERR_MESSAGES[err - ERR_NONE]);
+    }
+
+    sim_free(&sim);
+    (void)program_free(&pgm);
+    free(mem_space);
+    return err == ERR_NONE ? 0 : 2;
+}
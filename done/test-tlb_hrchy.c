@@ -20,6 +20,8 @@
 #include "tlb_hrchy_mng.h"
 
 #include <inttypes.h> // for PRIx macros
+#include <stdlib.h>   // for strtoull()
+#include <string.h>   // for strcmp()
 
 // --------------------------------------------------
 #define print_all_tlb_entries(tlb, TYPE, N)                                      \
@@ -38,6 +40,14 @@
                 );                                                               \
         }} while(0)
 
+// --------------------------------------------------
+// the entries changed since the previous dump, SHOWN keeping the TLBs as then
+#define print_changed_tlb_entries(tlb, SHOWN, TYPE)     \
+    do {                                               \
+        fputc('\n', f_out); fputc('\n', f_out);         \
+        tlb_dump_delta(f_out, tlb, SHOWN, TYPE);       \
+    } while(0)
+
 // ======================================================================
 static void usage()
 {
@@ -45,8 +55,17 @@ static void usage()
     fputs("\t- one (txt) to read commands from;\n", stderr);
     fputs("\t- one (bin) to memory content from;\n", stderr);
     fputs("\t- one to write output to.\n", stderr);
+    fputs("optionally followed by delta, to print only the entries changed by each command,\n", stderr);
+    fputs("and by an invalidation done after the commands:\n", stderr);
+    fputs("\tpage VPN | range FIRST_VPN NB_PAGES | asid ASID\n", stderr);
 }
 
+// ======================================================================
+// applies the invalidation given on the command line to the three TLBs
+#define invalidate_all(CALL)                                                     \
+    (CALL(l1_itlb, L1_ITLB) == ERR_NONE && CALL(l1_dtlb, L1_DTLB) == ERR_NONE && \
+     CALL(l2_tlb, L2_TLB) == ERR_NONE)
+
 // ======================================================================
 int main(int argc, char* argv[])
 {
@@ -55,6 +74,9 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    const int delta = argc > 4 && !strcmp(argv[4], "delta");
+    const int inval = 4 + delta; // index of the invalidation, if any
+
     program_t pgm;
     if (program_read(argv[1], &pgm) != ERR_NONE) {
         fprintf(stderr, "Cannot open \"%s\" for reading commands.\n", argv[1]);
@@ -92,14 +114,25 @@ int main(int argc, char* argv[])
     tlb_flush((void *)l1_dtlb, L1_DTLB);
     tlb_flush((void *)l2_tlb, L2_TLB);
 
+    // the TLBs as of the previous dump, for delta
+    l1_itlb_entry_t shown_l1_itlb[L1_ITLB_LINES];
+    l1_dtlb_entry_t shown_l1_dtlb[L1_DTLB_LINES];
+    l2_tlb_entry_t shown_l2_tlb[L2_TLB_LINES];
+
+    tlb_flush((void *)shown_l1_itlb, L1_ITLB);
+    tlb_flush((void *)shown_l1_dtlb, L1_DTLB);
+    tlb_flush((void *)shown_l2_tlb, L2_TLB);
+
     phy_addr_t paddr;
     zero_init_var(paddr);
+    page_walker_t walker;
+    (void)page_walker_init(&walker, mem_space, mem_size, 0);
 
     for (size_t prog_line_index = 0; prog_line_index < pgm.nb_lines; prog_line_index++) {
 
         int hit = 0;
         fprintf(f_out, "\n" SIZE_T_FMT ": DATA/INSTRUCTION = %d\n", prog_line_index, pgm.listing[prog_line_index].type == DATA ? DATA : INSTRUCTION);
-        tlb_search(mem_space, &(pgm.listing[prog_line_index].vaddr), &paddr, pgm.listing[prog_line_index].type == DATA ? DATA : INSTRUCTION, l1_itlb, l1_dtlb, l2_tlb, &hit);
+        tlb_search(&walker, &(pgm.listing[prog_line_index].vaddr), pgm.listing[prog_line_index].process, &paddr, pgm.listing[prog_line_index].type == DATA ? DATA : INSTRUCTION, l1_itlb, l1_dtlb, l2_tlb, &hit);
 
         fprintf(f_out, "-------------------------------------------------------------------\n");
         fprintf(f_out, "After program line " SIZE_T_FMT "...\n\n", prog_line_index);
@@ -113,17 +146,73 @@ int main(int argc, char* argv[])
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
-        fprintf(f_out, "\n\nL1_ITLB:");
-        print_all_tlb_entries(l1_itlb, l1_itlb_entry_t, L1_ITLB_LINES);
-        fprintf(f_out, "\n\nL1_DTLB:");
-        print_all_tlb_entries(l1_dtlb, l1_dtlb_entry_t, L1_DTLB_LINES);
-        fprintf(f_out, "\n\nL2_TLB:");
-        print_all_tlb_entries(l2_tlb, l2_tlb_entry_t, L2_TLB_LINES);
+        if (delta) {
+            fprintf(f_out, "\n\nL1_ITLB:");
+            print_changed_tlb_entries(l1_itlb, shown_l1_itlb, L1_ITLB);
+            fprintf(f_out, "\n\nL1_DTLB:");
+            print_changed_tlb_entries(l1_dtlb, shown_l1_dtlb, L1_DTLB);
+            fprintf(f_out, "\n\nL2_TLB:");
+            print_changed_tlb_entries(l2_tlb, shown_l2_tlb, L2_TLB);
+        } else {
+            fprintf(f_out, "\n\nL1_ITLB:");
+            print_all_tlb_entries(l1_itlb, l1_itlb_entry_t, L1_ITLB_LINES);
+            fprintf(f_out, "\n\nL1_DTLB:");
+            print_all_tlb_entries(l1_dtlb, l1_dtlb_entry_t, L1_DTLB_LINES);
+            fprintf(f_out, "\n\nL2_TLB:");
+            print_all_tlb_entries(l2_tlb, l2_tlb_entry_t, L2_TLB_LINES);
+        }
 #pragma GCC diagnostic pop
 
         fprintf(f_out, "-------------------------------------------------------------------\n");
     }
 
+    if (argc > inval) {
+        int ok = 0;
+        if (!strcmp(argv[inval], "page") && argc > inval + 1) {
+            const uint64_t vpn = strtoull(argv[inval + 1], NULL, 0);
+#define page(TLB, TYPE) tlb_invalidate_page(TLB, TYPE, vpn, 0)
+            ok = invalidate_all(page);
+#undef page
+        } else if (!strcmp(argv[inval], "range") && argc > inval + 2) {
+            const uint64_t first = strtoull(argv[inval + 1], NULL, 0);
+            const uint64_t nb = strtoull(argv[inval + 2], NULL, 0);
+#define range(TLB, TYPE) tlb_invalidate_range(TLB, TYPE, first, nb, 0)
+            ok = invalidate_all(range);
+#undef range
+        } else if (!strcmp(argv[inval], "asid") && argc > inval + 1) {
+            const asid_t asid = (asid_t) strtoul(argv[inval + 1], NULL, 0);
+#define space(TLB, TYPE) tlb_invalidate_asid(TLB, TYPE, asid)
+            ok = invalidate_all(space);
+#undef space
+        }
+        if (!ok) {
+            fprintf(stderr, "Cannot invalidate \"%s\".\n", argv[inval]);
+            fclose(f_out);
+            free(mem_space);
+            return 5;
+        }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+        fprintf(f_out, "\nAfter invalidation (%s)...\n", argv[inval]);
+        if (delta) {
+            fprintf(f_out, "\n\nL1_ITLB:");
+            print_changed_tlb_entries(l1_itlb, shown_l1_itlb, L1_ITLB);
+            fprintf(f_out, "\n\nL1_DTLB:");
+            print_changed_tlb_entries(l1_dtlb, shown_l1_dtlb, L1_DTLB);
+            fprintf(f_out, "\n\nL2_TLB:");
+            print_changed_tlb_entries(l2_tlb, shown_l2_tlb, L2_TLB);
+        } else {
+            fprintf(f_out, "\n\nL1_ITLB:");
+            print_all_tlb_entries(l1_itlb, l1_itlb_entry_t, L1_ITLB_LINES);
+            fprintf(f_out, "\n\nL1_DTLB:");
+            print_all_tlb_entries(l1_dtlb, l1_dtlb_entry_t, L1_DTLB_LINES);
+            fprintf(f_out, "\n\nL2_TLB:");
+            print_all_tlb_entries(l2_tlb, l2_tlb_entry_t, L2_TLB_LINES);
+        }
+#pragma GCC diagnostic pop
+    }
+
     /**
      * Garbage collecting
      */
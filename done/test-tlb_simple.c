@@ -19,8 +19,10 @@
 #include "list.h"
 #include "tlb.h"
 #include "tlb_mng.h"
+#include "tlb_policy.h"
 
 #include <inttypes.h> // for PRIx macros
+#include <string.h>   // for strcmp()
 
 int main(int argc, char* argv[])
 {
@@ -29,8 +31,17 @@ int main(int argc, char* argv[])
         fprintf(stderr, "\t- one (txt) to read commands from;\n");
         fprintf(stderr, "\t- one (bin) to memory content from;\n");
         fprintf(stderr, "\t- one to write output to.\n");
+        fprintf(stderr, "optionally followed by a replacement policy (list, lru, clock, random or fifo),\n");
+        fprintf(stderr, "the LRU list being used otherwise, and by \"checkpoint\" to save and\n");
+        fprintf(stderr, "restore the TLB and its policy after each line.\n");
         return 1;
     }
+    const tlb_policy_ops_t *ops = NULL; // the LRU list, through the original API
+    if (argc > 4 && (ops = tlb_policy_find(argv[4])) == NULL) {
+        fprintf(stderr, "Unknown replacement policy \"%s\".\n", argv[4]);
+        return 1;
+    }
+    const int checkpoint = argc > 5 && strcmp(argv[5], "checkpoint") == 0;
 
     program_t pgm;
     if (program_read(argv[1], &pgm) != ERR_NONE) {
@@ -65,7 +76,7 @@ int main(int argc, char* argv[])
     }
 
     /*
-    * Create the object replacement policy.
+    * Create the object replacement policy, the LRU list being ours.
     *
     */
     replacement_policy_t replacement_policy = {
@@ -73,14 +84,36 @@ int main(int argc, char* argv[])
         .move_back      = move_back,
         .push_back      = push_back
     };
+    if (ops != NULL && tlb_policy_init(&replacement_policy, ops) != ERR_NONE) {
+        fclose(f_out);
+        free(mem_space);
+        fprintf(stderr, "Cannot initialise the \"%s\" replacement policy.", ops->name);
+        return 5;
+    }
 
     phy_addr_t paddr;
     zero_init_var(paddr);
+    page_walker_t walker;
+    (void)page_walker_init(&walker, mem_space, mem_size, 0);
 
     for (size_t prog_line_index = 0; prog_line_index < pgm.nb_lines; prog_line_index++) {
 
         int hit = 0;
-        int err = tlb_search(mem_space, &(pgm.listing[prog_line_index].vaddr), &paddr, tlb, &replacement_policy, &hit);
+        int err = tlb_search(&walker, &(pgm.listing[prog_line_index].vaddr), pgm.listing[prog_line_index].process, &paddr, tlb, &replacement_policy, &hit);
+        if (err == ERR_NONE && checkpoint) {
+            // into a flushed TLB and a new policy: what follows must not change
+            FILE* saved = tmpfile();
+            err = saved == NULL ? ERR_IO : tlb_checkpoint_write(saved, tlb, &replacement_policy);
+            tlb_flush(tlb);
+            tlb_policy_free(&replacement_policy);
+            replacement_policy.ops = ops;
+            if (err == ERR_NONE && ops != NULL) err = tlb_policy_init(&replacement_policy, ops);
+            if (err == ERR_NONE) {
+                rewind(saved);
+                err = tlb_checkpoint_read(saved, tlb, &replacement_policy);
+            }
+            if (saved != NULL) fclose(saved);
+        }
         fprintf(f_out, "-------------------------------------------------------------------\n");
         fprintf(f_out, "After program line " SIZE_T_FMT "...\n\n", prog_line_index);
         fprintf(f_out, "VA = ");
@@ -99,7 +132,7 @@ int main(int argc, char* argv[])
                         tlb[tlb_line_index].phy_page_num
                        );
             }
-            print_list(f_out, &ll);
+            if (ops == NULL || ops == &TLB_POLICY_LIST) print_list(f_out, &ll); // the other policies keep their state private
         } else {
             fprintf(f_out, "error with tlb_search(): %s\n", ERR_MESSAGES[err - ERR_NONE]);
         }
@@ -110,6 +143,7 @@ int main(int argc, char* argv[])
      * Garbage collecting
      */
     fclose(f_out);
+    tlb_policy_free(&replacement_policy);
     clear_list(&ll);
     free(mem_space);
 
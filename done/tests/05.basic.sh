@@ -58,5 +58,14 @@ R I @0x000000000000001C
 R DW @0x0000000040000004 
 R I @0x0000000000000020"
 
+printf "Test %1d (test-command 3): " $((++test))
+check_output test-commands commands03.txt \
+"R DH @0x0000008000000002 
+R DD @0x0000008000000008 
+R DL @0x0000008000000000 
+W DH 0x1234 @0x000000800000000F 
+W DD 0x1122334455667788 @0x000000800000001C 
+W DL 0xA1A2A3A4A5A6A7A8 @0x0000008000000033"
+
 # ======================================================================
 echo "SUCCESS"
@@ -0,0 +1,53 @@
+#!/bin/bash
+
+## Basic tests for simulator checkpoint and restore
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+
+# ======================================================================
+# tool function
+check_output_with_file() {
+
+    checkX "Test Checkpoint" "$1"
+
+    ref='tests/files'
+    memfile="${ref}/$3"
+    [ -f "$memfile" ] || error "Expected mem file \"$memfile\" not found."
+
+    cmdfile="${ref}/$4"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    refoutput="${ref}/$5"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    mytmp="$(new_tmp_file)"
+    # gets stdout in case of success, stderr in case of error
+    ACTUAL_OUTPUT="$("$1" "$2" "$memfile" "$cmdfile" 2>"$mytmp" || cat "$mytmp")"
+
+    diff -w <(echo "$ACTUAL_OUTPUT") <(cat "$refoutput") \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (test-checkpoint 1): " $((++test))
+check_output_with_file test-checkpoint dump memory-dump-01.mem commands01.txt output/checkpoint-01-out.txt
+
+printf "Test %1d (test-checkpoint 2): " $((++test))
+check_output_with_file test-checkpoint desc memory-desc-02.txt commands03.txt output/checkpoint-02-out.txt
+
+# with micro-TLBs, whose entries are saved as they are in memory
+for utlb in 1 2; do
+    printf "Test %1d (test-checkpoint, %d micro-TLB entries): " $((++test)) $utlb
+    checkX "Test Checkpoint" test-checkpoint
+    ./test-checkpoint dump tests/files/memory-dump-01.mem tests/files/commands01.txt $utlb 2>/dev/null | grep -qx "same state" \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+done
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,46 @@
+#!/bin/bash
+
+## Basic tests for the sampling executor
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+
+# ======================================================================
+# tool function
+check_output_with_file() {
+
+    checkX "Test Sampling" "$1"
+
+    ref='tests/files'
+    memfile="${ref}/$3"
+    [ -f "$memfile" ] || error "Expected mem file \"$memfile\" not found."
+
+    cmdfile="${ref}/$4"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    refoutput="${ref}/$5"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    mytmp="$(new_tmp_file)"
+    # gets stdout in case of success, stderr in case of error
+    ACTUAL_OUTPUT="$("$1" "$2" "$memfile" "$cmdfile" $6 2>"$mytmp" || cat "$mytmp")"
+
+    diff -w <(echo "$ACTUAL_OUTPUT") <(cat "$refoutput") \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (test-sampling 1): " $((++test))
+check_output_with_file test-sampling desc memory-desc-02.txt commands03.txt output/sampling-01-out.txt "1 1 0"
+
+printf "Test %1d (test-sampling 2): " $((++test))
+check_output_with_file test-sampling desc memory-desc-02.txt commands03.txt output/sampling-02-out.txt "2 1 0"
+
+printf "Test %1d (test-sampling 3): " $((++test))
+check_output_with_file test-sampling desc memory-desc-02.txt commands03.txt output/sampling-03-out.txt "3 1 1 warm"
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,47 @@
+#!/bin/bash
+
+## Basic tests for the synthetic trace generator
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+
+# ======================================================================
+# tool function: generates a trace and its memory, runs it in detail
+# and compares the counters to a reference
+check_generated_trace() {
+
+    checkX "Trace generator" gen-trace
+    checkX "Test Sampling" test-sampling
+
+    refoutput="tests/files/$1"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+    shift
+
+    mydir="$(new_tmp_file)"
+    rm -f "$mydir"; mkdir "$mydir"
+    mytmp="$(new_tmp_file)"
+    # gets stdout in case of success, stderr in case of error
+    ACTUAL_OUTPUT="$(gen-trace "$1" "$2" "$mydir/gen" "${@:3}" >/dev/null 2>"$mytmp" \
+                     && test-sampling desc "$mydir/gen-desc.txt" "$mydir/gen-commands.txt" 1 1 0 2>"$mytmp" \
+                     || cat "$mytmp")"
+    rm -rf "$mydir"; touch "$mydir"
+
+    diff -w <(echo "$ACTUAL_OUTPUT") <(cat "$refoutput") \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (gen-trace chase): " $((++test))
+check_generated_trace output/gen-chase-out.txt chase 500 pages=8
+
+printf "Test %1d (gen-trace mix): " $((++test))
+check_generated_trace output/gen-mix-out.txt mix 500 pages=12 size=2 writes=30 instr=60
+
+printf "Test %1d (gen-trace stride): " $((++test))
+check_generated_trace output/gen-stride-out.txt stride 500 pages=600 base=0x7FFFFFE00000 size=16
+
+# ======================================================================
+echo "SUCCESS"
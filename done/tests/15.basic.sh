@@ -0,0 +1,54 @@
+#!/bin/bash
+
+## Basic tests for replaying traces parsed in parallel
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+
+# ======================================================================
+# tool function
+check_output_with_file() {
+
+    checkX "Replay" "$1"
+
+    ref='tests/files'
+    memfile="${ref}/$3"
+    [ -f "$memfile" ] || error "Expected mem file \"$memfile\" not found."
+
+    cmdfile="${ref}/$4"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    refoutput="${ref}/$5"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    mytmp="$(new_tmp_file)"
+    # gets stdout in case of success, stderr in case of error
+    ACTUAL_OUTPUT="$("$1" "$2" "$memfile" "$cmdfile" $6 2>"$mytmp" || cat "$mytmp")"
+
+    diff -w <(echo "$ACTUAL_OUTPUT") <(cat "$refoutput") \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (replay 1 thread): " $((++test))
+check_output_with_file replay dump memory-dump-01.mem commands01.txt output/replay-01-out.txt "--threads=1"
+
+# chunks of a few bytes: one chunk per line
+printf "Test %1d (replay 3 threads): " $((++test))
+check_output_with_file replay dump memory-dump-01.mem commands01.txt output/replay-01-out.txt "--threads=3 --chunk=8"
+
+printf "Test %1d (replay 4 threads): " $((++test))
+check_output_with_file replay desc memory-desc-02.txt commands03.txt output/replay-03-out.txt "--threads=4 --chunk=1"
+
+# micro-TLBs of 2 and 1 entries in front of the L1 TLBs
+printf "Test %1d (replay micro-TLB): " $((++test))
+check_output_with_file replay dump memory-dump-01.mem commands01.txt output/replay-01-utlb-out.txt "--threads=1 --utlb=2"
+
+printf "Test %1d (replay micro-TLB): " $((++test))
+check_output_with_file replay desc memory-desc-02.txt commands03.txt output/replay-03-utlb-out.txt "--threads=2 --utlb=1"
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,100 @@
+#!/bin/bash
+
+## Basic tests for the binary trace format
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+# ======================================================================
+# tool function: replays a text trace converted to the binary format
+check_binary_replay() {
+
+    checkX "Converter" convert-trace
+    checkX "Replay" replay
+
+    memfile="${ref}/$2"
+    [ -f "$memfile" ] || error "Expected mem file \"$memfile\" not found."
+
+    cmdfile="${ref}/$3"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    refoutput="${ref}/$4"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    bintrace="$(new_tmp_file)"
+    mytmp="$(new_tmp_file)"
+    ./convert-trace bin "$cmdfile" "$bintrace" 2>"$mytmp" || { cat "$mytmp"; echo "FAIL"; exit 1; }
+    # gets stdout in case of success, stderr in case of error
+    ACTUAL_OUTPUT="$(./replay "$1" "$memfile" "$bintrace" 2>"$mytmp" || cat "$mytmp")"
+
+    diff -w <(echo "$ACTUAL_OUTPUT") <(cat "$refoutput") \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+# tool function: text -> binary -> text gives the trace back
+check_round_trip() {
+
+    checkX "Converter" convert-trace
+
+    cmdfile="${ref}/$1"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    bintrace="$(new_tmp_file)"
+    text1="$(new_tmp_file)"
+    text2="$(new_tmp_file)"
+    ./convert-trace text "$cmdfile" "$text1" && ./convert-trace bin "$cmdfile" "$bintrace" \
+        && ./convert-trace text "$bintrace" "$text2" \
+        && diff "$text1" "$text2" \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (binary replay): " $((++test))
+check_binary_replay dump memory-dump-01.mem commands01.txt output/replay-01-out.txt
+
+printf "Test %1d (binary replay): " $((++test))
+check_binary_replay desc memory-desc-02.txt commands03.txt output/replay-03-out.txt
+
+printf "Test %1d (round trip): " $((++test))
+check_round_trip commands01.txt
+
+printf "Test %1d (round trip): " $((++test))
+check_round_trip commands03.txt
+
+# ======================================================================
+# tool function: a binary trace made of the given bytes is accepted (0) or rejected (1)
+check_bin_bytes() {
+
+    checkX "Converter" convert-trace
+
+    bintrace="$(new_tmp_file)"
+    printf "PPSTRACE$2" > "$bintrace"
+    ./convert-trace text "$bintrace" /dev/null 2>/dev/null && status=0 || status=1
+    [ $status -eq $1 ] \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (byte write, version 1): " $((++test))
+check_bin_bytes 0 '\x01\x03\x00\x7f'
+
+printf "Test %1d (process change in version 1): " $((++test))
+check_bin_bytes 1 '\x01\x2e\x00\x00'
+
+printf "Test %1d (varint over 64 bits): " $((++test))
+check_bin_bytes 1 '\x02\x0e\x80\x80\x80\x80\x80\x80\x80\x80\x80\x02'
+
+printf "Test %1d (write data wider than its size): " $((++test))
+check_bin_bytes 1 '\x02\x03\x00\x80\x02'
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+## Basic tests for the per-set and per-page heatmaps
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+
+# ======================================================================
+# tool function
+check_heatmap() {
+
+    checkX "Replay" replay
+
+    ref='tests/files'
+    memfile="${ref}/$2"
+    [ -f "$memfile" ] || error "Expected mem file \"$memfile\" not found."
+
+    cmdfile="${ref}/$3"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    refprefix="${ref}/$4"
+    [ -f "${refprefix}-sets.csv" ] || error "Expected output file \"${refprefix}-sets.csv\" not found."
+    [ -f "${refprefix}-pages.csv" ] || error "Expected output file \"${refprefix}-pages.csv\" not found."
+
+    prefix="$(new_tmp_file)"
+    # the CSV files are removed with the other temporary files
+    echo "${prefix}-sets.csv" >> "$TMP_FILES"
+    echo "${prefix}-pages.csv" >> "$TMP_FILES"
+    mytmp="$(new_tmp_file)"
+    ./replay "$1" "$memfile" "$cmdfile" --threads=1 --heatmap="$prefix" >/dev/null 2>"$mytmp" || { cat "$mytmp"; echo "FAIL"; exit 1; }
+
+    diff "${prefix}-sets.csv" "${refprefix}-sets.csv" \
+        && diff "${prefix}-pages.csv" "${refprefix}-pages.csv" \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (heatmap): " $((++test))
+check_heatmap dump memory-dump-01.mem commands01.txt output/heatmap-01
+
+printf "Test %1d (heatmap): " $((++test))
+check_heatmap desc memory-desc-02.txt commands03.txt output/heatmap-03
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,57 @@
+#!/bin/bash
+
+## Basic tests for the replacement policies of the fully-associative TLB
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+# ======================================================================
+# tool function: with no line to evict, every policy fills the TLB like
+# the LRU list; the reference output is compared without the list, but
+# for the list itself. Any fifth argument is passed on (e.g. checkpoint)
+check_policy() {
+
+    checkX "Test TLB full associative" test-tlb_simple
+
+    cmdfile="${ref}/$2"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    memfile="${ref}/$3"
+    [ -f "$memfile" ] || error "Expected mem dump file \"$memfile\" not found."
+
+    refoutput="${ref}/$4"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    mytmp1="$(new_tmp_file)"
+    mytmp2="$(new_tmp_file)"
+    ./test-tlb_simple "$cmdfile" "$memfile" "$mytmp1" "$1" ${5:-} 2>"$mytmp2"
+
+    filter='s/^([^)]*)//'
+    if [ "$1" = list ]; then filter=''; fi
+    diff -w "$mytmp1" <(sed "$filter" "$refoutput") \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+for policy in list lru clock random fifo; do
+    printf "Test %1d (policy %s): " $((++test)) $policy
+    check_policy $policy commands02.txt memory-dump-01.mem output/tlb-simple-01-out.txt
+done
+
+# saving and restoring the TLB and its policy after each line changes nothing
+for policy in list lru clock random fifo; do
+    printf "Test %1d (checkpoints, policy %s): " $((++test)) $policy
+    check_policy $policy commands02.txt memory-dump-01.mem output/tlb-simple-01-out.txt checkpoint
+done
+
+printf "Test %1d (unknown policy): " $((++test))
+./test-tlb_simple ${ref}/commands02.txt ${ref}/memory-dump-01.mem /dev/null none 2>/dev/null \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+
+# ======================================================================
+echo "SUCCESS"
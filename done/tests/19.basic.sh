@@ -0,0 +1,60 @@
+#!/bin/bash
+
+## Basic tests for the single-page, range and address-space invalidations of the TLB hierarchy
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+# ======================================================================
+# tool function: invalidates the TLBs filled by a trace
+check_invalidation() {
+
+    checkX "Test TLB hierarchy" test-tlb_hrchy
+
+    cmdfile="${ref}/$1"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    memfile="${ref}/$2"
+    [ -f "$memfile" ] || error "Expected mem dump file \"$memfile\" not found."
+
+    refoutput="${ref}/$3"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    shift 3
+    mytmp1="$(new_tmp_file)"
+    mytmp2="$(new_tmp_file)"
+    ./test-tlb_hrchy "$cmdfile" "$memfile" "$mytmp1" "$@" 2>"$mytmp2" || { cat "$mytmp2"; echo "FAIL"; exit 1; }
+
+    diff -w "$mytmp1" "$refoutput" \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (one page): " $((++test))
+check_invalidation commands04.txt memory-dump-01.mem output/tlb-hrchy-inval-page.txt page 0x202
+
+# fewer pages than lines: page by page
+printf "Test %1d (small range): " $((++test))
+check_invalidation commands04.txt memory-dump-01.mem output/tlb-hrchy-inval-range.txt range 0x200 3
+
+# more pages than lines: line by line
+printf "Test %1d (large range): " $((++test))
+check_invalidation commands04.txt memory-dump-01.mem output/tlb-hrchy-inval-range-big.txt range 0x40000 0x204
+
+printf "Test %1d (address space): " $((++test))
+check_invalidation commands04.txt memory-dump-01.mem output/tlb-hrchy-inval-asid.txt asid 0
+
+printf "Test %1d (other address space): " $((++test))
+check_invalidation commands04.txt memory-dump-01.mem output/tlb-hrchy-inval-other-asid.txt asid 1
+
+printf "Test %1d (range too large): " $((++test))
+./test-tlb_hrchy ${ref}/commands04.txt ${ref}/memory-dump-01.mem /dev/null range 0xFFFFFFFFF 2 2>/dev/null \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,76 @@
+#!/bin/bash
+
+## Basic tests for the replay of interleaved processes, each with its own page tables
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+# ======================================================================
+# tool function: replays a trace (text, then binary) with the given page-table roots
+check_processes() {
+
+    checkX "Converter" convert-trace
+    checkX "Replay" replay
+
+    memfile="${ref}/$1"
+    [ -f "$memfile" ] || error "Expected mem file \"$memfile\" not found."
+
+    cmdfile="${ref}/$2"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    refoutput="${ref}/$3"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    shift 3
+    bintrace="$(new_tmp_file)"
+    mytmp="$(new_tmp_file)"
+    ./convert-trace bin "$cmdfile" "$bintrace" 2>"$mytmp" || { cat "$mytmp"; echo "FAIL"; exit 1; }
+    # gets stdout in case of success, stderr in case of error
+    TEXT_OUTPUT="$(./replay dump "$memfile" "$cmdfile" --threads=1 "$@" 2>"$mytmp" || cat "$mytmp")"
+    BIN_OUTPUT="$(./replay dump "$memfile" "$bintrace" --threads=1 "$@" 2>"$mytmp" || cat "$mytmp")"
+
+    diff -w <(echo "$TEXT_OUTPUT") "$refoutput" \
+        && diff -w <(echo "$BIN_OUTPUT") "$refoutput" \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+# the two processes share the pages of addresses 0x2000 and 0x3000 only
+printf "Test %1d (own page tables): " $((++test))
+check_processes memory-dump-02.mem commands05.txt output/replay-05-out.txt --roots=0x0,0x4000
+
+# with the same page tables, the processes differ by their ASID only
+printf "Test %1d (shared page tables): " $((++test))
+check_processes memory-dump-02.mem commands05.txt output/replay-05-shared-out.txt
+
+printf "Test %1d (round trip): " $((++test))
+text1="$(new_tmp_file)"
+text2="$(new_tmp_file)"
+bintrace="$(new_tmp_file)"
+./convert-trace text ${ref}/commands05.txt "$text1" && ./convert-trace bin ${ref}/commands05.txt "$bintrace" \
+    && ./convert-trace text "$bintrace" "$text2" \
+    && diff "$text1" "$text2" \
+    && grep -q '^P1 W DB 0xAB @0x0000000000001004$' "$text2" \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+printf "Test %1d (unaligned root): " $((++test))
+./replay dump ${ref}/memory-dump-02.mem ${ref}/commands05.txt --threads=1 --roots=0x0,0x4001 >/dev/null 2>&1 \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+
+# unknown options and counts that are not numbers are refused, not ignored
+for option in --root=0x0 --threads=4x --pte-tracking=1 1; do
+    printf "Test %1d (bad option %s): " $((++test)) "$option"
+    ./replay dump ${ref}/memory-dump-02.mem ${ref}/commands05.txt "$option" >/dev/null 2>&1 \
+        && (echo "FAIL"; exit 1) \
+        || echo "PASS"
+done
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,82 @@
+#!/bin/bash
+
+## Basic tests for the packed memory images
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+# ======================================================================
+# tool function: replays a trace on the image packed from a description
+check_image_replay() {
+
+    checkX "Memory converter" convert-memory
+    checkX "Replay" replay
+
+    descfile="${ref}/$1"
+    [ -f "$descfile" ] || error "Expected mem file \"$descfile\" not found."
+
+    cmdfile="${ref}/$2"
+    [ -f "$cmdfile" ] || error "Expected command file \"$cmdfile\" not found."
+
+    refoutput="${ref}/$3"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    image="$(new_tmp_file)"
+    mytmp="$(new_tmp_file)"
+    ./convert-memory image "$descfile" "$image" 2>"$mytmp" || { cat "$mytmp"; echo "FAIL"; exit 1; }
+    # gets stdout in case of success, stderr in case of error
+    ACTUAL_OUTPUT="$(./replay desc "$image" "$cmdfile" 2>"$mytmp" || cat "$mytmp")"
+
+    diff -w <(echo "$ACTUAL_OUTPUT") <(cat "$refoutput") \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+# tool function: the memory loaded from an image prints as the one of its description
+check_image_memory() {
+
+    checkX "Memory converter" convert-memory
+    checkX "Test memory" test-memory
+
+    descfile="${ref}/$1"
+    [ -f "$descfile" ] || error "Expected mem file \"$descfile\" not found."
+
+    refoutput="${ref}/$2"
+    [ -f "$refoutput" ] || error "Expected output file \"$refoutput\" not found."
+
+    image="$(new_tmp_file)"
+    mytmp="$(new_tmp_file)"
+    ./convert-memory image "$descfile" "$image" 2>"$mytmp" || { cat "$mytmp"; echo "FAIL"; exit 1; }
+    # gets stdout in case of success, stderr in case of error
+    ACTUAL_OUTPUT="$(./test-memory desc "$image" o ' ' "$3" 2>"$mytmp" || cat "$mytmp")"
+
+    diff -w <(echo "$ACTUAL_OUTPUT") <(cat "$refoutput") \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (image replay): " $((++test))
+check_image_replay memory-desc-02.txt commands03.txt output/replay-03-out.txt
+
+printf "Test %1d (image memory): " $((++test))
+check_image_memory memory-desc-01.txt output/memory-01-out.txt 0x0
+
+printf "Test %1d (image memory): " $((++test))
+check_image_memory memory-desc-02.txt output/memory-02-B-out.txt 0x8000000000
+
+printf "Test %1d (truncated image): " $((++test))
+image="$(new_tmp_file)"
+truncated="$(new_tmp_file)"
+./convert-memory image ${ref}/memory-desc-02.txt "$image" && head -c 20000 "$image" > "$truncated"
+./replay desc "$truncated" ${ref}/commands03.txt >/dev/null 2>&1 \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+
+# ======================================================================
+echo "SUCCESS"
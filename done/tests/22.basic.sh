@@ -0,0 +1,56 @@
+#!/bin/bash
+
+## Basic tests for the concurrent loading of memory descriptions
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+# ======================================================================
+# tool function: the memory loaded with the given number of threads is the expected dump
+check_parallel_dump() {
+
+    checkX "Memory converter" convert-memory
+
+    descfile="$1"
+    [ -f "$descfile" ] || error "Expected mem file \"$descfile\" not found."
+
+    refdump="$2"
+    [ -f "$refdump" ] || error "Expected dump file \"$refdump\" not found."
+
+    mydump="$(new_tmp_file)"
+    mytmp="$(new_tmp_file)"
+    ./convert-memory dump "$descfile" "$mydump" "$3" 2>"$mytmp" || { cat "$mytmp"; echo "FAIL"; exit 1; }
+
+    cmp -s "$mydump" "$refdump" \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+for threads in 1 8; do
+    printf "Test %1d (%d threads): " $((++test)) $threads
+    check_parallel_dump ${ref}/memory-desc-01.txt ${ref}/memory-dump-01.mem $threads
+done
+
+# a generated description of many pages, loaded by one thread, then by several
+mydir="$(new_tmp_file)"
+rm -f "$mydir"; mkdir "$mydir"
+checkX "Trace generator" gen-trace
+./gen-trace mix 10 "$mydir/gen" pages=300 >/dev/null \
+    && ./convert-memory dump "$mydir/gen-desc.txt" "$mydir/gen-1.mem" 1 \
+    || error "Cannot generate the description"
+printf "Test %1d (many pages): " $((++test))
+check_parallel_dump "$mydir/gen-desc.txt" "$mydir/gen-1.mem" 8
+
+printf "Test %1d (missing page file): " $((++test))
+sed 's|raw_page_content_1_02.bin|no_such_page.bin|' ${ref}/memory-desc-02.txt > "$mydir/bad-desc.txt"
+./convert-memory dump "$mydir/bad-desc.txt" "$mydir/bad.mem" 8 >/dev/null 2>&1 \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+rm -rf "$mydir"; touch "$mydir"
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,77 @@
+#!/bin/bash
+
+## Basic tests for the delta dumps of the caches and TLBs
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+# ======================================================================
+# tool functions: rebuild the full dumps from the delta ones, starting
+# from all-invalid caches (resp. TLBs)
+rebuild_cache_dumps() {
+    awk '/^(L1_ICACHE|L1_DCACHE|L2_CACHE): *$/ {
+             sec = $1; ways = (sec == "L2_CACHE:") ? 8 : 4; lines = (sec == "L2_CACHE:") ? 512 : 64
+         }
+         /^WAY\/LINE/ { print; inblock = 1; next }
+         /^[0-9a-f]+\/[0-9a-f]+: / { state[sec, substr($0, 1, 7)] = $0; next }
+         /^$/ && inblock {
+             for (l = 0; l < lines; ++l)
+                 for (w = 0; w < ways; ++w) {
+                     key = sprintf("%02x/%04x", w, l)
+                     if ((sec, key) in state) print state[sec, key]
+                     else print key ": V: 0, AGE: -, TAG: -----, values: ( ---------- ---------- ---------- ---------- )"
+                 }
+             inblock = 0
+         }
+         { print }' "$1"
+}
+
+rebuild_tlb_dumps() {
+    awk 'function print_tlb() {
+             for (l = 0; l < lines; ++l) {
+                 key = sprintf("%02x", l)
+                 print ((sec, key) in state) ? state[sec, key] : "0; --------; -----;"
+             }
+             want = 0
+         }
+         /^[0-9a-f]+: [01]; / { state[sec, substr($0, 1, 2)] = substr($0, 5); next }
+         want && started { print_tlb() }
+         want && /^$/ { started = 1 }
+         /^(L1_ITLB|L1_DTLB|L2_TLB):$/ { sec = $1; lines = (sec == "L2_TLB:") ? 64 : 16; want = 1; started = 0 }
+         { print }
+         END { if (want) print_tlb() }' "$1"
+}
+
+# ======================================================================
+printf "Test %1d (test-cache delta): " $((++test))
+checkX "Test Cache hierarchy" test-cache
+mytmp="$(new_tmp_file)"
+test-cache dump ${ref}/memory-dump-01.mem ${ref}/commands01.txt delta > "$mytmp" \
+    || error "test-cache failed"
+[ $(wc -l < "$mytmp") -lt $(wc -l < ${ref}/output/cache-01-out.txt) ] || error "the delta dump is not smaller"
+diff -w <(echo "$(rebuild_cache_dumps "$mytmp")") ${ref}/output/cache-01-out.txt \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+printf "Test %1d (test-tlb_hrchy delta): " $((++test))
+checkX "Test TLB hierarchy" test-tlb_hrchy
+test-tlb_hrchy ${ref}/commands02.txt ${ref}/memory-dump-01.mem "$mytmp" delta \
+    || error "test-tlb_hrchy failed"
+diff -w <(rebuild_tlb_dumps "$mytmp") ${ref}/output/tlb-hrchy-01-out.txt \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+printf "Test %1d (test-tlb_hrchy delta, then invalidation): " $((++test))
+test-tlb_hrchy ${ref}/commands04.txt ${ref}/memory-dump-01.mem "$mytmp" delta asid 0 \
+    || error "test-tlb_hrchy failed"
+diff -w <(rebuild_tlb_dumps "$mytmp") ${ref}/output/tlb-hrchy-inval-asid.txt \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+# ======================================================================
+echo "SUCCESS"
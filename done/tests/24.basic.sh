@@ -0,0 +1,51 @@
+#!/bin/bash
+
+## Basic tests for the binary state dumps and their decoder
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+checkX "Test Cache hierarchy" test-cache
+checkX "State decoder" decode-state
+
+# ======================================================================
+# the states after each command of commands01.txt, then after the same
+# commands, the last one writing another value
+states="$(new_tmp_file)"
+test-cache dump ${ref}/memory-dump-01.mem ${ref}/commands01.txt state "$states" \
+    || error "test-cache failed"
+others="$(new_tmp_file)"
+test-cache dump ${ref}/memory-dump-01.mem <(sed '$s/0xBEEF/0xCAFE/' ${ref}/commands01.txt) state "$others" \
+    || error "test-cache failed"
+
+printf "Test %1d (decode the caches): " $((++test))
+[ $(wc -c < "$states") -lt $(wc -c < ${ref}/output/cache-01-out.txt) ] || error "the binary dumps are not smaller"
+cmp -s <(decode-state print "$states" L1_ICACHE L1_DCACHE L2_CACHE) \
+       <(test-cache dump ${ref}/memory-dump-01.mem ${ref}/commands01.txt) \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+printf "Test %1d (same dumps): " $((++test))
+[ -z "$(decode-state diff "$states" "$states")" ] \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+printf "Test %1d (different dumps): " $((++test))
+mytmp="$(new_tmp_file)"
+decode-state diff "$states" "$others" > "$mytmp" && error "the dumps should differ"
+diff -w "$mytmp" ${ref}/output/state-01-diff.txt \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+printf "Test %1d (not a state dump): " $((++test))
+decode-state print ${ref}/memory-dump-01.mem >/dev/null 2>&1 \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,73 @@
+#!/bin/bash
+
+## Basic tests for demand paging: page tables and pages built on first touch
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+ref='tests/files'
+
+checkX "Replay" replay
+checkX "Trace generator" gen-trace
+
+mydir="$(new_tmp_file)"
+rm -f "$mydir"; mkdir "$mydir"
+./gen-trace mix 5000 "$mydir/gen" pages=64 >/dev/null || error "Cannot generate the trace"
+
+# ======================================================================
+# the translations do not depend on where the pages are: the TLBs behave as
+# with the generated description
+printf "Test %1d (same TLB hits as described): " $((++test))
+./replay desc "$mydir/gen-desc.txt" "$mydir/gen-commands.txt" > "$mydir/desc.txt" 2>/dev/null \
+    || { echo "FAIL"; exit 1; }
+./replay demand 0x400000 "$mydir/gen-commands.txt" > "$mydir/demand.txt" 2>/dev/null \
+    || { echo "FAIL"; exit 1; }
+diff <(grep -E 'accesses|TLB:' "$mydir/desc.txt") <(grep -E 'accesses|TLB:' "$mydir/demand.txt") \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+# one fault per page, plus one per PUD, PMD and PTE page of the single PGD entry used
+printf "Test %1d (page faults): " $((++test))
+grep -q '^page faults: 67, frames left: 956$' "$mydir/demand.txt" \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+printf "Test %1d (memory full): " $((++test))
+./replay demand 0x8000 "$mydir/gen-commands.txt" >/dev/null 2>&1 \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+
+printf "Test %1d (bad memory size): " $((++test))
+./replay demand 1000 "$mydir/gen-commands.txt" >/dev/null 2>&1 \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+
+# without demand paging, an entry which is not present is a page fault
+printf "Test %1d (unmapped address): " $((++test))
+echo "R DW @0x0000ff0000000000" > "$mydir/unmapped.txt"
+./replay dump ${ref}/memory-dump-01.mem "$mydir/unmapped.txt" >/dev/null 2>&1 \
+    && (echo "FAIL"; exit 1) \
+    || echo "PASS"
+
+printf "Test %1d (unmapped address, on demand): " $((++test))
+./replay demand 0x10000 "$mydir/unmapped.txt" 2>/dev/null | grep -q '^page faults: 4,' \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+# a garbage PGD entry pointing past the end of memory is an error, not a wild read
+printf "Test %1d (entry outside of memory): " $((++test))
+{ printf '\x00\xf0\xff\xff'; head -c 8188 /dev/zero; } > "$mydir/garbage.mem"
+echo "R DW @0x0000000000000000" > "$mydir/zero.txt"
+status=0
+./replay dump "$mydir/garbage.mem" "$mydir/zero.txt" >/dev/null 2>&1 || status=$?
+[ $status -ne 0 ] && [ $status -lt 128 ] \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+rm -rf "$mydir"; touch "$mydir"
+
+# ======================================================================
+echo "SUCCESS"
@@ -0,0 +1,64 @@
+#!/bin/bash
+
+## Basic tests for the accessed and dirty bits of the page tables
+
+source $(dirname ${BASH_SOURCE[0]})/test_env.sh
+
+test=0
+
+checkX "Replay" replay
+checkX "Trace generator" gen-trace
+
+mydir="$(new_tmp_file)"
+rm -f "$mydir"; mkdir "$mydir"
+./gen-trace mix 5000 "$mydir/gen" pages=64 >/dev/null || error "Cannot generate the trace"
+
+# ======================================================================
+# tool function: replays a trace with the given replay options, then checks a line of the output
+check_tracking() {
+    trace="$1"
+    expected="$2"
+    shift 2
+    ./replay "$@" "$trace" --threads=1 --utlb="$utlb" --pte-tracking > "$mydir/out.txt" 2>/dev/null || { echo "FAIL"; exit 1; }
+    grep -qx "$expected" "$mydir/out.txt" \
+        && echo "PASS" \
+        || (echo "FAIL"; \
+            exit 1)
+}
+
+# ======================================================================
+printf "Test %1d (same hits as without tracking): " $((++test))
+./replay desc "$mydir/gen-desc.txt" "$mydir/gen-commands.txt" --threads=1 > "$mydir/off.txt" 2>/dev/null \
+    || { echo "FAIL"; exit 1; }
+./replay desc "$mydir/gen-desc.txt" "$mydir/gen-commands.txt" --threads=1 --pte-tracking > "$mydir/on.txt" 2>/dev/null \
+    || { echo "FAIL"; exit 1; }
+diff "$mydir/off.txt" <(grep -v -e '^PTE updates' -e '^ASID' "$mydir/on.txt") \
+    && echo "PASS" \
+    || (echo "FAIL"; \
+        exit 1)
+
+# the pages of the trace: every page read or written is accessed, every page written is dirty
+nb_pages=$(awk '{ print substr($NF, 1, length($NF) - 3) }' "$mydir/gen-commands.txt" | sort -u | wc -l)
+nb_written=$(awk '$1 == "W" { print substr($NF, 1, length($NF) - 3) }' "$mydir/gen-commands.txt" | sort -u | wc -l)
+for utlb in 0 2; do
+    printf "Test %1d (working set, %d micro-TLB entries): " $((++test)) $utlb
+    check_tracking "$mydir/gen-commands.txt" "ASID 0: accessed pages: $nb_pages, dirty pages: $nb_written" demand 0x400000
+done
+
+# a walk for a write sets the dirty bit at once: the PTE is not walked again
+utlb=0
+printf "W DW 0x1 @0x0000000000001000\nW DW 0x2 @0x0000000000001008\nW DW 0x3 @0x0000000000001010\n" > "$mydir/writes.txt"
+printf "Test %1d (writes): " $((++test))
+check_tracking "$mydir/writes.txt" "PTE updates: 4, dirty-bit walks: 0" demand 0x10000
+
+# the first write after a read walks again, the next one finds the entry dirty;
+# a fetch from the next page only sets the accessed bit of its PTE
+printf "R DW @0x0000000000001000\nW DW 0x2 @0x0000000000001008\nW DW 0x3 @0x0000000000001010\nR I @0x0000000000002000\n" > "$mydir/read-writes.txt"
+for utlb in 0 2; do
+    printf "Test %1d (read, then writes, %d micro-TLB entries): " $((++test)) $utlb
+    check_tracking "$mydir/read-writes.txt" "PTE updates: 6, dirty-bit walks: 1" demand 0x10000
+done
+rm -rf "$mydir"; touch "$mydir"
+
+# ======================================================================
+echo "SUCCESS"
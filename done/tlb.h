@@ -14,9 +14,39 @@
 
 #define TLB_LINES 128 // the number of entries
 
-typedef struct
+/*
+ * An entry is a single 64-bit word: the bitfields give access to its fields,
+ * while a hit check compares the whole word, masked to the valid bit and the
+ * tag, to the word of a valid entry of the looked-up tag (one load, one compare).
+ */
+typedef union
 {
-	uint64_t tag : VIRT_PAGE_NUM;
-	uint32_t phy_page_num : PHY_PAGE_NUM;
-	uint8_t v : 1;
+	struct
+	{
+		uint64_t tag : VIRT_PAGE_NUM;
+		uint32_t phy_page_num : PHY_PAGE_NUM;
+		uint8_t v : 1;
+		uint8_t asid : ASID_BITS; // address space of the translation
+	};
+	uint64_t word;
 } tlb_entry_t;
+
+_Static_assert(sizeof(tlb_entry_t) == sizeof(uint64_t), "a TLB entry must fit in one word");
+
+// the word of a valid entry of the given tag and address space, all other bits at 0
+static inline uint64_t tlb_key(uint64_t tag, asid_t asid)
+{
+	tlb_entry_t entry;
+	entry.word = 0;
+	entry.tag = tag;
+	entry.v = 1;
+	entry.asid = asid;
+	return entry.word;
+}
+
+#ifndef BITFIELD_ENTRIES
+#define tlb_entry_hit(ENTRY, TAG, ASID) \
+	(((ENTRY).word & tlb_key((UINT64_C(1) << VIRT_PAGE_NUM) - 1, NB_ASIDS - 1)) == tlb_key(TAG, ASID))
+#else // field by field, as before the entries were packed (make BITFIELD_ENTRIES=1 to benchmark it)
+#define tlb_entry_hit(ENTRY, TAG, ASID) ((ENTRY).v == 1 && (ENTRY).tag == (TAG) && (ENTRY).asid == (ASID))
+#endif
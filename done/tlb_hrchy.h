@@ -28,21 +28,67 @@
 #define L2_TLB_LINES 64     // 64, Do not modify this!
 #define L2_TLB_LINES_BITS 6 // log_2(L2_TLB_LINES)
 
-typedef struct
+/*
+ * As in tlb.h, an entry is a single 64-bit word, so that a hit check is one
+ * masked compare of the word (see tlb_hrchy_entry_hit()).
+ */
+typedef union
 {
-    uint32_t tag : VIRT_PAGE_NUM - L1_ITLB_LINES_BITS;
-    uint32_t phy_page_num : PHY_PAGE_NUM;
-    uint8_t v : 1;
+    struct
+    {
+        uint32_t tag : VIRT_PAGE_NUM - L1_ITLB_LINES_BITS;
+        uint32_t phy_page_num : PHY_PAGE_NUM;
+        uint8_t v : 1;
+        uint8_t asid : ASID_BITS; // address space of the translation
+        uint8_t dirty : 1;        // the PTE is known to be dirty (see PTE_DIRTY)
+    };
+    uint64_t word;
 } l1_itlb_entry_t;
 
 typedef l1_itlb_entry_t l1_dtlb_entry_t;
-typedef struct
+typedef union
 {
-    uint32_t tag : VIRT_PAGE_NUM - L2_TLB_LINES_BITS;
-    uint32_t phy_page_num : PHY_PAGE_NUM;
-    uint8_t v : 1;
+    struct
+    {
+        uint32_t tag : VIRT_PAGE_NUM - L2_TLB_LINES_BITS;
+        uint32_t phy_page_num : PHY_PAGE_NUM;
+        uint8_t v : 1;
+        uint8_t asid : ASID_BITS;
+        uint8_t dirty : 1;
+    };
+    uint64_t word;
 } l2_tlb_entry_t;
 
+_Static_assert(sizeof(l1_itlb_entry_t) == sizeof(uint64_t), "an L1 TLB entry must fit in one word");
+_Static_assert(sizeof(l2_tlb_entry_t) == sizeof(uint64_t), "an L2 TLB entry must fit in one word");
+
+// the word of a valid entry of the given tag and address space, all other bits at 0
+#define define_tlb_key(NAME, TYPE)                            \
+    static inline uint64_t NAME(uint32_t tag, asid_t asid)    \
+    {                                                         \
+        TYPE entry;                                           \
+        entry.word = 0;                                       \
+        entry.tag = tag;                                      \
+        entry.v = 1;                                          \
+        entry.asid = asid;                                    \
+        return entry.word;                                    \
+    }
+define_tlb_key(l1_tlb_key, l1_itlb_entry_t)
+define_tlb_key(l2_tlb_key, l2_tlb_entry_t)
+#undef define_tlb_key
+
+/**
+ * @brief hit check of an entry of the given tag and address space; KEY is
+ * l1_tlb_key or l2_tlb_key and TAG_BITS the number of bits of the tag
+ */
+#ifndef BITFIELD_ENTRIES
+#define tlb_hrchy_entry_hit(ENTRY, TAG, ASID, KEY, TAG_BITS) \
+    (((ENTRY).word & KEY((uint32_t)((UINT64_C(1) << (TAG_BITS)) - 1), NB_ASIDS - 1)) == KEY(TAG, ASID))
+#else // field by field, as before the entries were packed (make BITFIELD_ENTRIES=1 to benchmark it)
+#define tlb_hrchy_entry_hit(ENTRY, TAG, ASID, KEY, TAG_BITS) \
+    ((ENTRY).v == 1 && (ENTRY).tag == (TAG) && (ENTRY).asid == (ASID))
+#endif
+
 typedef enum
 {
     L1_ITLB,
@@ -11,8 +11,13 @@
 #include "util.h"
 #include "page_walk.h"
 #include "list.h"
+#include "dump_buf.h"
+
+#include <string.h> // for memset()
+#include <inttypes.h> // for PRIx64
 #define OFF 2
 #define LINE_OFF 4
+
 int tlb_flush(void *tlb, tlb_t tlb_type)
 {
     M_REQUIRE_NON_NULL(tlb);
@@ -54,18 +59,164 @@ int tlb_flush(void *tlb, tlb_t tlb_type)
     return ERR_NONE;
 }
 
-int tlb_entry_init(const virt_addr_t *vaddr,
-                   const phy_addr_t *paddr,
-                   void *tlb_entry,
-                   tlb_t tlb_type)
+// calls BODY with the entry type, number of lines, its log2 and the key function of a TLB type;
+// an unknown type is an error
+#define switch_tlb_type(TLB_TYPE, BODY)                                       \
+    switch (TLB_TYPE)                                                         \
+    {                                                                         \
+    case L1_ITLB:                                                             \
+    {                                                                         \
+        BODY(l1_itlb_entry_t, L1_ITLB_LINES, L1_ITLB_LINES_BITS, l1_tlb_key); \
+    }                                                                         \
+    break;                                                                    \
+    case L1_DTLB:                                                             \
+    {                                                                         \
+        BODY(l1_dtlb_entry_t, L1_DTLB_LINES, L1_DTLB_LINES_BITS, l1_tlb_key); \
+    }                                                                         \
+    break;                                                                    \
+    case L2_TLB:                                                              \
+    {                                                                         \
+        BODY(l2_tlb_entry_t, L2_TLB_LINES, L2_TLB_LINES_BITS, l2_tlb_key);    \
+    }                                                                         \
+    break;                                                                    \
+    default:                                                                  \
+        return ERR_BAD_PARAMETER;                                             \
+    }
+
+// invalidates the entry of (VPN, ASID), direct mapping: only its line may hold it
+#define invalidate_vpn(type, LINES, LINES_BITS, KEY, VPN, ASID)                                                   \
+    do                                                                                                            \
+    {                                                                                                             \
+        type *entry_ = (type *)tlb + (VPN) % LINES;                                                               \
+        if (tlb_hrchy_entry_hit(*entry_, (uint32_t)((VPN) >> LINES_BITS), ASID, KEY, VIRT_PAGE_NUM - LINES_BITS)) \
+            entry_->v = 0;                                                                                        \
+    } while (0)
+
+int tlb_invalidate_page(void *tlb, tlb_t tlb_type, uint64_t vpn, asid_t asid)
+{
+    M_REQUIRE_NON_NULL(tlb);
+    M_REQUIRE(vpn < (UINT64_C(1) << VIRT_PAGE_NUM), ERR_ADDR, "virtual page number 0x%" PRIx64 " is too large", vpn);
+#define page(type, LINES, LINES_BITS, KEY) invalidate_vpn(type, LINES, LINES_BITS, KEY, vpn, asid)
+    switch_tlb_type(tlb_type, page);
+#undef page
+    return ERR_NONE;
+}
+
+int tlb_invalidate_range(void *tlb, tlb_t tlb_type, uint64_t first_vpn, uint64_t nb_pages, asid_t asid)
+{
+    M_REQUIRE_NON_NULL(tlb);
+    M_REQUIRE(first_vpn <= (UINT64_C(1) << VIRT_PAGE_NUM) && nb_pages <= (UINT64_C(1) << VIRT_PAGE_NUM) - first_vpn,
+              ERR_ADDR, "range of %" PRIu64 " pages from 0x%" PRIx64 " is too large", nb_pages, first_vpn);
+    // a range smaller than the TLB is invalidated page by page, a larger one line by line
+#define range(type, LINES, LINES_BITS, KEY)                                                          \
+    if (nb_pages < LINES)                                                                            \
+    {                                                                                                \
+        for (uint64_t vpn = first_vpn; vpn < first_vpn + nb_pages; ++vpn)                            \
+            invalidate_vpn(type, LINES, LINES_BITS, KEY, vpn, asid);                                 \
+    }                                                                                                \
+    else                                                                                             \
+    {                                                                                                \
+        type *t = tlb;                                                                               \
+        for (uint64_t line = 0; line < LINES; ++line)                                                \
+        {                                                                                            \
+            const uint64_t vpn = ((uint64_t)t[line].tag << LINES_BITS) | line;                       \
+            if (t[line].v && t[line].asid == asid && vpn >= first_vpn && vpn - first_vpn < nb_pages) \
+                t[line].v = 0;                                                                       \
+        }                                                                                            \
+    }
+    switch_tlb_type(tlb_type, range);
+#undef range
+    return ERR_NONE;
+}
+
+int tlb_invalidate_asid(void *tlb, tlb_t tlb_type, asid_t asid)
+{
+    M_REQUIRE_NON_NULL(tlb);
+#define space(type, LINES, LINES_BITS, KEY)     \
+    type *t = tlb;                              \
+    for (size_t line = 0; line < LINES; ++line) \
+    {                                           \
+        if (t[line].v && t[line].asid == asid)  \
+            t[line].v = 0;                      \
+    }
+    switch_tlb_type(tlb_type, space);
+#undef space
+    return ERR_NONE;
+}
+
+// see tlb_hrchy_mng.h
+int tlb_dump(FILE *output, const void *tlb, tlb_t tlb_type)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(tlb);
+    dump_buf_t buf;
+    dump_buf_init(&buf, output);
+#define dump(type, LINES, LINES_BITS, KEY)                               \
+    const type *t = tlb;                                                 \
+    for (size_t line = 0; line < LINES; ++line)                          \
+    {                                                                    \
+        if (t[line].v)                                                   \
+        {                                                                \
+            dump_buf_puts(&buf, "1; ");                                  \
+            dump_buf_hex(&buf, t[line].tag, 8, dump_hex_upper);          \
+            dump_buf_puts(&buf, "; ");                                   \
+            dump_buf_hex(&buf, t[line].phy_page_num, 5, dump_hex_upper); \
+            dump_buf_puts(&buf, ";\n");                                  \
+        }                                                                \
+        else                                                             \
+            dump_buf_puts(&buf, "0; --------; -----;\n");                \
+    }
+    switch_tlb_type(tlb_type, dump);
+#undef dump
+    dump_buf_flush(&buf);
+    return ERR_NONE;
+}
+
+// an entry is printed again only if it differs from its copy at the previous dump,
+// all invalid entries being the same as they are printed the same way
+int tlb_dump_delta(FILE *output, const void *tlb, void *previous, tlb_t tlb_type)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(tlb);
+    M_REQUIRE_NON_NULL(previous);
+    dump_buf_t buf;
+    dump_buf_init(&buf, output);
+#define dump(type, LINES, LINES_BITS, KEY)                                   \
+    const type *t = tlb;                                                     \
+    type *old = previous;                                                    \
+    for (size_t line = 0; line < LINES; ++line)                              \
+    {                                                                        \
+        if ((t[line].v || old[line].v) && t[line].word != old[line].word)    \
+        {                                                                    \
+            dump_buf_hex(&buf, line, 2, dump_hex_lower);                     \
+            if (t[line].v)                                                   \
+            {                                                                \
+                dump_buf_puts(&buf, ": 1; ");                                \
+                dump_buf_hex(&buf, t[line].tag, 8, dump_hex_upper);          \
+                dump_buf_puts(&buf, "; ");                                   \
+                dump_buf_hex(&buf, t[line].phy_page_num, 5, dump_hex_upper); \
+                dump_buf_puts(&buf, ";\n");                                  \
+            }                                                                \
+            else                                                             \
+                dump_buf_puts(&buf, ": 0; --------; -----;\n");              \
+            old[line] = t[line];                                             \
+        }                                                                    \
+    }
+    switch_tlb_type(tlb_type, dump);
+#undef dump
+    dump_buf_flush(&buf);
+    return ERR_NONE;
+}
+
+// tlb_entry_init() from a virtual page number
+static int entry_init_vpn(uint64_t vpg_num, asid_t asid, const phy_addr_t *paddr, void *tlb_entry, tlb_t tlb_type)
 {
-    M_REQUIRE_NON_NULL(tlb_entry);
-    M_REQUIRE_NON_NULL(vaddr);
-    M_REQUIRE_NON_NULL(paddr);
 #define init(type, LINES_BITS)                                                          \
-    ((type *)tlb_entry)->tag = virt_addr_t_to_virtual_page_number(vaddr) >> LINES_BITS; \
+    memset(tlb_entry, 0, sizeof(type)); /* padding bits included, for byte-wise comparisons */ \
+    ((type *)tlb_entry)->tag = vpg_num >> LINES_BITS;                                   \
     ((type *)tlb_entry)->phy_page_num = paddr->phy_page_num;                            \
-    ((type *)tlb_entry)->v = 1;
+    ((type *)tlb_entry)->v = 1;                                                         \
+    ((type *)tlb_entry)->asid = asid;
     switch (tlb_type)
     {
     case L1_ITLB:
@@ -89,6 +240,19 @@ int tlb_entry_init(const virt_addr_t *vaddr,
     return ERR_NONE;
 }
 
+int tlb_entry_init(const virt_addr_t *vaddr,
+                   asid_t asid,
+                   const phy_addr_t *paddr,
+                   void *tlb_entry,
+                   tlb_t tlb_type)
+{
+    M_REQUIRE_NON_NULL(tlb_entry);
+    M_REQUIRE_NON_NULL(vaddr);
+    M_REQUIRE_NON_NULL(paddr);
+    M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
+    return entry_init_vpn(virt_addr_t_to_virtual_page_number(vaddr), asid, paddr, tlb_entry, tlb_type);
+}
+
 int tlb_insert(uint32_t line_index,
                const void *tlb_entry,
                void *tlb,
@@ -123,40 +287,37 @@ int tlb_insert(uint32_t line_index,
     return ERR_NONE;
 }
 
-int tlb_hit(const virt_addr_t *vaddr,
-            phy_addr_t *paddr,
-            const void *tlb,
-            tlb_t tlb_type)
+// tlb_hit() on a virtual page number and page offset
+static int hit_vpn(uint64_t vpg_num, asid_t asid, uint16_t page_offset, phy_addr_t *paddr, const void *tlb, tlb_t tlb_type)
 {
-#define hit(type, LINES, LINES_BITS)                                                           \
+#define hit(type, LINES, LINES_BITS, KEY)                                                      \
     line_index = vpg_num % LINES;                                                              \
     type *tmp = tlb;                                                                           \
-    if (tmp[line_index].tag == (vpg_num >> LINES_BITS) && tmp[line_index].v == 1)              \
+    if (tlb_hrchy_entry_hit(tmp[line_index], (uint32_t)(vpg_num >> LINES_BITS), asid,          \
+                            KEY, VIRT_PAGE_NUM - LINES_BITS))                                  \
     {                                                                                          \
-        init_phy_addr(paddr, tmp[line_index].phy_page_num << PAGE_OFFSET, vaddr->page_offset); \
+        paddr->phy_page_num = tmp[line_index].phy_page_num;                                   \
+        paddr->page_offset = page_offset;                                                      \
         return 1;                                                                              \
     }
 
-    if (tlb == NULL || paddr == NULL || vaddr == NULL)
-        return 0; // if arguments are not valid it's a miss
-    uint64_t vpg_num = virt_addr_t_to_virtual_page_number(vaddr);
     list_content_t line_index = 0;
     // getting the line index from the virtual pg num and checking if it's a hit
     switch (tlb_type)
     {
     case L1_ITLB:
     {
-        hit(l1_itlb_entry_t, L1_ITLB_LINES, L1_ITLB_LINES_BITS);
+        hit(l1_itlb_entry_t, L1_ITLB_LINES, L1_ITLB_LINES_BITS, l1_tlb_key);
     }
     break;
     case L1_DTLB:
     {
-        hit(l1_dtlb_entry_t, L1_DTLB_LINES, L1_DTLB_LINES_BITS);
+        hit(l1_dtlb_entry_t, L1_DTLB_LINES, L1_DTLB_LINES_BITS, l1_tlb_key);
     }
     break;
     case L2_TLB:
     {
-        hit(l2_tlb_entry_t, L2_TLB_LINES, L2_TLB_LINES_BITS);
+        hit(l2_tlb_entry_t, L2_TLB_LINES, L2_TLB_LINES_BITS, l2_tlb_key);
     }
     break;
     default:
@@ -164,8 +325,20 @@ int tlb_hit(const virt_addr_t *vaddr,
     }
     return 0; // if it was not found in the specific tlb it's a miss
 }
-int tlb_search(const void *mem_space,
+
+int tlb_hit(const virt_addr_t *vaddr,
+            asid_t asid,
+            phy_addr_t *paddr,
+            const void *tlb,
+            tlb_t tlb_type)
+{
+    if (tlb == NULL || paddr == NULL || vaddr == NULL)
+        return 0; // if arguments are not valid it's a miss
+    return hit_vpn(virt_addr_t_to_virtual_page_number(vaddr), asid, vaddr->page_offset, paddr, tlb, tlb_type);
+}
+int tlb_search(const page_walker_t *walker,
                const virt_addr_t *vaddr,
+               asid_t asid,
                phy_addr_t *paddr,
                mem_access_t access,
                l1_itlb_entry_t *l1_itlb,
@@ -173,46 +346,66 @@ int tlb_search(const void *mem_space,
                l2_tlb_entry_t *l2_tlb,
                int *hit_or_miss)
 {
+    M_REQUIRE_NON_NULL(hit_or_miss);
+    hit_lvl_t level = HIT_NONE;
+    M_EXIT_IF_ERR(tlb_translate(walker, vaddr, asid, paddr, access, l1_itlb, l1_dtlb, l2_tlb, &level), "while translating the address");
+    *hit_or_miss = (level != HIT_NONE); // a hit in any of the two levels is a hit
+    return ERR_NONE;
+}
+
+int tlb_translate(const page_walker_t *walker,
+                  const virt_addr_t *vaddr,
+                  asid_t asid,
+                  phy_addr_t *paddr,
+                  mem_access_t access,
+                  l1_itlb_entry_t *l1_itlb,
+                  l1_dtlb_entry_t *l1_dtlb,
+                  l2_tlb_entry_t *l2_tlb,
+                  hit_lvl_t *level)
+{
 
-    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE_NON_NULL(walker);
     M_REQUIRE_NON_NULL(vaddr);
     M_REQUIRE_NON_NULL(paddr);
     M_REQUIRE_NON_NULL(l1_itlb);
     M_REQUIRE_NON_NULL(l1_dtlb);
     M_REQUIRE_NON_NULL(l2_tlb);
-    M_REQUIRE_NON_NULL(hit_or_miss);
+    M_REQUIRE_NON_NULL(level);
+    M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
     if ((access != INSTRUCTION) && (access != DATA))
         return ERR_BAD_PARAMETER;
 
-#define l1hit(acces, type, tlb_type)                                \
-    if (access == acces && (tlb_hit(vaddr, paddr, type, tlb_type))) \
+#define l1hit(acces, type, tlb_type)                                                     \
+    if (access == acces && (hit_vpn(vpg_num, asid, vaddr->page_offset, paddr, type, tlb_type))) \
     {                                                               \
-        *hit_or_miss = 1;                                           \
+        *level = HIT_L1;                                            \
         return ERR_NONE;                                            \
     }
 
 #define l2hit(type, tlb_type, LINES, tlbe)                                                                   \
     line_index = vpg_num % LINES;                                                                            \
     type ie;                                                                                                 \
-    M_EXIT_IF_ERR(tlb_entry_init(vaddr, paddr, &ie, tlb_type), "while initialising instruction tlb entry");  \
+    M_EXIT_IF_ERR(entry_init_vpn(vpg_num, asid, paddr, &ie, tlb_type), "while initialising instruction tlb entry"); \
+    ie.dirty = l2_tlb[vpg_num % L2_TLB_LINES].dirty; /* the L1 entry knows what the L2 one knew */            \
     M_EXIT_IF_ERR(tlb_insert(line_index, &ie, tlbe, tlb_type), "while inserting the instruction tlb entry"); \
     return ERR_NONE;
 
 #define l2_to_l1(type, LINES, tlb_type, tlbthis, tlbother)                                                      \
     line_index = vpg_num % LINES;                                                                               \
     type ientry;                                                                                                \
-    M_EXIT_IF_ERR(tlb_entry_init(vaddr, paddr, &ientry, tlb_type), "while initialising tlb entry");             \
+    M_EXIT_IF_ERR(entry_init_vpn(vpg_num, asid, paddr, &ientry, tlb_type), "while initialising tlb entry");      \
     M_EXIT_IF_ERR(tlb_insert(line_index, &ientry, tlbthis, tlb_type);, "while inserting the tlb entry in L1 "); \
-    if (isValid == 1 && tlbother[line_index].tag == tag)                                                        \
+    if (isValid == 1 && tlbother[line_index].tag == tag && tlbother[line_index].asid == old_asid)               \
         tlbother[line_index].v = 0;
 
+    // the virtual page number is computed once for all the levels
+    const uint64_t vpg_num = virt_addr_t_to_virtual_page_number(vaddr);
     l1hit(INSTRUCTION, l1_itlb, L1_ITLB); //checking if hit in level 1 tlb
     l1hit(DATA, l1_dtlb, L1_DTLB);
-    uint64_t vpg_num = virt_addr_t_to_virtual_page_number(vaddr);
     list_content_t line_index = 0;
-    if (tlb_hit(vaddr, paddr, l2_tlb, L2_TLB)) // it's a hit in l2
+    if (hit_vpn(vpg_num, asid, vaddr->page_offset, paddr, l2_tlb, L2_TLB)) // it's a hit in l2
     {
-        *hit_or_miss = 1; // hit in l2, but must recopy the information in the corresponding l1 tlb
+        *level = HIT_L2; // hit in l2, but must recopy the information in the corresponding l1 tlb
 
         if (access == INSTRUCTION) // getting the corresponding line index for l1 instruction AND putting the informationin l1 instruction tbl
         {
@@ -223,17 +416,19 @@ int tlb_search(const void *mem_space,
             l2hit(l1_dtlb_entry_t, L1_DTLB, L1_DTLB_LINES, l1_dtlb);
         }
     }
-    *hit_or_miss = 0; // if it's not in l1 or l2
+    *level = HIT_NONE; // if it's not in l1 or l2
 
-    M_EXIT_IF_ERR(page_walk(mem_space, vaddr, paddr), "while calling page walk");
+    M_EXIT_IF_ERR(page_walk(walker, vaddr, paddr), "while calling page walk");
     l2_tlb_entry_t entry;
-    M_EXIT_IF_ERR(tlb_entry_init(vaddr, paddr, &entry, L2_TLB), "while initialising tlb entry"); // initialise a level 2 tlb entry
+    M_EXIT_IF_ERR(entry_init_vpn(vpg_num, asid, paddr, &entry, L2_TLB), "while initialising tlb entry"); // initialise a level 2 tlb entry
     line_index = vpg_num % L2_TLB_LINES;
     int isValid = 0;
     uint32_t tag = 0;
+    asid_t old_asid = 0;
     if (l2_tlb[line_index].v == 1) // if there was an entry before in l2
     {
         isValid = 1;
+        old_asid = l2_tlb[line_index].asid;
         tag = l2_tlb[line_index].tag << OFF;
         tag = tag | (line_index >> LINE_OFF);                                                              // 32 bit tag = (30 bit tag from l2 & 2 first bits of line index of l2)
     }                                                                                                      // getting the right index in l2
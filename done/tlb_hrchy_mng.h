@@ -11,6 +11,36 @@
 #include "tlb_hrchy.h"
 #include "mem_access.h"
 #include "addr.h"
+#include "page_walk.h"
+
+#include <stdio.h> // for FILE
+
+//=========================================================================
+/**
+ * @brief Print all the entries of a TLB, one "V; TAG; PHY_PAGE_NUM;" per line
+ *        (dashes for an invalid entry), as test-tlb_hrchy does.
+ * @param output the stream to print to
+ * @param tlb (generic) pointer to the TLB
+ * @param tlb_type an enum to distinguish between different TLBs
+ * @return error code
+ */
+int tlb_dump(FILE *output, const void *tlb, tlb_t tlb_type);
+
+//=========================================================================
+/**
+ * @brief Print the entries of a TLB that changed since the previous call, one
+ *        "LINE: V; TAG; PHY_PAGE_NUM;" per line, and record them in previous.
+ *
+ * previous is a copy of the TLB, flushed before the first call: applying the
+ * printed entries in turn to a flushed TLB gives back its full contents at
+ * each call.
+ * @param output the stream to print to
+ * @param tlb (generic) pointer to the TLB
+ * @param previous (modified) the TLB as of the previous call, of the same type
+ * @param tlb_type an enum to distinguish between different TLBs
+ * @return error code
+ */
+int tlb_dump_delta(FILE *output, const void *tlb, void *previous, tlb_t tlb_type);
 
 //=========================================================================
 /**
@@ -24,6 +54,48 @@
 
 int tlb_flush(void *tlb, tlb_t tlb_type);
 
+//=========================================================================
+/**
+ * @brief Invalidate the entry of one virtual page of an address space, if any
+ *        (like x86 INVLPG). Only the line the page maps to is looked at.
+ *
+ * @param tlb (generic) pointer to the TLB
+ * @param tlb_type an enum to distinguish between different TLBs
+ * @param vpn the virtual page number
+ * @param asid the address space of the page
+ * @return error code
+ */
+int tlb_invalidate_page(void *tlb, tlb_t tlb_type, uint64_t vpn, asid_t asid);
+
+//=========================================================================
+/**
+ * @brief Invalidate the entries of consecutive virtual pages of an address space.
+ *
+ * The lines the pages map to are looked at, each once: the cost is that of
+ * the smallest of the range and the TLB.
+ * @param tlb (generic) pointer to the TLB
+ * @param tlb_type an enum to distinguish between different TLBs
+ * @param first_vpn the virtual page number of the first page
+ * @param nb_pages the number of pages
+ * @param asid the address space of the pages
+ * @return error code
+ */
+int tlb_invalidate_range(void *tlb, tlb_t tlb_type, uint64_t first_vpn, uint64_t nb_pages, asid_t asid);
+
+//=========================================================================
+/**
+ * @brief Invalidate all the entries of an address space, leaving the others.
+ *
+ * The entries are not indexed by address space: all the lines of the TLB
+ * are looked at, at most L2_TLB_LINES consecutive words, which is also the
+ * cost of tlb_flush().
+ * @param tlb (generic) pointer to the TLB
+ * @param tlb_type an enum to distinguish between different TLBs
+ * @param asid the address space
+ * @return error code
+ */
+int tlb_invalidate_asid(void *tlb, tlb_t tlb_type, asid_t asid);
+
 //=========================================================================
 /**
  * @brief Check if a TLB entry exists in the TLB.
@@ -31,7 +103,11 @@ int tlb_flush(void *tlb, tlb_t tlb_type);
  * On hit, return success (1) and update the physical page number passed as the pointer to the function.
  * On miss, return miss (0).
  *
+ * Entries are tagged with the address space they were filled for and only
+ * hit for it, so that switching between address spaces needs no flush.
+ *
  * @param vaddr pointer to virtual address
+ * @param asid the address space of the virtual address
  * @param paddr (modified) pointer to physical address
  * @param tlb pointer to the beginning of the tlb
  * @param tlb_type to distinguish between different TLBs
@@ -39,6 +115,7 @@ int tlb_flush(void *tlb, tlb_t tlb_type);
  */
 
 int tlb_hit(const virt_addr_t *vaddr,
+            asid_t asid,
             phy_addr_t *paddr,
             const void *tlb,
             tlb_t tlb_type);
@@ -63,6 +140,7 @@ int tlb_insert(uint32_t line_index,
 /**
  * @brief Initialize a TLB entry
  * @param vaddr pointer to virtual address, to extract tlb tag
+ * @param asid the address space the entry is tagged with, below NB_ASIDS
  * @param paddr pointer to physical address, to extract physical page number
  * @param tlb_entry pointer to the entry to be initialized
  * @param tlb_type to distinguish between different TLBs
@@ -70,6 +148,7 @@ int tlb_insert(uint32_t line_index,
  */
 
 int tlb_entry_init(const virt_addr_t *vaddr,
+                   asid_t asid,
                    const phy_addr_t *paddr,
                    void *tlb_entry,
                    tlb_t tlb_type);
@@ -78,8 +157,9 @@ int tlb_entry_init(const virt_addr_t *vaddr,
 /**
  * @brief Ask TLB for the translation.
  *
- * @param mem_space pointer to the memory space
+ * @param walker the page tables of the address space, walked on a miss
  * @param vaddr pointer to virtual address
+ * @param asid the address space of the virtual address, below NB_ASIDS
  * @param paddr (modified) pointer to physical address (returned from TLB)
  * @param access to distinguish between fetching instructions and reading/writing data
  * @param l1_itlb pointer to the beginning of L1 ITLB
@@ -89,11 +169,39 @@ int tlb_entry_init(const virt_addr_t *vaddr,
  * @return error code
  */
 
-int tlb_search(const void *mem_space,
+int tlb_search(const page_walker_t *walker,
                const virt_addr_t *vaddr,
+               asid_t asid,
                phy_addr_t *paddr,
                mem_access_t access,
                l1_itlb_entry_t *l1_itlb,
                l1_dtlb_entry_t *l1_dtlb,
                l2_tlb_entry_t *l2_tlb,
                int *hit_or_miss);
+
+//=========================================================================
+/**
+ * @brief Ask TLB for the translation, reporting which level it was found at.
+ * Same as tlb_search() but distinguishes between L1 and L2 hits.
+ *
+ * @param walker the page tables of the address space, walked on a miss
+ * @param vaddr pointer to virtual address
+ * @param asid the address space of the virtual address, below NB_ASIDS
+ * @param paddr (modified) pointer to physical address (returned from TLB)
+ * @param access to distinguish between fetching instructions and reading/writing data
+ * @param l1_itlb pointer to the beginning of L1 ITLB
+ * @param l1_dtlb pointer to the beginning of L1 DTLB
+ * @param l2_tlb pointer to the beginning of L2 TLB
+ * @param level (modified) HIT_L1, HIT_L2, or HIT_NONE when a page walk was needed
+ * @return error code
+ */
+
+int tlb_translate(const page_walker_t *walker,
+                  const virt_addr_t *vaddr,
+                  asid_t asid,
+                  phy_addr_t *paddr,
+                  mem_access_t access,
+                  l1_itlb_entry_t *l1_itlb,
+                  l1_dtlb_entry_t *l1_dtlb,
+                  l2_tlb_entry_t *l2_tlb,
+                  hit_lvl_t *level);
@@ -6,6 +6,7 @@
  * @date 2019
  */
 #include "tlb_mng.h"
+#include "tlb_policy.h"
 #include "tlb.h"
 #include "addr_mng.h"
 #include "addr.h"
@@ -14,16 +15,23 @@
 #include "page_walk.h"
 #include "util.h"
 
+#include <inttypes.h> // for PRIx64
+#include <string.h>   // for strlen(), strcmp()
+
 int tlb_entry_init(const virt_addr_t *vaddr,
+				   asid_t asid,
 				   const phy_addr_t *paddr,
 				   tlb_entry_t *tlb_entry)
 {
 	M_REQUIRE_NON_NULL(tlb_entry);
 	M_REQUIRE_NON_NULL(vaddr);
 	M_REQUIRE_NON_NULL(paddr);
+	M_REQUIRE(asid < NB_ASIDS, ERR_BAD_PARAMETER, "ASID %u is not below %d", asid, NB_ASIDS);
+	tlb_entry->word = 0;
 	tlb_entry->tag = virt_addr_t_to_virtual_page_number(vaddr);
 	tlb_entry->phy_page_num = paddr->phy_page_num;
 	tlb_entry->v = 1;
+	tlb_entry->asid = asid;
 	return ERR_NONE;
 }
 
@@ -37,6 +45,55 @@ int tlb_flush(tlb_entry_t *tlb)
 	return ERR_NONE;
 }
 
+int tlb_invalidate_page(tlb_entry_t *tlb, uint64_t vpn, asid_t asid)
+{
+	M_REQUIRE_NON_NULL(tlb);
+	M_REQUIRE(vpn < (UINT64_C(1) << VIRT_PAGE_NUM), ERR_ADDR, "virtual page number 0x%" PRIx64 " is too large", vpn);
+	for (uint32_t line = 0; line < TLB_LINES; ++line)
+	{
+		if (tlb_entry_hit(tlb[line], vpn, asid)) // a page has at most one entry
+		{
+			tlb[line].v = 0;
+			break;
+		}
+	}
+	return ERR_NONE;
+}
+
+int tlb_invalidate_range(tlb_entry_t *tlb, uint64_t first_vpn, uint64_t nb_pages, asid_t asid)
+{
+	M_REQUIRE_NON_NULL(tlb);
+	M_REQUIRE(first_vpn <= (UINT64_C(1) << VIRT_PAGE_NUM) && nb_pages <= (UINT64_C(1) << VIRT_PAGE_NUM) - first_vpn,
+			  ERR_ADDR, "range of %" PRIu64 " pages from 0x%" PRIx64 " is too large", nb_pages, first_vpn);
+	for (uint32_t line = 0; line < TLB_LINES; ++line)
+	{
+		if (tlb[line].v && tlb[line].asid == asid && tlb[line].tag >= first_vpn && tlb[line].tag - first_vpn < nb_pages)
+			tlb[line].v = 0;
+	}
+	return ERR_NONE;
+}
+
+int tlb_invalidate_asid(tlb_entry_t *tlb, asid_t asid)
+{
+	M_REQUIRE_NON_NULL(tlb);
+	for (uint32_t line = 0; line < TLB_LINES; ++line)
+	{
+		if (tlb[line].v && tlb[line].asid == asid)
+			tlb[line].v = 0;
+	}
+	return ERR_NONE;
+}
+
+// a policy of the original API, the LRU list alone with no operations, is
+// that of TLB_POLICY_LIST: it is initialized on first use
+static int policy_ready(replacement_policy_t *replacement_policy)
+{
+	if (replacement_policy->ops != NULL)
+		return ERR_NONE;
+	M_REQUIRE_NON_NULL(replacement_policy->ll);
+	return tlb_policy_init(replacement_policy, &TLB_POLICY_LIST);
+}
+
 int tlb_insert(uint32_t line_index,
 			   const tlb_entry_t *tlb_entry,
 			   tlb_entry_t *tlb)
@@ -48,52 +105,84 @@ int tlb_insert(uint32_t line_index,
 	return ERR_NONE;
 }
 
-int tlb_hit(const virt_addr_t *vaddr, phy_addr_t *paddr, const tlb_entry_t *tlb, replacement_policy_t *replacement_policy)
+int tlb_hit(const virt_addr_t *vaddr, asid_t asid, phy_addr_t *paddr, const tlb_entry_t *tlb, replacement_policy_t *replacement_policy)
 {
-	if (tlb == NULL || replacement_policy == NULL || paddr == NULL || vaddr == NULL || replacement_policy->ll == NULL)
+	if (tlb == NULL || replacement_policy == NULL || paddr == NULL || vaddr == NULL || policy_ready(replacement_policy) != ERR_NONE)
 	{
 		return 0; // if the arguments are not valid return 0=miss
 	}
 	uint64_t vpg_num = virt_addr_t_to_virtual_page_number(vaddr);
-	list_content_t i = 0;							 // i will store the index of the required entry in the tlb
-	for_all_nodes_reverse(n, replacement_policy->ll) // looping trough all the nodes of the linked list in reverse order
+	// a page has at most one entry: the lines are looked at in order, and the
+	// policy is told about the one hit
+	for (uint32_t line = 0; line < TLB_LINES; ++line)
 	{
-		i = n->value;
-		if (tlb[i].tag == vpg_num && tlb[i].v == 1) // finding the right entry in the tlb if it exists
+		if (tlb_entry_hit(tlb[line], vpg_num, asid))
 		{
-			replacement_policy->move_back(replacement_policy->ll, n);					  //move back node that keeps the index i, since it was just used
-			init_phy_addr(paddr, tlb[i].phy_page_num << PAGE_OFFSET, vaddr->page_offset); // initialise physical address
-
-			return 1; // return hit
+			replacement_policy->ops->touch(replacement_policy, line);
+			init_phy_addr(paddr, tlb[line].phy_page_num << PAGE_OFFSET, vaddr->page_offset);
+			return 1;
 		}
 	}
 	return 0; // no corresponding entry for that virt address was found = miss
 }
-int tlb_search(const void *mem_space, const virt_addr_t *vaddr, phy_addr_t *paddr,
+int tlb_search(const page_walker_t *walker, const virt_addr_t *vaddr, asid_t asid, phy_addr_t *paddr,
 			   tlb_entry_t *tlb, replacement_policy_t *replacement_policy, int *hit_or_miss)
 {
 
-	M_REQUIRE_NON_NULL(mem_space);
+	M_REQUIRE_NON_NULL(walker);
 	M_REQUIRE_NON_NULL(vaddr);
 	M_REQUIRE_NON_NULL(paddr);
 	M_REQUIRE_NON_NULL(tlb);
 	M_REQUIRE_NON_NULL(replacement_policy);
 	M_REQUIRE_NON_NULL(hit_or_miss);
-	M_REQUIRE_NON_NULL(replacement_policy->ll);
+	M_EXIT_IF_ERR(policy_ready(replacement_policy), "while initialising the replacement policy");
 
-	if (tlb_hit(vaddr, paddr, tlb, replacement_policy) == 1)
+	if (tlb_hit(vaddr, asid, paddr, tlb, replacement_policy) == 1)
 	{
 		*hit_or_miss = 1; // if it was a hit, everything was done in tlb_hit
 		return ERR_NONE;
 	}
 	*hit_or_miss = 0; // it was a miss
-	M_EXIT_IF_ERR(page_walk(mem_space, vaddr, paddr), "while calling page walk");
+	M_EXIT_IF_ERR(page_walk(walker, vaddr, paddr), "while calling page walk");
 	tlb_entry_t entry;
-	M_EXIT_IF_ERR(tlb_entry_init(vaddr, paddr, &entry), "while initialising tlb entry"); // initialising a new tlb entry with the data from the virt address
-	M_REQUIRE(!is_empty_list(replacement_policy->ll), ERR_BAD_PARAMETER, "linked list in replacement policy is empty, should have at least %d element", 1);
-	//put the entry in the tlb at the value stored at node 0 of the ll
-	list_content_t index = replacement_policy->ll->front->value;
-	M_EXIT_IF_ERR(tlb_insert(index, &entry, tlb), "while inserting the tlb entry"); // inserting the initialised entry at the correct index in the tlb
-	replacement_policy->move_back(replacement_policy->ll, replacement_policy->ll->front);
+	M_EXIT_IF_ERR(tlb_entry_init(vaddr, asid, paddr, &entry), "while initialising tlb entry"); // initialising a new tlb entry with the data from the virt address
+	const uint32_t line = replacement_policy->ops->victim(replacement_policy);
+	M_EXIT_IF_ERR(tlb_insert(line, &entry, tlb), "while inserting the tlb entry"); // a victim of TLB_LINES (none) is refused
+	replacement_policy->ops->touch(replacement_policy, line);
 	return ERR_NONE;
 }
+
+int tlb_checkpoint_write(FILE *output, const tlb_entry_t *tlb, const replacement_policy_t *replacement_policy)
+{
+	M_REQUIRE_NON_NULL(output);
+	M_REQUIRE_NON_NULL(tlb);
+	M_REQUIRE_NON_NULL(replacement_policy);
+	// a policy not used yet may still have no operations (see policy_ready())
+	const tlb_policy_ops_t *ops = replacement_policy->ops != NULL ? replacement_policy->ops : &TLB_POLICY_LIST;
+	M_REQUIRE(replacement_policy->ops != NULL || replacement_policy->ll != NULL, ERR_BAD_PARAMETER, "%s", "policy with neither operations nor list");
+	M_REQUIRE(fwrite(tlb, sizeof(tlb_entry_t), TLB_LINES, output) == TLB_LINES, ERR_IO, "cannot write the %d TLB entries", TLB_LINES);
+	const char *name = ops->name;
+	const size_t name_len = strlen(name);
+	M_REQUIRE(name_len <= UINT8_MAX, ERR_SIZE, "policy name %s is too long", name);
+	const uint8_t len = (uint8_t)name_len;
+	M_REQUIRE(fwrite(&len, sizeof(len), 1, output) == 1 && fwrite(name, 1, len, output) == len, ERR_IO,
+			  "cannot write the name of policy %s", name);
+	return ops->write(replacement_policy, output);
+}
+
+int tlb_checkpoint_read(FILE *input, tlb_entry_t *tlb, replacement_policy_t *replacement_policy)
+{
+	M_REQUIRE_NON_NULL(input);
+	M_REQUIRE_NON_NULL(tlb);
+	M_REQUIRE_NON_NULL(replacement_policy);
+	M_EXIT_IF_ERR(policy_ready(replacement_policy), "while initialising the replacement policy");
+	M_REQUIRE(fread(tlb, sizeof(tlb_entry_t), TLB_LINES, input) == TLB_LINES, ERR_IO, "cannot read the %d TLB entries", TLB_LINES);
+	uint8_t len = 0;
+	char name[UINT8_MAX + 1];
+	M_REQUIRE(fread(&len, sizeof(len), 1, input) == 1 && fread(name, 1, len, input) == len, ERR_IO,
+			  "cannot read the %s", "policy name");
+	name[len] = '\0';
+	M_REQUIRE(strcmp(name, replacement_policy->ops->name) == 0, ERR_POLICY,
+			  "checkpoint of policy %s, not %s", name, replacement_policy->ops->name);
+	return replacement_policy->ops->read(replacement_policy, input);
+}
@@ -11,13 +11,44 @@
 #include "tlb.h"
 #include "addr.h"
 #include "list.h"
+#include "page_walk.h"
 
+#include <stdio.h> // for FILE
+
+typedef struct replacement_policy replacement_policy_t;
+
+/**
+ * @brief Operations of a replacement policy (see tlb_policy.h for the provided ones).
+ *
+ * A policy only chooses the lines: the entries themselves stay in the TLB.
+ */
 typedef struct
+{
+    const char *name;
+    int (*init)(replacement_policy_t *this);                  // allocates the state, for TLB_LINES lines
+    void (*free)(replacement_policy_t *this);                 // releases the state
+    uint32_t (*victim)(replacement_policy_t *this);           // the line to overwrite on a miss, TLB_LINES if none
+    void (*touch)(replacement_policy_t *this, uint32_t line); // the line was just hit or filled
+    int (*write)(const replacement_policy_t *this, FILE *output); // saves the state (see tlb_checkpoint_write())
+    int (*read)(replacement_policy_t *this, FILE *input);         // restores it, the policy being initialized
+} tlb_policy_ops_t;
+
+/**
+ * @brief The replacement policy of a TLB, given by its operations and their
+ * private state. The original LRU list (TLB_POLICY_LIST) is kept in ll, up
+ * to date through push_back and move_back; the other policies leave these.
+ * A policy of the original API, with ll, push_back and move_back set but no
+ * operations, is initialized as TLB_POLICY_LIST on first use.
+ */
+struct replacement_policy
 {
     list_t *ll;
     node_t *(*push_back)(list_t *this, const list_content_t *value);
     void (*move_back)(list_t *this, node_t *node);
-} replacement_policy_t;
+    const tlb_policy_ops_t *ops;
+    void *state;
+};
+
 //=========================================================================
 /**
  * @brief Clean a TLB (invalidate, reset...).
@@ -29,6 +60,45 @@ typedef struct
 
 int tlb_flush(tlb_entry_t *tlb);
 
+//=========================================================================
+/**
+ * @brief Invalidate the entry of one virtual page of an address space, if any (as x86 INVLPG).
+ *
+ * The TLB being fully associative, with no index, its lines are scanned
+ * up to the entry. The other entries and the replacement policy are left.
+ * @param tlb pointer to the TLB
+ * @param vpn the virtual page number
+ * @param asid the address space of the page
+ * @return error code
+ */
+int tlb_invalidate_page(tlb_entry_t *tlb, uint64_t vpn, asid_t asid);
+
+//=========================================================================
+/**
+ * @brief Invalidate the entries of consecutive virtual pages of an address space.
+ *
+ * Finding the entry of one page takes a scan already: all the lines are
+ * looked at once, whatever the size of the range.
+ * @param tlb pointer to the TLB
+ * @param first_vpn the virtual page number of the first page
+ * @param nb_pages the number of pages
+ * @param asid the address space of the pages
+ * @return error code
+ */
+int tlb_invalidate_range(tlb_entry_t *tlb, uint64_t first_vpn, uint64_t nb_pages, asid_t asid);
+
+//=========================================================================
+/**
+ * @brief Invalidate all the entries of an address space, leaving the others.
+ *
+ * The entries are not indexed by address space: all the TLB_LINES lines
+ * are looked at, as by tlb_flush().
+ * @param tlb pointer to the TLB
+ * @param asid the address space
+ * @return error code
+ */
+int tlb_invalidate_asid(tlb_entry_t *tlb, asid_t asid);
+
 //=========================================================================
 /**
  * @brief Check if a TLB entry exists in the TLB.
@@ -36,12 +106,18 @@ int tlb_flush(tlb_entry_t *tlb);
  * On hit, return success (1) and update the physical page number passed as the pointer to the function.
  * On miss, return miss (0).
  *
+ * Entries are tagged with the address space they were filled for and only
+ * hit for it, so that switching between address spaces needs no flush.
+ *
  * @param vaddr pointer to virtual address
+ * @param asid the address space of the virtual address
  * @param paddr (modified) pointer to physical address
  * @param tlb pointer to the beginning of the tlb
+ * @param replacement_policy the replacement policy, told about the line hit
  * @return hit (1) or miss (0)
  */
 int tlb_hit(const virt_addr_t *vaddr,
+            asid_t asid,
             phy_addr_t *paddr,
             const tlb_entry_t *tlb,
             replacement_policy_t *replacement_policy);
@@ -64,11 +140,13 @@ int tlb_insert(uint32_t line_index,
 /**
  * @brief Initialize a TLB entry
  * @param vaddr pointer to virtual address, to extract tlb tag
+ * @param asid the address space the entry is tagged with, below NB_ASIDS
  * @param paddr pointer to physical address, to extract physical page number
  * @param tlb_entry pointer to the entry to be initialized
  * @return  error code
  */
 int tlb_entry_init(const virt_addr_t *vaddr,
+                   asid_t asid,
                    const phy_addr_t *paddr,
                    tlb_entry_t *tlb_entry);
 
@@ -76,16 +154,52 @@ int tlb_entry_init(const virt_addr_t *vaddr,
 /**
  * @brief Ask TLB for the translation.
  *
- * @param mem_space pointer to the memory space
+ * @param walker the page tables of the address space, walked on a miss
  * @param vaddr pointer to virtual address
+ * @param asid the address space of the virtual address, below NB_ASIDS
  * @param paddr (modified) pointer to physical address (returned from TLB)
  * @param tlb pointer to the beginning of the TLB
+ * @param replacement_policy the replacement policy, choosing the line to overwrite on a miss
  * @param hit_or_miss (modified) hit (1) or miss (0)
  * @return error code
  */
-int tlb_search(const void *mem_space,
+int tlb_search(const page_walker_t *walker,
                const virt_addr_t *vaddr,
+               asid_t asid,
                phy_addr_t *paddr,
                tlb_entry_t *tlb,
                replacement_policy_t *replacement_policy,
                int *hit_or_miss);
+
+//=========================================================================
+/**
+ * @brief Write a TLB and the state of its replacement policy to a binary stream.
+ *
+ * The entries are written as they are in memory, followed by the name of the
+ * policy (its length on one byte, then its characters) and the state of the
+ * policy, in a format of its own. For the LRU list, that is the number of
+ * nodes and their values, from front (least recently used) to back.
+ *
+ * @param output the stream to write to
+ * @param tlb pointer to the TLB
+ * @param replacement_policy the replacement policy of the TLB
+ * @return error code
+ */
+int tlb_checkpoint_write(FILE *output,
+                         const tlb_entry_t *tlb,
+                         const replacement_policy_t *replacement_policy);
+
+//=========================================================================
+/**
+ * @brief Restore a TLB and the state of its replacement policy from a binary stream
+ *        written by tlb_checkpoint_write().
+ *
+ * @param input the stream to read from
+ * @param tlb (modified) pointer to the TLB
+ * @param replacement_policy (modified) the replacement policy, initialized with the
+ *        policy of the checkpoint (ERR_POLICY otherwise), whose state is restored
+ * @return error code
+ */
+int tlb_checkpoint_read(FILE *input,
+                        tlb_entry_t *tlb,
+                        replacement_policy_t *replacement_policy);
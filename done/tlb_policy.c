@@ -0,0 +1,367 @@
+/**
+ * @file tlb_policy.c
+ * @brief replacement policies for the fully-associative TLB
+ *
+ * @date 2019
+ */
+
+#include "tlb_policy.h"
+#include "tlb.h"
+#include "list.h"
+#include "error.h"
+
+#include <stdlib.h>   // for calloc(), free()
+#include <string.h>   // for strcmp()
+#include <inttypes.h> // for PRIu32
+
+#define POLICY_SEED 0x5eed2019ULL // seed of the random policy, for reproducible runs
+
+// writes or reads the NB values at PTR of a policy state, ERR_IO if they are not all
+#define state_write(OUTPUT, PTR, NB) \
+    M_REQUIRE(fwrite(PTR, sizeof(*(PTR)), NB, OUTPUT) == (NB), ERR_IO, "cannot write %s", "the policy state")
+#define state_read(INPUT, PTR, NB) \
+    M_REQUIRE(fread(PTR, sizeof(*(PTR)), NB, INPUT) == (NB), ERR_IO, "cannot read %s", "the policy state")
+
+// ======================================================================
+// LIST: the original LRU list, from the least to the most recently used
+// line, through the list functions of the policy. It is the list of the
+// caller when ll is set before tlb_policy_init(), else one of its own, the
+// state then pointing to it
+static int list_init(replacement_policy_t *this)
+{
+    if (this->push_back == NULL)
+        this->push_back = push_back;
+    if (this->move_back == NULL)
+        this->move_back = move_back;
+    if (this->ll != NULL)
+        return ERR_NONE;
+    list_t *ll = malloc(sizeof(list_t));
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(ll, ERR_MEM);
+    init_list(ll);
+    for (list_content_t line = 0; line < TLB_LINES; ++line)
+    { // lines in order, line 0 being used first
+        if (this->push_back(ll, &line) == NULL)
+        {
+            clear_list(ll);
+            free(ll);
+            return ERR_MEM;
+        }
+    }
+    this->ll = ll;
+    this->state = ll;
+    return ERR_NONE;
+}
+
+static void list_free(replacement_policy_t *this)
+{
+    if (this->state == NULL)
+        return; // the list of the caller
+    clear_list(this->state);
+    free(this->state);
+    this->state = NULL;
+    this->ll = NULL;
+}
+
+static uint32_t list_victim(replacement_policy_t *this)
+{
+    return is_empty_list(this->ll) ? TLB_LINES : this->ll->front->value;
+}
+
+static void list_touch(replacement_policy_t *this, uint32_t line)
+{
+    // from the most recently used end, where the hits mostly are
+    for_all_nodes_reverse(n, this->ll)
+    {
+        if (n->value == line)
+        {
+            this->move_back(this->ll, n);
+            return;
+        }
+    }
+}
+
+static int list_write(const replacement_policy_t *this, FILE *output)
+{
+    uint32_t nb_nodes = 0;
+    for_all_nodes(n, this->ll)
+    {
+        ++nb_nodes;
+    }
+    state_write(output, &nb_nodes, 1);
+    for_all_nodes(n, this->ll) // from the least to the most recently used
+    {
+        state_write(output, &n->value, 1);
+    }
+    return ERR_NONE;
+}
+
+// the list is left as it was unless the saved one holds every line once
+static int list_read(replacement_policy_t *this, FILE *input)
+{
+    uint32_t nb_nodes = 0;
+    list_content_t order[TLB_LINES];
+    uint8_t seen[TLB_LINES] = {0};
+    state_read(input, &nb_nodes, 1);
+    M_REQUIRE(nb_nodes == TLB_LINES, ERR_SIZE, "%" PRIu32 " list nodes, not %d", nb_nodes, TLB_LINES);
+    state_read(input, order, TLB_LINES);
+    for (uint32_t i = 0; i < TLB_LINES; ++i)
+    {
+        M_REQUIRE(order[i] < TLB_LINES && !seen[order[i]], ERR_BAD_PARAMETER,
+                  "line %" PRIu32 " is out of the TLB or twice in the list", order[i]);
+        seen[order[i]] = 1;
+    }
+    clear_list(this->ll);
+    for (uint32_t i = 0; i < TLB_LINES; ++i)
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(this->push_back(this->ll, &order[i]), ERR_MEM);
+    return ERR_NONE;
+}
+
+// ======================================================================
+// LRU: the lines form a circular doubly linked list through two arrays,
+// the extra node TLB_LINES being its head: after it the least recently
+// used line, before it the most recently used one
+#define LRU_HEAD TLB_LINES
+
+typedef struct
+{
+    uint32_t prev[TLB_LINES + 1];
+    uint32_t next[TLB_LINES + 1];
+} lru_state_t;
+
+static int lru_init(replacement_policy_t *this)
+{
+    lru_state_t *lru = calloc(1, sizeof(lru_state_t));
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(lru, ERR_MEM);
+    for (uint32_t i = 0; i <= LRU_HEAD; ++i)
+    { // lines in order, line 0 being used first
+        lru->next[i] = (i + 1) % (LRU_HEAD + 1);
+        lru->prev[i] = (i + LRU_HEAD) % (LRU_HEAD + 1);
+    }
+    this->state = lru;
+    return ERR_NONE;
+}
+
+static uint32_t lru_victim(replacement_policy_t *this)
+{
+    return ((const lru_state_t *)this->state)->next[LRU_HEAD];
+}
+
+static void lru_touch(replacement_policy_t *this, uint32_t line)
+{
+    lru_state_t *lru = this->state;
+    // unlinks the line, then links it back as the most recently used one
+    lru->next[lru->prev[line]] = lru->next[line];
+    lru->prev[lru->next[line]] = lru->prev[line];
+    lru->prev[line] = lru->prev[LRU_HEAD];
+    lru->next[line] = LRU_HEAD;
+    lru->next[lru->prev[LRU_HEAD]] = line;
+    lru->prev[LRU_HEAD] = line;
+}
+
+// the lines are saved from the least to the most recently used
+static int lru_write(const replacement_policy_t *this, FILE *output)
+{
+    const lru_state_t *lru = this->state;
+    for (uint32_t line = lru->next[LRU_HEAD]; line != LRU_HEAD; line = lru->next[line])
+    {
+        state_write(output, &line, 1);
+    }
+    return ERR_NONE;
+}
+
+static int lru_read(replacement_policy_t *this, FILE *input)
+{
+    uint32_t order[TLB_LINES];
+    uint8_t seen[TLB_LINES] = {0};
+    state_read(input, order, TLB_LINES);
+    for (uint32_t i = 0; i < TLB_LINES; ++i)
+    {
+        M_REQUIRE(order[i] < TLB_LINES && !seen[order[i]], ERR_BAD_PARAMETER,
+                  "line %" PRIu32 " is out of the TLB or twice in the LRU order", order[i]);
+        seen[order[i]] = 1;
+    }
+    // touching the lines in that order leaves them in that order
+    for (uint32_t i = 0; i < TLB_LINES; ++i)
+        lru_touch(this, order[i]);
+    return ERR_NONE;
+}
+
+// ======================================================================
+// CLOCK: the hand skips (and clears) the referenced lines
+typedef struct
+{
+    uint8_t referenced[TLB_LINES];
+    uint32_t hand;
+} clock_state_t;
+
+static int clock_init(replacement_policy_t *this)
+{
+    this->state = calloc(1, sizeof(clock_state_t));
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(this->state, ERR_MEM);
+    return ERR_NONE;
+}
+
+static uint32_t clock_victim(replacement_policy_t *this)
+{
+    clock_state_t *clk = this->state;
+    while (clk->referenced[clk->hand])
+    {
+        clk->referenced[clk->hand] = 0;
+        clk->hand = (clk->hand + 1) % TLB_LINES;
+    }
+    const uint32_t line = clk->hand;
+    clk->hand = (clk->hand + 1) % TLB_LINES;
+    return line;
+}
+
+static void clock_touch(replacement_policy_t *this, uint32_t line)
+{
+    ((clock_state_t *)this->state)->referenced[line] = 1;
+}
+
+static int clock_write(const replacement_policy_t *this, FILE *output)
+{
+    const clock_state_t *clk = this->state;
+    state_write(output, clk->referenced, TLB_LINES);
+    state_write(output, &clk->hand, 1);
+    return ERR_NONE;
+}
+
+static int clock_read(replacement_policy_t *this, FILE *input)
+{
+    clock_state_t *clk = this->state;
+    state_read(input, clk->referenced, TLB_LINES);
+    state_read(input, &clk->hand, 1);
+    M_REQUIRE(clk->hand < TLB_LINES, ERR_BAD_PARAMETER, "clock hand %" PRIu32 " out of the TLB", clk->hand);
+    for (uint32_t line = 0; line < TLB_LINES; ++line)
+        clk->referenced[line] = clk->referenced[line] != 0;
+    return ERR_NONE;
+}
+
+// ======================================================================
+// RANDOM: xorshift64, once all the lines were filled
+typedef struct
+{
+    uint64_t seed;
+    uint32_t filled;
+} random_state_t;
+
+static int random_init(replacement_policy_t *this)
+{
+    random_state_t *rnd = calloc(1, sizeof(random_state_t));
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(rnd, ERR_MEM);
+    rnd->seed = POLICY_SEED;
+    this->state = rnd;
+    return ERR_NONE;
+}
+
+static uint32_t random_victim(replacement_policy_t *this)
+{
+    random_state_t *rnd = this->state;
+    if (rnd->filled < TLB_LINES)
+        return rnd->filled++;
+    rnd->seed ^= rnd->seed << 13;
+    rnd->seed ^= rnd->seed >> 7;
+    rnd->seed ^= rnd->seed << 17;
+    return (uint32_t)(rnd->seed % TLB_LINES);
+}
+
+static int random_write(const replacement_policy_t *this, FILE *output)
+{
+    const random_state_t *rnd = this->state;
+    state_write(output, &rnd->seed, 1);
+    state_write(output, &rnd->filled, 1);
+    return ERR_NONE;
+}
+
+static int random_read(replacement_policy_t *this, FILE *input)
+{
+    random_state_t *rnd = this->state;
+    state_read(input, &rnd->seed, 1);
+    state_read(input, &rnd->filled, 1);
+    // xorshift never leaves 0
+    M_REQUIRE(rnd->seed != 0 && rnd->filled <= TLB_LINES, ERR_BAD_PARAMETER,
+              "random state with %" PRIu32 " lines filled", rnd->filled);
+    return ERR_NONE;
+}
+
+// ======================================================================
+// FIFO: the lines are overwritten in turn
+static int fifo_init(replacement_policy_t *this)
+{
+    this->state = calloc(1, sizeof(uint32_t));
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(this->state, ERR_MEM);
+    return ERR_NONE;
+}
+
+static uint32_t fifo_victim(replacement_policy_t *this)
+{
+    uint32_t *next = this->state;
+    const uint32_t line = *next;
+    *next = (*next + 1) % TLB_LINES;
+    return line;
+}
+
+static int fifo_write(const replacement_policy_t *this, FILE *output)
+{
+    state_write(output, (const uint32_t *)this->state, 1);
+    return ERR_NONE;
+}
+
+static int fifo_read(replacement_policy_t *this, FILE *input)
+{
+    uint32_t *next = this->state;
+    state_read(input, next, 1);
+    M_REQUIRE(*next < TLB_LINES, ERR_BAD_PARAMETER, "next line %" PRIu32 " out of the TLB", *next);
+    return ERR_NONE;
+}
+
+// ======================================================================
+// shared by the policies
+static void state_free(replacement_policy_t *this)
+{
+    free(this->state);
+    this->state = NULL;
+}
+
+static void no_touch(replacement_policy_t *this, uint32_t line)
+{
+    (void)this;
+    (void)line;
+}
+
+const tlb_policy_ops_t TLB_POLICY_LIST = {"list", list_init, list_free, list_victim, list_touch, list_write, list_read};
+const tlb_policy_ops_t TLB_POLICY_LRU = {"lru", lru_init, state_free, lru_victim, lru_touch, lru_write, lru_read};
+const tlb_policy_ops_t TLB_POLICY_CLOCK = {"clock", clock_init, state_free, clock_victim, clock_touch, clock_write, clock_read};
+const tlb_policy_ops_t TLB_POLICY_RANDOM = {"random", random_init, state_free, random_victim, no_touch, random_write, random_read};
+const tlb_policy_ops_t TLB_POLICY_FIFO = {"fifo", fifo_init, state_free, fifo_victim, no_touch, fifo_write, fifo_read};
+
+static const tlb_policy_ops_t *const policies[] = {&TLB_POLICY_LIST, &TLB_POLICY_LRU, &TLB_POLICY_CLOCK, &TLB_POLICY_RANDOM, &TLB_POLICY_FIFO};
+
+const tlb_policy_ops_t *tlb_policy_find(const char *name)
+{
+    if (name == NULL)
+        return NULL;
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); ++i)
+    {
+        if (strcmp(policies[i]->name, name) == 0)
+            return policies[i];
+    }
+    return NULL;
+}
+
+int tlb_policy_init(replacement_policy_t *policy, const tlb_policy_ops_t *ops)
+{
+    M_REQUIRE_NON_NULL(policy);
+    M_REQUIRE_NON_NULL(ops);
+    // ll, push_back and move_back are left as the caller set them (see TLB_POLICY_LIST)
+    policy->ops = ops;
+    policy->state = NULL;
+    return ops->init(policy);
+}
+
+void tlb_policy_free(replacement_policy_t *policy)
+{
+    if (policy != NULL && policy->ops != NULL)
+        policy->ops->free(policy);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * @file tlb_policy.h
+ * @brief replacement policies for the fully-associative TLB (see tlb_mng.h)
+ *
+ * All of them choose the line to overwrite and update their state in O(1),
+ * except CLOCK whose hand may sweep the TLB and the original LRU list whose
+ * nodes are searched. They fill an empty TLB in line order, as the list does.
+ *
+ * @date 2019
+ */
+
+#include "tlb_mng.h"
+
+extern const tlb_policy_ops_t TLB_POLICY_LIST;   // the original LRU list (see replacement_policy_t)
+extern const tlb_policy_ops_t TLB_POLICY_LRU;    // least recently used, as an array-based doubly linked list
+extern const tlb_policy_ops_t TLB_POLICY_CLOCK;  // second chance: a reference bit per line and a sweeping hand
+extern const tlb_policy_ops_t TLB_POLICY_RANDOM; // a pseudo-random line, from a fixed seed
+extern const tlb_policy_ops_t TLB_POLICY_FIFO;   // the oldest filled line, whatever its use
+
+//=========================================================================
+/**
+ * @brief Find a replacement policy from its name ("list", "lru", "clock", "random" or "fifo").
+ * @param name the name of the policy
+ * @return the operations of the policy, NULL if there is none of that name
+ */
+const tlb_policy_ops_t *tlb_policy_find(const char *name);
+
+//=========================================================================
+/**
+ * @brief Initialize a replacement policy from its operations.
+ *
+ * Only the operations and the state are set: for TLB_POLICY_LIST, the list
+ * and its functions may be set before, the policy otherwise using a list of
+ * its own. The other fields shall be NULL or valid.
+ * @param policy (modified) the policy to initialize
+ * @param ops the operations of the policy
+ * @return error code
+ */
+int tlb_policy_init(replacement_policy_t *policy, const tlb_policy_ops_t *ops);
+
+//=========================================================================
+/**
+ * @brief Release the state of a replacement policy initialized by tlb_policy_init().
+ * @param policy the policy to release
+ */
+void tlb_policy_free(replacement_policy_t *policy);
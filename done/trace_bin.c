@@ -0,0 +1,269 @@
+/**
+ * @file trace_bin.c
+ * @brief compact binary trace format, and its streaming reader and writer
+ *
+ * @date 2019
+ */
+
+#include "trace_bin.h"
+#include "addr_mng.h"
+#include "error.h"
+
+#include <stdlib.h> // for malloc(), free()
+#include <string.h> // for memcmp(), memset()
+#include <inttypes.h> // for PRIx64
+
+#define HEAD_WRITE 0x01
+#define HEAD_DATA 0x02
+#define HEAD_SIZE_SHIFT 2
+#define HEAD_SIZE_MASK 0x07
+#define HEAD_PROCESS 0x20
+#define HEAD_RESERVED 0xC0
+#define LOG2_SIZE_MAX 4 // DATA_SIZE_LINE
+#define VARINT_MAX_BYTES 10 // 64 bits, 7 per byte
+#define VARINT_MORE 0x80
+#define BITS_IN_BYTE 8
+
+// zigzag encoding maps small signed numbers to small unsigned ones: 0, -1, 1, -2... to 0, 1, 2, 3...
+#define zigzag(X) (((X) << 1) ^ (uint64_t)(-(int64_t)((X) >> 63)))
+#define unzigzag(X) (((X) >> 1) ^ (uint64_t)(-(int64_t)((X)&1)))
+
+//=========================================================================
+// the next byte of the trace, EOF at its end
+static inline int next_byte(trace_bin_reader_t *reader)
+{
+    if (reader->pos == reader->len)
+    {
+        reader->len = trace_read(reader->file, reader->buffer, TRACE_BIN_BUFFER_SIZE);
+        reader->pos = 0;
+        if (reader->len == 0)
+            return EOF;
+    }
+    return reader->buffer[reader->pos++];
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to decode a LEB128 varint.
+ * @param reader the reader
+ * @param value (modified) the value decoded
+ * @return error code
+ */
+static int read_varint(trace_bin_reader_t *reader, uint64_t *value)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < VARINT_MAX_BYTES; ++i)
+    {
+        const int c = next_byte(reader);
+        M_REQUIRE(c != EOF, ERR_IO, "truncated %s", "varint");
+        // the 10th byte holds bit 63 only
+        M_REQUIRE(i < VARINT_MAX_BYTES - 1 || c <= 1, ERR_IO, "varint of more than %d bits", 64);
+        v |= (uint64_t)(c & ~VARINT_MORE) << (7 * i);
+        if (!(c & VARINT_MORE))
+        {
+            *value = v;
+            return ERR_NONE;
+        }
+    }
+    M_EXIT_ERR(ERR_IO, "varint longer than %d bytes", VARINT_MAX_BYTES);
+}
+
+//=========================================================================
+// the number of bytes of the LEB128 varint encoding v written to out
+static size_t write_varint(unsigned char *out, uint64_t v)
+{
+    size_t n = 0;
+    while (v >= VARINT_MORE)
+    {
+        out[n++] = (unsigned char)(v | VARINT_MORE);
+        v >>= 7;
+    }
+    out[n++] = (unsigned char)v;
+    return n;
+}
+
+//=========================================================================
+int trace_bin_is_binary(const char *filename)
+{
+    if (filename == NULL)
+        return 0;
+    trace_file_t file = trace_open(filename);
+    if (file == NULL)
+        return 0;
+    char magic[TRACE_BIN_MAGIC_SIZE];
+    const int binary = trace_read(file, magic, TRACE_BIN_MAGIC_SIZE) == TRACE_BIN_MAGIC_SIZE &&
+                       !memcmp(magic, TRACE_BIN_MAGIC, TRACE_BIN_MAGIC_SIZE);
+    trace_close(file);
+    return binary;
+}
+
+//=========================================================================
+int trace_bin_reader_open(trace_bin_reader_t *reader, const char *filename)
+{
+    M_REQUIRE_NON_NULL(reader);
+    M_REQUIRE_NON_NULL(filename);
+    memset(reader, 0, sizeof(*reader));
+    reader->buffer = malloc(TRACE_BIN_BUFFER_SIZE);
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(reader->buffer, ERR_MEM);
+    reader->file = trace_open(filename);
+    if (reader->file == NULL)
+    {
+        free(reader->buffer);
+        M_EXIT_ERR(ERR_IO, "cannot open %s", filename);
+    }
+
+    int err = ERR_NONE;
+    for (int i = 0; i < TRACE_BIN_MAGIC_SIZE && err == ERR_NONE; ++i)
+        if (next_byte(reader) != TRACE_BIN_MAGIC[i])
+            err = ERR_IO;
+    const int version = err == ERR_NONE ? next_byte(reader) : EOF;
+    if (version != 1 && version != TRACE_BIN_VERSION)
+        err = ERR_IO;
+    reader->version = version;
+    if (err != ERR_NONE)
+    {
+        trace_bin_reader_close(reader);
+        M_EXIT_ERR(err, "%s is not a binary trace of version 1 to %d", filename, TRACE_BIN_VERSION);
+    }
+    return ERR_NONE;
+}
+
+//=========================================================================
+int trace_bin_reader_next(trace_bin_reader_t *reader, command_t *command)
+{
+    M_REQUIRE_NON_NULL(reader);
+    M_REQUIRE_NON_NULL(command);
+    const int head = next_byte(reader);
+    if (head == EOF)
+        return trace_error(reader->file) ? ERR_IO : ERR_EOF;
+
+    const unsigned log2_size = ((unsigned)head >> HEAD_SIZE_SHIFT) & HEAD_SIZE_MASK;
+    M_REQUIRE(!(head & HEAD_RESERVED) && log2_size <= LOG2_SIZE_MAX, ERR_IO, "bad record head 0x%02x", head);
+    command->order = (head & HEAD_WRITE) ? WRITE : READ;
+    command->type = (head & HEAD_DATA) ? DATA : INSTRUCTION;
+    command->data_size = (size_t)1 << log2_size;
+    M_REQUIRE(command->type == DATA || (command->order == READ && command->data_size == sizeof(word_t)),
+              ERR_IO, "bad instruction record head 0x%02x", head);
+
+    M_REQUIRE(!(head & HEAD_PROCESS) || reader->version > 1, ERR_IO, "process change in a version %d trace", reader->version);
+    if (head & HEAD_PROCESS)
+    {
+        const int process = next_byte(reader);
+        M_REQUIRE(process != EOF && process < NB_ASIDS, ERR_IO, "bad process %d", process);
+        reader->process = (asid_t)process;
+    }
+    command->process = reader->process;
+
+    uint64_t delta = 0;
+    M_EXIT_IF_ERR(read_varint(reader, &delta), "reading an address");
+    const uint64_t vaddr = reader->last_vaddr[command->type] + unzigzag(delta);
+    reader->last_vaddr[command->type] = vaddr;
+    command->write_data = 0;
+    if (command->order == WRITE)
+    {
+        M_EXIT_IF_ERR(read_varint(reader, &command->write_data), "reading write data");
+        // as program_add_command() requires for a text trace
+        M_REQUIRE(command->data_size >= sizeof(uint64_t) || command->write_data >> (command->data_size * BITS_IN_BYTE) == 0,
+                  ERR_IO, "write data 0x%" PRIx64 " larger than %zu bytes", command->write_data, command->data_size);
+    }
+    M_REQUIRE(command_set_vaddr(command, vaddr) == ERR_NONE, ERR_IO, "bad virtual address 0x%" PRIx64, vaddr);
+    return ERR_NONE;
+}
+
+//=========================================================================
+int trace_bin_reader_close(trace_bin_reader_t *reader)
+{
+    M_REQUIRE_NON_NULL(reader);
+    if (reader->file != NULL)
+        trace_close(reader->file);
+    free(reader->buffer);
+    memset(reader, 0, sizeof(*reader));
+    return ERR_NONE;
+}
+
+//=========================================================================
+int trace_bin_writer_open(trace_bin_writer_t *writer, const char *filename)
+{
+    M_REQUIRE_NON_NULL(writer);
+    M_REQUIRE_NON_NULL(filename);
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(filename, "wb");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(writer->file, ERR_IO);
+    if (fwrite(TRACE_BIN_MAGIC, 1, TRACE_BIN_MAGIC_SIZE, writer->file) != TRACE_BIN_MAGIC_SIZE ||
+        fputc(TRACE_BIN_VERSION, writer->file) == EOF)
+    {
+        fclose(writer->file);
+        writer->file = NULL;
+        M_EXIT_ERR(ERR_IO, "cannot write the header of %s", filename);
+    }
+    return ERR_NONE;
+}
+
+//=========================================================================
+int trace_bin_write(trace_bin_writer_t *writer, const command_t *command)
+{
+    M_REQUIRE_NON_NULL(writer);
+    M_REQUIRE_NON_NULL(writer->file);
+    M_REQUIRE_NON_NULL(command);
+    M_REQUIRE(command->type == INSTRUCTION || command->type == DATA, ERR_BAD_PARAMETER, "unknown access type %d", command->type);
+
+    unsigned log2_size = 0;
+    while (log2_size <= LOG2_SIZE_MAX && ((size_t)1 << log2_size) != command->data_size)
+        ++log2_size;
+    M_REQUIRE(log2_size <= LOG2_SIZE_MAX, ERR_SIZE, "unsupported data size %zu", command->data_size);
+
+    M_REQUIRE(command->process < NB_ASIDS, ERR_BAD_PARAMETER, "process %u is not below %d", command->process, NB_ASIDS);
+
+    unsigned char record[2 + 2 * VARINT_MAX_BYTES];
+    record[0] = (unsigned char)((command->order == WRITE ? HEAD_WRITE : 0) |
+                                (command->type == DATA ? HEAD_DATA : 0) |
+                                (log2_size << HEAD_SIZE_SHIFT));
+    size_t n = 1;
+    if (command->process != writer->process)
+    { // the process is only written when it changes
+        record[0] |= HEAD_PROCESS;
+        record[n++] = command->process;
+        writer->process = command->process;
+    }
+    const uint64_t vaddr = command->vaddr64;
+    const uint64_t delta = vaddr - writer->last_vaddr[command->type]; // modulo 2^64
+    writer->last_vaddr[command->type] = vaddr;
+    n += write_varint(record + n, zigzag(delta));
+    if (command->order == WRITE)
+        n += write_varint(record + n, command->write_data);
+
+    M_REQUIRE(fwrite(record, 1, n, writer->file) == n, ERR_IO, "cannot write a record of %zu bytes", n);
+    return ERR_NONE;
+}
+
+//=========================================================================
+int trace_bin_writer_close(trace_bin_writer_t *writer)
+{
+    M_REQUIRE_NON_NULL(writer);
+    M_REQUIRE_NON_NULL(writer->file);
+    const int err = fclose(writer->file) == 0 ? ERR_NONE : ERR_IO;
+    writer->file = NULL;
+    return err;
+}
+
+//=========================================================================
+int program_read_any(const char *filename, program_t *program)
+{
+    M_REQUIRE_NON_NULL(filename);
+    M_REQUIRE_NON_NULL(program);
+    if (!trace_bin_is_binary(filename))
+        return program_read(filename, program);
+
+    trace_bin_reader_t reader;
+    M_EXIT_IF_ERR(trace_bin_reader_open(&reader, filename), "opening the binary trace");
+    int err = program_init(program);
+    command_t command;
+    while (err == ERR_NONE && (err = trace_bin_reader_next(&reader, &command)) == ERR_NONE)
+        err = program_add_command(program, &command);
+    trace_bin_reader_close(&reader);
+    if (err == ERR_EOF)
+        err = program_shrink(program);
+    if (err != ERR_NONE)
+        program_free(program);
+    return err;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ * @file trace_bin.h
+ * @brief compact binary trace format, and its streaming reader and writer
+ *
+ * A binary trace starts with the 8 bytes TRACE_BIN_MAGIC and one version
+ * byte, followed by one record per command:
+ *  - a head byte: bit 0 is the order (1 for WRITE), bit 1 the type (1 for
+ *    DATA), bits 2 to 4 the log2 of the data size, bit 5 (version 2) set
+ *    when the process changes; the other bits are 0;
+ *  - if the process changes, one byte with the process issuing this command
+ *    and the following ones (0 at the start of the trace);
+ *  - the difference between the virtual address and the one of the previous
+ *    command of the same type, zigzag-encoded as a LEB128 varint;
+ *  - for writes only, write_data as a LEB128 varint.
+ * Traces made of repeated pages with small offsets thus take 2 or 3 bytes
+ * per command instead of about 25 in the text format.
+ *
+ * @date 2019
+ */
+
+#include "commands.h"
+#include "trace_io.h"
+
+#include <stdio.h>   // for FILE
+#include <stddef.h>  // for size_t
+#include <stdint.h>
+
+#define TRACE_BIN_MAGIC "PPSTRACE"
+#define TRACE_BIN_MAGIC_SIZE 8
+#define TRACE_BIN_VERSION 2 // version 1 traces, with no process, are read as well
+#define TRACE_BIN_BUFFER_SIZE (1 << 16) // bytes read from the file at once
+#define TRACE_BIN_NB_TYPES 2 // INSTRUCTION and DATA, whose addresses are delta-encoded separately
+
+/**
+ * @brief a streaming binary trace reader
+ */
+typedef struct
+{
+    trace_file_t file;
+    unsigned char *buffer;  // TRACE_BIN_BUFFER_SIZE bytes
+    size_t pos;             // next byte to decode in buffer
+    size_t len;             // number of valid bytes in buffer
+    uint64_t last_vaddr[TRACE_BIN_NB_TYPES];
+    asid_t process;         // process of the last command
+    int version;            // version of the trace, from its header
+} trace_bin_reader_t;
+
+/**
+ * @brief a binary trace writer
+ */
+typedef struct
+{
+    FILE *file;
+    uint64_t last_vaddr[TRACE_BIN_NB_TYPES];
+    asid_t process; // process of the last command
+} trace_bin_writer_t;
+
+//=========================================================================
+/**
+ * @brief Tell whether a file is a binary trace (i.e. starts with TRACE_BIN_MAGIC).
+ *        Compressed files are looked into as described in trace_io.h.
+ *
+ * @param filename the file
+ * @return 1 if it is a binary trace, 0 otherwise (including when it cannot be read)
+ */
+int trace_bin_is_binary(const char *filename);
+
+//=========================================================================
+/**
+ * @brief Open a binary trace and check its header.
+ *
+ * @param reader (modified) the reader to initialize
+ * @param filename the binary trace
+ * @return error code (ERR_IO if the file cannot be read or is not a binary trace)
+ */
+int trace_bin_reader_open(trace_bin_reader_t *reader, const char *filename);
+
+//=========================================================================
+/**
+ * @brief Decode the next command of a binary trace.
+ *
+ * @param reader the reader
+ * @param command (modified) the command decoded
+ * @return error code, ERR_EOF when there is no more command
+ *         (ERR_IO on a truncated or corrupted trace)
+ */
+int trace_bin_reader_next(trace_bin_reader_t *reader, command_t *command);
+
+//=========================================================================
+/**
+ * @brief Close a binary trace reader.
+ *
+ * @param reader the reader
+ * @return error code
+ */
+int trace_bin_reader_close(trace_bin_reader_t *reader);
+
+//=========================================================================
+/**
+ * @brief Create a binary trace and write its header.
+ *
+ * @param writer (modified) the writer to initialize
+ * @param filename the binary trace to create
+ * @return error code
+ */
+int trace_bin_writer_open(trace_bin_writer_t *writer, const char *filename);
+
+//=========================================================================
+/**
+ * @brief Append a command to a binary trace.
+ *
+ * @param writer the writer
+ * @param command the command to encode
+ * @return error code
+ */
+int trace_bin_write(trace_bin_writer_t *writer, const command_t *command);
+
+//=========================================================================
+/**
+ * @brief Close a binary trace writer, flushing what remains to be written.
+ *
+ * @param writer the writer
+ * @return error code (ERR_IO if the trace could not be fully written)
+ */
+int trace_bin_writer_close(trace_bin_writer_t *writer);
+
+//=========================================================================
+/**
+ * @brief Read a whole trace, binary or text (see program_read()), into a program.
+ *
+ * @param filename the trace
+ * @param program (modified) the program read
+ * @return error code
+ */
+int program_read_any(const char *filename, program_t *program);
@@ -0,0 +1,405 @@
+/**
+ * @file trace_gen.c
+ * @brief synthetic trace generator
+ *
+ * @date 2019
+ */
+#include "trace_gen.h"
+#include "commands.h"
+#include "addr.h"
+#include "addr_mng.h"
+#include "error.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h> // for pow()
+
+#define LINE_BYTES 16
+#define WORD_BYTES 4
+#define ENTRY_BITS 9            // bits of virtual address per page table level
+#define MAX_FILENAME 100        // as accepted by mem_init_from_description()
+#define MAX_PHY_SIZE (1ULL << PHY_ADDR)
+#define JUMP_ONE_IN 8           // GEN_MIX: one instruction fetch in 8 is a jump
+
+const char *const GEN_PATTERN_NAMES[NB_GEN_PATTERNS] = {
+    "sequential", "stride", "random", "chase", "zipf", "mix"};
+
+int gen_config_init(gen_config_t *config, gen_pattern_t pattern)
+{
+    M_REQUIRE_NON_NULL(config);
+    M_REQUIRE(pattern < NB_GEN_PATTERNS, ERR_BAD_PARAMETER, "unknown pattern %d", pattern);
+    zero_init_ptr(config);
+    config->pattern = pattern;
+    config->base = 0x8000000000ULL;
+    config->nb_pages = 16;
+    config->nb_commands = 1000;
+    config->data_size = DATA_SIZE_WORD;
+    config->stride = PAGE_SIZE + LINE_BYTES;
+    config->zipf_s = 0.99;
+    config->write_percent = 25;
+    config->instr_percent = 50;
+    config->seed = 0x5eed2019ULL;
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief xorshift64* pseudo-random generator: fast, and the same on every box
+ */
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+#define region_size(C) ((uint64_t)(C)->nb_pages * PAGE_SIZE)
+
+//=========================================================================
+/**
+ * @brief Tool function to check a configuration.
+ */
+static int check_config(const gen_config_t *config)
+{
+    M_REQUIRE_NON_NULL(config);
+    M_REQUIRE(config->pattern < NB_GEN_PATTERNS, ERR_BAD_PARAMETER, "unknown pattern %d", config->pattern);
+    M_REQUIRE(config->base % PAGE_SIZE == 0, ERR_ADDR, "region base 0x%" PRIx64 " is not page aligned", config->base);
+    M_REQUIRE(config->nb_pages > 0 && region_size(config) / LINE_BYTES <= UINT32_MAX, ERR_SIZE,
+              "unsupported number of pages %zu", config->nb_pages);
+    virt_addr_t last;
+    M_EXIT_IF_ERR(init_virt_addr64(&last, config->base + region_size(config) - 1), "checking the end of the region");
+    M_REQUIRE(config->data_size > 0 && config->data_size <= DATA_SIZE_MAX && (config->data_size & (config->data_size - 1)) == 0,
+              ERR_SIZE, "unsupported data size %zu", config->data_size);
+    M_REQUIRE(config->stride > 0, ERR_BAD_PARAMETER, "null %s", "stride");
+    M_REQUIRE(config->write_percent <= 100 && config->instr_percent <= 100, ERR_BAD_PARAMETER,
+              "percentages must be at most %d", 100);
+    M_REQUIRE(config->zipf_s > 0.0, ERR_BAD_PARAMETER, "Zipf exponent must be %s", "positive");
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to draw an index in [0, n[ (n > 0).
+ */
+static inline uint64_t draw(gen_t *gen, uint64_t n)
+{
+    return next_random(&gen->random) % n;
+}
+
+int gen_init(gen_t *gen, const gen_config_t *config)
+{
+    M_REQUIRE_NON_NULL(gen);
+    M_EXIT_IF_ERR(check_config(config), "checking the configuration");
+    zero_init_ptr(gen);
+    gen->config = *config;
+    gen->random = config->seed == 0 ? 1 : config->seed; // xorshift never leaves 0
+    const uint32_t nb_lines = (uint32_t)(region_size(config) / LINE_BYTES);
+
+    if (config->pattern == GEN_POINTER_CHASE)
+    { // Sattolo's shuffle: a random permutation made of a single cycle through all lines
+        gen->next_line = calloc(nb_lines, sizeof(uint32_t));
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(gen->next_line, ERR_MEM);
+        for (uint32_t i = 0; i < nb_lines; ++i)
+            gen->next_line[i] = i;
+        for (uint32_t i = nb_lines - 1; i > 0; --i)
+        {
+            const uint32_t j = (uint32_t)draw(gen, i);
+            const uint32_t tmp = gen->next_line[i];
+            gen->next_line[i] = gen->next_line[j];
+            gen->next_line[j] = tmp;
+        }
+    }
+    else if (config->pattern == GEN_ZIPF)
+    { // ranks are drawn in the cumulative distribution, then mapped to shuffled lines
+        gen->zipf_cdf = calloc(nb_lines, sizeof(double));
+        gen->zipf_lines = calloc(nb_lines, sizeof(uint32_t));
+        if (gen->zipf_cdf == NULL || gen->zipf_lines == NULL)
+        {
+            gen_free(gen);
+            return ERR_MEM;
+        }
+        double sum = 0.0;
+        for (uint32_t k = 0; k < nb_lines; ++k)
+        {
+            sum += 1.0 / pow((double)k + 1.0, config->zipf_s);
+            gen->zipf_cdf[k] = sum;
+            gen->zipf_lines[k] = k;
+        }
+        for (uint32_t k = nb_lines - 1; k > 0; --k) // Fisher-Yates shuffle
+        {
+            const uint32_t j = (uint32_t)draw(gen, (uint64_t)k + 1);
+            const uint32_t tmp = gen->zipf_lines[k];
+            gen->zipf_lines[k] = gen->zipf_lines[j];
+            gen->zipf_lines[j] = tmp;
+        }
+    }
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to draw a Zipf-distributed line.
+ */
+static uint32_t zipf_line(gen_t *gen)
+{
+    const uint32_t nb_lines = (uint32_t)(region_size(&gen->config) / LINE_BYTES);
+    const double u = (double)(next_random(&gen->random) >> 11) / (double)(1ULL << 53) * gen->zipf_cdf[nb_lines - 1];
+    uint32_t lo = 0, hi = nb_lines - 1;
+    while (lo < hi)
+    {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (gen->zipf_cdf[mid] < u)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return gen->zipf_lines[lo];
+}
+
+int gen_next(gen_t *gen, command_t *command)
+{
+    M_REQUIRE_NON_NULL(gen);
+    M_REQUIRE_NON_NULL(command);
+    const gen_config_t *config = &gen->config;
+    if (gen->count >= config->nb_commands)
+        return ERR_EOF;
+
+    const uint64_t size = region_size(config);
+    const size_t ds = config->data_size;
+    zero_init_ptr(command);
+    command->order = READ;
+    command->type = DATA;
+    command->data_size = ds;
+    uint64_t offset = 0;
+    switch (config->pattern)
+    {
+    case GEN_SEQUENTIAL:
+        offset = gen->cursor;
+        gen->cursor = (gen->cursor + ds) % size;
+        break;
+    case GEN_STRIDE:
+        offset = gen->cursor - gen->cursor % ds;
+        gen->cursor = (gen->cursor + config->stride) % size;
+        break;
+    case GEN_RANDOM:
+        offset = draw(gen, size / ds) * ds;
+        break;
+    case GEN_POINTER_CHASE:
+        command->data_size = DATA_SIZE_DOUBLE;
+        offset = gen->cursor * LINE_BYTES;
+        gen->cursor = gen->next_line[gen->cursor];
+        break;
+    case GEN_ZIPF:
+        offset = (uint64_t)zipf_line(gen) * LINE_BYTES + draw(gen, LINE_BYTES / ds) * ds;
+        break;
+    case GEN_MIX:
+    {
+        const size_t code_pages = config->nb_pages / 4 > 0 ? config->nb_pages / 4 : 1;
+        const uint64_t code_size = (uint64_t)code_pages * PAGE_SIZE;
+        if (draw(gen, 100) < config->instr_percent)
+        {
+            command->type = INSTRUCTION;
+            command->data_size = WORD_BYTES;
+            offset = gen->cursor;
+            gen->cursor = draw(gen, JUMP_ONE_IN) == 0 ? draw(gen, code_size / WORD_BYTES) * WORD_BYTES
+                                                      : (gen->cursor + WORD_BYTES) % code_size;
+        }
+        else
+        {
+            const uint64_t data_start = config->nb_pages > 1 ? code_size : 0;
+            offset = data_start + draw(gen, (size - data_start) / ds) * ds;
+        }
+        break;
+    }
+    default:
+        M_EXIT(ERR_BAD_PARAMETER, "unknown pattern %d", config->pattern);
+    }
+
+    if (command->type == DATA && config->pattern != GEN_POINTER_CHASE && draw(gen, 100) < config->write_percent)
+    {
+        command->order = WRITE;
+        command->write_data = next_random(&gen->random);
+        if (ds < sizeof(uint64_t))
+            command->write_data &= (UINT64_C(1) << (ds * 8)) - 1;
+    }
+    M_EXIT_IF_ERR(command_set_vaddr(command, config->base + offset), "building the address");
+    ++gen->count;
+    return ERR_NONE;
+}
+
+int gen_free(gen_t *gen)
+{
+    M_REQUIRE_NON_NULL(gen);
+    free(gen->next_line);
+    free(gen->zipf_cdf);
+    free(gen->zipf_lines);
+    gen->next_line = NULL;
+    gen->zipf_cdf = NULL;
+    gen->zipf_lines = NULL;
+    return ERR_NONE;
+}
+
+int gen_program(const gen_config_t *config, program_t *program)
+{
+    M_REQUIRE_NON_NULL(program);
+    gen_t gen;
+    M_EXIT_IF_ERR(gen_init(&gen, config), "initialising the generator");
+    int err = program_init(program);
+    command_t command;
+    while (err == ERR_NONE && (err = gen_next(&gen, &command)) == ERR_NONE)
+        err = program_add_command(program, &command);
+    gen_free(&gen);
+    if (err != ERR_EOF)
+    {
+        if (program->listing != NULL)
+            program_free(program);
+        return err;
+    }
+    return program_shrink(program);
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to write one page to a file.
+ */
+static int write_page(const char *filename, const byte_t *page)
+{
+    FILE *file = fopen(filename, "wb");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(file, ERR_IO);
+    const size_t written = fwrite(page, PAGE_SIZE, 1, file);
+    M_REQUIRE(fclose(file) == 0 && written == 1, ERR_IO, "cannot write %s", filename);
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to write the description and page files of a memory image:
+ *        page 0 is the PGD, pages 1 to nb_tables are the other page tables,
+ *        the data pages follow.
+ */
+static int write_description(const gen_config_t *config, const char *prefix, const byte_t *image, size_t nb_tables)
+{
+    char filename[MAX_FILENAME];
+    M_REQUIRE(snprintf(filename, sizeof(filename), "%s-p%zu.bin", prefix, config->nb_pages) < (int)sizeof(filename),
+              ERR_BAD_PARAMETER, "prefix %s is too long", prefix);
+    snprintf(filename, sizeof(filename), "%s-desc.txt", prefix);
+    FILE *desc = fopen(filename, "w");
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(desc, ERR_IO);
+
+    int err = ERR_NONE;
+    fprintf(desc, "%zu\n", (1 + nb_tables + config->nb_pages) * PAGE_SIZE);
+    snprintf(filename, sizeof(filename), "%s-pgd.bin", prefix);
+    fprintf(desc, "%s\n%zu\n", filename, nb_tables);
+    err = write_page(filename, image);
+    for (size_t t = 1; err == ERR_NONE && t <= nb_tables; ++t)
+    {
+        snprintf(filename, sizeof(filename), "%s-t%zu.bin", prefix, t);
+        fprintf(desc, "0x%08zX %s\n", t * PAGE_SIZE, filename);
+        err = write_page(filename, image + t * PAGE_SIZE);
+    }
+    for (size_t p = 0; err == ERR_NONE && p < config->nb_pages; ++p)
+    {
+        snprintf(filename, sizeof(filename), "%s-p%zu.bin", prefix, p);
+        fprintf(desc, "0x%016" PRIX64 " %s\n", config->base + (uint64_t)p * PAGE_SIZE, filename);
+        err = write_page(filename, image + (1 + nb_tables + p) * PAGE_SIZE);
+    }
+    if (fclose(desc) != 0 && err == ERR_NONE)
+        err = ERR_IO;
+    return err;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to get (allocating it if needed) the table an entry points to.
+ */
+static pte_t next_table(byte_t *image, pte_t table, uint16_t index, size_t *nb_used)
+{
+    pte_t *entry = (pte_t *)(image + table) + index;
+    if (*entry == 0) // page 0 is the PGD: no other table can point to it
+        *entry = (pte_t)((*nb_used)++ * PAGE_SIZE);
+    return *entry;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to count the page tables of a region but its PGD: the
+ *        pages being consecutive, counting the distinct PTE, PMD and PUD tables is enough.
+ */
+static size_t nb_tables_of(const gen_config_t *config)
+{
+    const uint64_t first_vpn = config->base >> PAGE_OFFSET;
+    const uint64_t last_vpn = first_vpn + config->nb_pages - 1;
+    size_t nb_tables = 0;
+    for (int level = 1; level <= 3; ++level)
+        nb_tables += (size_t)((last_vpn >> (level * ENTRY_BITS)) - (first_vpn >> (level * ENTRY_BITS)) + 1);
+    return nb_tables;
+}
+
+int gen_build_memory(const gen_config_t *config, void **mem_space, size_t *mem_size)
+{
+    M_REQUIRE_NON_NULL(mem_space);
+    M_REQUIRE_NON_NULL(mem_size);
+    M_EXIT_IF_ERR(check_config(config), "checking the configuration");
+
+    const size_t nb_tables = nb_tables_of(config);
+    const uint64_t size = (1 + nb_tables + config->nb_pages) * (uint64_t)PAGE_SIZE;
+    M_REQUIRE(size <= MAX_PHY_SIZE, ERR_SIZE, "memory of %" PRIu64 " bytes does not fit physical addresses", size);
+
+    byte_t *image = calloc(size, 1);
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(image, ERR_MEM);
+    size_t nb_used = 1;
+    for (size_t p = 0; p < config->nb_pages; ++p)
+    {
+        const uint64_t page_vaddr = config->base + (uint64_t)p * PAGE_SIZE;
+        virt_addr_t vaddr;
+        (void)init_virt_addr64(&vaddr, page_vaddr); // the whole region was checked
+        const pte_t pud = next_table(image, 0, vaddr.pgd_entry, &nb_used);
+        const pte_t pmd = next_table(image, pud, vaddr.pud_entry, &nb_used);
+        const pte_t pte = next_table(image, pmd, vaddr.pmd_entry, &nb_used);
+        const size_t data_page = 1 + nb_tables + p;
+        ((pte_t *)(image + pte))[vaddr.pte_entry] = (pte_t)(data_page * PAGE_SIZE);
+
+        uint32_t *words = (uint32_t *)(image + data_page * PAGE_SIZE);
+        for (size_t w = 0; w < PAGE_SIZE / WORD_BYTES; ++w)
+            words[w] = (uint32_t)(page_vaddr + w * WORD_BYTES);
+    }
+
+    int err = ERR_NONE;
+    if (config->pattern == GEN_POINTER_CHASE)
+    { // first doubleword of each line: the address of the next line of the chase
+        gen_t gen;
+        err = gen_init(&gen, config);
+        const uint64_t nb_lines = region_size(config) / LINE_BYTES;
+        byte_t *data = image + (1 + nb_tables) * PAGE_SIZE;
+        for (uint64_t l = 0; err == ERR_NONE && l < nb_lines; ++l)
+        {
+            const uint64_t next = config->base + (uint64_t)gen.next_line[l] * LINE_BYTES;
+            memcpy(data + l * LINE_BYTES, &next, sizeof(next)); // memory is little endian, as the host
+        }
+        if (err == ERR_NONE)
+            gen_free(&gen);
+    }
+    if (err != ERR_NONE)
+    {
+        free(image);
+        return err;
+    }
+    *mem_space = image;
+    *mem_size = (size_t)size;
+    return ERR_NONE;
+}
+
+int gen_write_memory(const gen_config_t *config, const char *prefix)
+{
+    M_REQUIRE_NON_NULL(prefix);
+    void *image = NULL;
+    size_t mem_size = 0;
+    M_EXIT_IF_ERR(gen_build_memory(config, &image, &mem_size), "building the memory");
+    const int err = write_description(config, prefix, image, nb_tables_of(config));
+    free(image);
+    return err;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+/**
+ * @file trace_gen.h
+ * @brief synthetic trace generator: parameterised streams of commands over a
+ *        virtual region, and the matching memory description
+ *
+ * All patterns cover a region of nb_pages consecutive virtual pages starting
+ * at base. gen_write_memory() writes a memory description (and its page
+ * files) that mem_init_from_description() can load and in which the whole
+ * region is mapped, so that any generated program runs on it.
+ *
+ * In the generated memory, every word holds the 32 lsb of its own virtual
+ * address, except for GEN_POINTER_CHASE where the first doubleword of each
+ * cache line holds the virtual address of the next line of the chase.
+ *
+ * The same configuration (seed included) always gives the same commands
+ * and the same memory.
+ *
+ * @date 2019
+ */
+
+#include "commands.h"
+
+#include <stdint.h>
+#include <stddef.h> // for size_t
+
+/**
+ * @brief access patterns
+ */
+typedef enum
+{
+    GEN_SEQUENTIAL,    // consecutive data accesses, wrapping around the region
+    GEN_STRIDE,        // data accesses stride bytes apart, wrapping around the region
+    GEN_RANDOM,        // uniformly distributed data accesses
+    GEN_POINTER_CHASE, // doubleword reads following the pointers stored in memory (one random cycle over all lines)
+    GEN_ZIPF,          // Zipf-distributed cache lines, the hot ones scattered over the region
+    GEN_MIX,           // instruction fetches in the first quarter of the region, random data accesses in the rest
+    NB_GEN_PATTERNS
+} gen_pattern_t;
+
+extern const char *const GEN_PATTERN_NAMES[NB_GEN_PATTERNS];
+
+/**
+ * @brief parameters of a generator
+ */
+typedef struct
+{
+    gen_pattern_t pattern;
+    uint64_t base;          // first virtual address of the region, page aligned
+    size_t nb_pages;        // number of pages of the region
+    size_t nb_commands;     // number of commands to generate
+    size_t data_size;       // bytes per data access (1, 2, 4, 8 or 16); accesses are aligned on it
+    size_t stride;          // GEN_STRIDE: distance between two accesses, in bytes
+    double zipf_s;          // GEN_ZIPF: exponent of the distribution
+    unsigned write_percent; // share of data accesses that are writes (not for GEN_POINTER_CHASE)
+    unsigned instr_percent; // GEN_MIX: share of instruction fetches
+    uint64_t seed;
+} gen_config_t;
+
+/**
+ * @brief state of a generator
+ */
+typedef struct
+{
+    gen_config_t config;
+    uint64_t random;      // state of the pseudo-random generator
+    size_t count;         // number of commands generated so far
+    uint64_t cursor;      // offset (or line, for GEN_POINTER_CHASE) of the next sequential access
+    uint32_t *next_line;  // GEN_POINTER_CHASE: the line following each line
+    double *zipf_cdf;     // GEN_ZIPF: cumulative distribution of the ranks
+    uint32_t *zipf_lines; // GEN_ZIPF: the line of each rank
+} gen_t;
+
+//=========================================================================
+/**
+ * @brief Set a configuration to the defaults of a pattern: 16 pages at
+ *        0x8000000000, 1000 commands of words, stride of a page plus a line,
+ *        s = 0.99, 25% writes, 50% instructions, fixed seed.
+ * @param config (modified) the configuration
+ * @param pattern the access pattern
+ * @return error code
+ */
+int gen_config_init(gen_config_t *config, gen_pattern_t pattern);
+
+//=========================================================================
+/**
+ * @brief "Constructor" for gen_t.
+ * @param gen (modified) the generator to initialize
+ * @param config its parameters
+ * @return error code
+ */
+int gen_init(gen_t *gen, const gen_config_t *config);
+
+//=========================================================================
+/**
+ * @brief Generate the next command.
+ * @param gen the generator
+ * @param command (modified) the generated command
+ * @return error code, ERR_EOF once nb_commands commands have been generated
+ */
+int gen_next(gen_t *gen, command_t *command);
+
+//=========================================================================
+/**
+ * @brief "Destructor" for gen_t.
+ * @param gen the generator
+ * @return error code
+ */
+int gen_free(gen_t *gen);
+
+//=========================================================================
+/**
+ * @brief Generate a whole program.
+ * @param config the parameters of the generator
+ * @param program (modified) the program, to be freed with program_free()
+ * @return error code
+ */
+int gen_program(const gen_config_t *config, program_t *program);
+
+//=========================================================================
+/**
+ * @brief Build the memory matching a configuration, as a memory image.
+ *
+ * Page 0 is the PGD, the other page tables follow, then the pages of the
+ * region in order.
+ *
+ * @param config the parameters of the generator
+ * @param mem_space (modified) the memory, to be freed with free()
+ * @param mem_size (modified) its size, in bytes
+ * @return error code
+ */
+int gen_build_memory(const gen_config_t *config, void **mem_space, size_t *mem_size);
+
+//=========================================================================
+/**
+ * @brief Write the memory matching a configuration as a memory description
+ *        "<prefix>-desc.txt" and its page files "<prefix>-*.bin".
+ *
+ * The paths written in the description are the ones of the page files, so
+ * the description must be loaded from the same working directory.
+ *
+ * @param config the parameters of the generator
+ * @param prefix prefix of the files to write
+ * @return error code
+ */
+int gen_write_memory(const gen_config_t *config, const char *prefix);
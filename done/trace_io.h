@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+ * @file trace_io.h
+ * @brief reading of trace files; when built with WITH_ZLIB (make WITH_ZLIB=1),
+ *        gzip-compressed files are decompressed on the fly, while plain files
+ *        are still read as they are
+ *
+ * @date 2019
+ */
+
+#include <stdio.h>
+#include <stddef.h> // for size_t
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+
+typedef gzFile trace_file_t;
+
+static inline trace_file_t trace_open(const char *filename)
+{
+    return gzopen(filename, "rb");
+}
+
+// number of bytes read, 0 at the end of the file or on error
+static inline size_t trace_read(trace_file_t file, void *buffer, size_t size)
+{
+    const int n = gzread(file, buffer, (unsigned)size);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+static inline int trace_getc(trace_file_t file)
+{
+    return gzgetc(file);
+}
+
+// non-zero if an error (truncated or corrupted compressed data included) was met
+static inline int trace_error(trace_file_t file)
+{
+    int errnum = Z_OK;
+    (void)gzerror(file, &errnum);
+    return errnum != Z_OK;
+}
+
+static inline void trace_close(trace_file_t file)
+{
+    gzclose(file);
+}
+
+#else
+
+typedef FILE *trace_file_t;
+
+static inline trace_file_t trace_open(const char *filename)
+{
+    return fopen(filename, "rb");
+}
+
+static inline size_t trace_read(trace_file_t file, void *buffer, size_t size)
+{
+    return fread(buffer, 1, size, file);
+}
+
+static inline int trace_getc(trace_file_t file)
+{
+    return getc(file);
+}
+
+static inline int trace_error(trace_file_t file)
+{
+    return ferror(file);
+}
+
+static inline void trace_close(trace_file_t file)
+{
+    fclose(file);
+}
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * @file trace_reader.c
+ * @brief parallel reading of text traces
+ *
+ * Each worker, in turn and under the lock, takes the next free slot and
+ * reads the next chunk of the file into it (reading is sequential anyway);
+ * it then parses the chunk without the lock. The consumer takes the chunks
+ * in order and frees their slots, which lets the workers go on.
+ *
+ * @date 2019
+ */
+#define _POSIX_C_SOURCE 200809L // for pthreads
+
+#include "trace_reader.h"
+#include "commands.h"
+#include "error.h"
+#include "util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//=========================================================================
+/**
+ * @brief Tool function to read the next chunk of the file into a slot,
+ *        extended up to the next newline. Called with the lock held.
+ * @return error code
+ */
+static int read_chunk(trace_reader_t *reader, trace_slot_t *slot)
+{
+    if (slot->capacity < reader->chunk_size)
+    {
+        char *text = realloc(slot->text, reader->chunk_size);
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(text, ERR_MEM);
+        slot->text = text;
+        slot->capacity = reader->chunk_size;
+    }
+    slot->length = trace_read(reader->file, slot->text, reader->chunk_size);
+    if (slot->length < reader->chunk_size)
+    {
+        reader->eof = 1;
+        return trace_error(reader->file) ? ERR_IO : ERR_NONE;
+    }
+    int c;
+    while ((c = trace_getc(reader->file)) != EOF)
+    {
+        if (slot->length == slot->capacity)
+        {
+            char *text = realloc(slot->text, 2 * slot->capacity);
+            M_REQUIRE_NON_NULL_CUSTOM_ERR(text, ERR_MEM);
+            slot->text = text;
+            slot->capacity *= 2;
+        }
+        slot->text[slot->length++] = (char)c;
+        if (c == '\n')
+            return ERR_NONE;
+    }
+    reader->eof = 1;
+    return trace_error(reader->file) ? ERR_IO : ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Body of the worker threads.
+ */
+static void *worker(void *arg)
+{
+    trace_reader_t *reader = arg;
+    pthread_mutex_lock(&reader->lock);
+    for (;;)
+    {
+        trace_slot_t *slot = &reader->slots[reader->next_read % reader->queue_length];
+        while (!reader->closing && !reader->eof && slot->state != SLOT_FREE)
+        {
+            pthread_cond_wait(&reader->changed, &reader->lock);
+            slot = &reader->slots[reader->next_read % reader->queue_length];
+        }
+        if (reader->closing || reader->eof)
+            break;
+
+        slot->state = SLOT_PARSING;
+        slot->seq = reader->next_read++;
+        slot->err = read_chunk(reader, slot);
+        if (slot->err != ERR_NONE)
+            reader->eof = 1; // nothing sensible can be read after an error
+        pthread_mutex_unlock(&reader->lock);
+
+        if (slot->err == ERR_NONE)
+            slot->err = program_parse(slot->text, slot->length, &slot->program);
+
+        pthread_mutex_lock(&reader->lock);
+        slot->state = SLOT_READY;
+        pthread_cond_broadcast(&reader->changed);
+    }
+    pthread_cond_broadcast(&reader->changed); // the consumer may be waiting for the end
+    pthread_mutex_unlock(&reader->lock);
+    return NULL;
+}
+
+int trace_reader_open(trace_reader_t *reader, const char *filename,
+                      size_t nb_threads, size_t chunk_size, size_t queue_length)
+{
+    M_REQUIRE_NON_NULL(reader);
+    M_REQUIRE_NON_NULL(filename);
+    M_REQUIRE(nb_threads > 0, ERR_BAD_PARAMETER, "needs at least %d thread", 1);
+    zero_init_ptr(reader);
+    reader->chunk_size = chunk_size == 0 ? TRACE_CHUNK_SIZE : chunk_size;
+    reader->queue_length = queue_length == 0 ? TRACE_QUEUE_LENGTH : queue_length;
+
+    reader->file = trace_open(filename);
+    M_REQUIRE_NON_NULL_CUSTOM_ERR(reader->file, ERR_IO);
+    reader->slots = calloc(reader->queue_length, sizeof(trace_slot_t));
+    reader->threads = calloc(nb_threads, sizeof(pthread_t));
+    if (reader->slots == NULL || reader->threads == NULL)
+    {
+        free(reader->slots);
+        free(reader->threads);
+        trace_close(reader->file);
+        return ERR_MEM;
+    }
+    pthread_mutex_init(&reader->lock, NULL);
+    pthread_cond_init(&reader->changed, NULL);
+    for (; reader->nb_threads < nb_threads; ++reader->nb_threads)
+    {
+        if (pthread_create(&reader->threads[reader->nb_threads], NULL, worker, reader) != 0)
+        {
+            trace_reader_close(reader);
+            return ERR_MEM;
+        }
+    }
+    return ERR_NONE;
+}
+
+int trace_reader_next(trace_reader_t *reader, program_t *chunk)
+{
+    M_REQUIRE_NON_NULL(reader);
+    M_REQUIRE_NON_NULL(chunk);
+    pthread_mutex_lock(&reader->lock);
+    trace_slot_t *slot = &reader->slots[reader->next_out % reader->queue_length];
+    while (slot->state != SLOT_READY || slot->seq != reader->next_out)
+    {
+        if (reader->eof && reader->next_out == reader->next_read)
+        {
+            pthread_mutex_unlock(&reader->lock);
+            return ERR_EOF;
+        }
+        pthread_cond_wait(&reader->changed, &reader->lock);
+    }
+    *chunk = slot->program;
+    const int err = slot->err;
+    zero_init_var(slot->program);
+    slot->state = SLOT_FREE;
+    ++reader->next_out;
+    pthread_cond_broadcast(&reader->changed);
+    pthread_mutex_unlock(&reader->lock);
+    return err;
+}
+
+int trace_reader_close(trace_reader_t *reader)
+{
+    M_REQUIRE_NON_NULL(reader);
+    pthread_mutex_lock(&reader->lock);
+    reader->closing = 1;
+    pthread_cond_broadcast(&reader->changed);
+    pthread_mutex_unlock(&reader->lock);
+    for (size_t i = 0; i < reader->nb_threads; ++i)
+        pthread_join(reader->threads[i], NULL);
+
+    for (size_t i = 0; i < reader->queue_length; ++i)
+    {
+        free(reader->slots[i].text);
+        if (reader->slots[i].program.listing != NULL)
+            program_free(&reader->slots[i].program);
+    }
+    free(reader->slots);
+    free(reader->threads);
+    pthread_mutex_destroy(&reader->lock);
+    pthread_cond_destroy(&reader->changed);
+    trace_close(reader->file);
+    zero_init_ptr(reader);
+    return ERR_NONE;
+}
+
+//=========================================================================
+/**
+ * @brief Tool function to append the commands of a chunk to a program.
+ */
+static int program_append(program_t *program, const program_t *chunk)
+{
+    const size_t needed = (program->nb_lines + chunk->nb_lines) * sizeof(command_t);
+    if (needed > program->allocated)
+    {
+        const size_t allocated = needed > 2 * program->allocated ? needed : 2 * program->allocated;
+        command_t *listing = realloc(program->listing, allocated);
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(listing, ERR_MEM);
+        program->listing = listing;
+        program->allocated = allocated;
+    }
+    if (chunk->nb_lines > 0)
+        memcpy(program->listing + program->nb_lines, chunk->listing, chunk->nb_lines * sizeof(command_t));
+    program->nb_lines += chunk->nb_lines;
+    return ERR_NONE;
+}
+
+int program_read_parallel(const char *filename, program_t *program, size_t nb_threads)
+{
+    M_REQUIRE_NON_NULL(program);
+    trace_reader_t reader;
+    M_EXIT_IF_ERR(trace_reader_open(&reader, filename, nb_threads, 0, 0), "opening the trace");
+    int err = program_init(program);
+    program_t chunk;
+    while (err == ERR_NONE && (err = trace_reader_next(&reader, &chunk)) == ERR_NONE)
+    {
+        err = program_append(program, &chunk);
+        program_free(&chunk);
+    }
+    trace_reader_close(&reader);
+    if (err != ERR_EOF)
+    {
+        if (program->listing != NULL)
+            program_free(program);
+        return err;
+    }
+    return program_shrink(program);
+}
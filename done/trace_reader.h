@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * @file trace_reader.h
+ * @brief parallel reading of text traces: the file is cut into chunks ending
+ *        at a newline, parsed by worker threads, and handed back in order
+ *
+ * At most queue_length chunks are in flight (being read, parsed, or parsed
+ * and waiting for the consumer), which bounds the memory used whatever the
+ * size of the trace. Since chunks end at a newline, a command shall not be
+ * split over several lines (a trace written by program_print() never is).
+ * Compressed traces are read as described in trace_io.h.
+ *
+ * @date 2019
+ */
+
+#include "commands.h"
+#include "trace_io.h"
+
+#include <stdio.h>   // for FILE
+#include <stddef.h>  // for size_t
+#include <pthread.h>
+
+#define TRACE_CHUNK_SIZE   (1 << 20) // default number of bytes of a chunk (before extending it to a newline)
+#define TRACE_QUEUE_LENGTH 16        // default maximal number of chunks in flight
+
+/**
+ * @brief a chunk in flight
+ */
+typedef struct
+{
+    enum { SLOT_FREE, SLOT_PARSING, SLOT_READY } state;
+    size_t seq;        // number of the chunk in the file
+    char *text;        // the raw chunk
+    size_t length;     // number of bytes of the chunk
+    size_t capacity;   // allocated size of text
+    program_t program; // the parsed chunk
+    int err;           // error met when reading or parsing the chunk
+} trace_slot_t;
+
+/**
+ * @brief a parallel trace reader
+ */
+typedef struct
+{
+    trace_file_t file;
+    size_t chunk_size;
+    size_t queue_length;
+    trace_slot_t *slots;      // queue_length slots; chunk seq uses slot seq % queue_length
+    size_t nb_threads;
+    pthread_t *threads;
+    pthread_mutex_t lock;     // protects everything below, and reading the file
+    pthread_cond_t changed;   // signaled whenever a slot changes state
+    size_t next_read;         // number of the next chunk to read
+    size_t next_out;          // number of the next chunk to give to the consumer
+    int eof;                  // no more chunk to read
+    int closing;
+} trace_reader_t;
+
+//=========================================================================
+/**
+ * @brief Open a text trace and start its worker threads.
+ * @param reader (modified) the reader to initialize
+ * @param filename the trace to read
+ * @param nb_threads number of parsing threads (at least 1)
+ * @param chunk_size approximate number of bytes of a chunk (0 for TRACE_CHUNK_SIZE)
+ * @param queue_length maximal number of chunks in flight (0 for TRACE_QUEUE_LENGTH)
+ * @return error code
+ */
+int trace_reader_open(trace_reader_t *reader, const char *filename,
+                      size_t nb_threads, size_t chunk_size, size_t queue_length);
+
+//=========================================================================
+/**
+ * @brief Get the next chunk of commands, in file order, waiting for it to be parsed.
+ * @param reader the reader
+ * @param chunk (modified) the commands of the chunk, to be freed with program_free()
+ * @return error code, ERR_EOF after the last chunk
+ */
+int trace_reader_next(trace_reader_t *reader, program_t *chunk);
+
+//=========================================================================
+/**
+ * @brief Stop the worker threads, close the trace and free the reader.
+ * @param reader the reader
+ * @return error code
+ */
+int trace_reader_close(trace_reader_t *reader);
+
+//=========================================================================
+/**
+ * @brief Read a whole program from a text trace with several threads
+ *        (same result as program_read()).
+ * @param filename the trace to read
+ * @param program (modified) the program, to be freed with program_free()
+ * @param nb_threads number of parsing threads
+ * @return error code
+ */
+int program_read_parallel(const char *filename, program_t *program, size_t nb_threads);